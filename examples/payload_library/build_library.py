@@ -0,0 +1,120 @@
+#!/usr/bin/env python3
+"""
+Payload Library Image Builder for ttgo-fsk-tx
+
+Packs prebuilt payload files into the indexed image stored in the firmware's
+raw "payloads" flash partition. The device memory-maps the partition and
+streams entries to the radio without copying them into RAM.
+
+Image layout (little-endian):
+    header   magic "FSKL" (u32), version (u16), entry count (u16)
+    index    per entry: offset from image start (u32), length (u32)
+    data     payloads, each aligned to 4 bytes
+
+Flash the image with esptool at the partition offset from partitions.csv:
+    esptool.py write_flash 0x190000 library.bin
+"""
+
+from __future__ import annotations
+
+import argparse
+import logging
+import struct
+import sys
+from pathlib import Path
+from typing import List
+
+# Configuration constants (must match src/library.h and partitions.csv)
+LIBRARY_MAGIC = 0x4C4B5346  # "FSKL"
+LIBRARY_VERSION = 1
+HEADER_FORMAT = '<IHH'
+ENTRY_FORMAT = '<II'
+DATA_ALIGNMENT = 4
+PARTITION_OFFSET = 0x190000
+PARTITION_SIZE = 0x270000
+MAX_ENTRIES = 0xFFFF
+
+logging.basicConfig(
+    level=logging.INFO,
+    format='%(asctime)s - %(levelname)s - %(message)s',
+    datefmt='%Y-%m-%d %H:%M:%S'
+)
+logger = logging.getLogger(__name__)
+
+
+def build_image(payloads: List[bytes]) -> bytes:
+    """
+    Build a payload library image.
+
+    Args:
+        payloads: Payload contents, in entry index order
+
+    Returns:
+        The complete image, ready to be written to the partition
+
+    Raises:
+        ValueError: If there are too many entries or the image does not fit
+    """
+    if len(payloads) > MAX_ENTRIES:
+        raise ValueError(f"too many entries: {len(payloads)} (max {MAX_ENTRIES})")
+
+    header_size = struct.calcsize(HEADER_FORMAT) + len(payloads) * struct.calcsize(ENTRY_FORMAT)
+    offset = (header_size + DATA_ALIGNMENT - 1) & ~(DATA_ALIGNMENT - 1)
+
+    index = bytearray()
+    data = bytearray(offset - header_size)
+
+    for payload in payloads:
+        if not payload:
+            raise ValueError("empty payloads cannot be stored")
+
+        index += struct.pack(ENTRY_FORMAT, offset, len(payload))
+        padding = -len(payload) % DATA_ALIGNMENT
+        data += payload + bytes(padding)
+        offset += len(payload) + padding
+
+    image = struct.pack(HEADER_FORMAT, LIBRARY_MAGIC, LIBRARY_VERSION, len(payloads)) + index + data
+
+    if len(image) > PARTITION_SIZE:
+        raise ValueError(f"image size {len(image)} exceeds partition size {PARTITION_SIZE}")
+
+    return bytes(image)
+
+
+def main() -> None:
+    """
+    Main application entry point.
+
+    Reads the payload files given on the command line and writes the image.
+    """
+    parser = argparse.ArgumentParser(
+        description='Builds the flash payload library image for ttgo-fsk-tx.',
+        formatter_class=argparse.RawDescriptionHelpFormatter,
+        epilog=f"""
+Examples:
+  %(prog)s library.bin header.bin page1.bin page2.bin
+  esptool.py write_flash 0x{PARTITION_OFFSET:x} library.bin
+
+Entries are numbered in command line order, starting at 0.
+        """
+    )
+    parser.add_argument('output', type=Path, help='Path of the image to write')
+    parser.add_argument('payloads', type=Path, nargs='+', help='Payload files, in entry order')
+    args = parser.parse_args()
+
+    try:
+        payloads = [path.read_bytes() for path in args.payloads]
+        image = build_image(payloads)
+        args.output.write_bytes(image)
+    except (IOError, ValueError) as e:
+        logger.error(f"Failed to build library: {e}")
+        sys.exit(1)
+
+    for number, (path, payload) in enumerate(zip(args.payloads, payloads)):
+        logger.info(f"Entry {number}: {path} ({len(payload)} bytes)")
+
+    logger.info(f"Wrote {args.output}: {len(payloads)} entries, {len(image)} bytes")
+
+
+if __name__ == '__main__':
+    main()
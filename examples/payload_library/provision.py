@@ -0,0 +1,308 @@
+#!/usr/bin/env python3
+"""
+Payload Library Provisioning Script for ttgo-fsk-tx
+
+Uploads a payload library image (see build_library.py) into the device's
+"payloads" flash partition over the console, switching to a high baud rate
+for the transfer.
+
+Protocol:
+    u <baud> <offset> <size>   start provisioning; the device answers
+                               CONSOLE:0:Provisioning ... and switches baud
+    PROV:0:<verified> <limit> <committed>
+                               blocks below <verified> passed their CRC, blocks
+                               below <limit> may be sent, and flash up to
+                               partition offset <committed> is written and
+                               verified
+    PROV:1:<reason> at block N, K overruns, committed <offset>
+                               transfer aborted; resume from <offset>
+    PROV:0:Wrote ..., K overruns
+                               transfer complete, device returns to 115200;
+                               K counts UART receive overflows, lower the baud
+                               rate if it is not 0
+
+Each 4096-byte block (the last may be shorter) is followed by its CRC-32,
+little-endian. Resuming only rewrites the blocks from the given offset on.
+
+After an abort, a timeout or a lost port the script resumes by itself from
+the last committed offset, so only the blocks in flight are sent again. The
+committed offset is also saved next to the image (<image>.prov), so running
+the same command after the script itself was stopped continues where the
+device left off.
+"""
+
+from __future__ import annotations
+
+import argparse
+import json
+import logging
+import os
+import struct
+import sys
+import time
+import zlib
+from pathlib import Path
+
+import serial
+
+# Configuration constants (must match src/defaults.h)
+DEFAULT_BAUD = 115200
+PROVISION_BAUD = 921600
+BLOCK_SIZE = 4096
+RESPONSE_TIMEOUT = 10.0
+BAUD_SWITCH_DELAY = 0.05
+DEVICE_TIMEOUT = 2.0  # PROV_TIMEOUT_MS: the device gives up on a stalled transfer after this
+DEFAULT_RETRIES = 5
+
+logging.basicConfig(
+    level=logging.INFO,
+    format='%(asctime)s - %(levelname)s - %(message)s',
+    datefmt='%Y-%m-%d %H:%M:%S'
+)
+logger = logging.getLogger(__name__)
+
+
+def read_line(ser: serial.Serial, timeout: float) -> str:
+    """
+    Read the next non-empty line from the device.
+
+    Raises:
+        TimeoutError: If no line arrives within timeout
+    """
+    deadline = time.time() + timeout
+    while time.time() < deadline:
+        line = ser.readline().decode('utf-8', errors='replace').strip()
+        if line:
+            logger.debug(f"Received: {line}")
+            return line
+    raise TimeoutError(f'No response after {timeout} seconds')
+
+
+def expect_prefix(ser: serial.Serial, prefix: str, timeout: float) -> str:
+    """
+    Skip device output until a line starting with prefix arrives.
+
+    Raises:
+        RuntimeError: If the device reports an error on the console
+    """
+    while True:
+        line = read_line(ser, timeout)
+        if line.startswith('CONSOLE:') and not line.startswith('CONSOLE:0:'):
+            raise RuntimeError(f'Device error: {line}')
+        if line.startswith(prefix):
+            return line
+
+
+class ProvisionAborted(RuntimeError):
+    """The device aborted the transfer; committed is where to resume."""
+
+    def __init__(self, message: str, committed: int):
+        super().__init__(message)
+        self.committed = committed
+
+
+class Checkpoint:
+    """
+    Committed offset of an image, saved to <image>.prov after every
+    acknowledgement. It only applies to an image with the same CRC-32.
+    """
+
+    def __init__(self, image_path: Path, image: bytes):
+        self.path = Path(str(image_path) + '.prov')
+        self.crc = zlib.crc32(image)
+        self.size = len(image)
+        self.committed = 0
+
+    def load(self) -> int:
+        """Return the saved committed offset for this image, or 0."""
+        try:
+            saved = json.loads(self.path.read_text())
+        except (OSError, ValueError):
+            return 0
+        if saved.get('crc32') != self.crc or saved.get('size') != self.size:
+            return 0
+        return int(saved.get('committed', 0))
+
+    def update(self, committed: int) -> None:
+        if committed <= self.committed:
+            return
+        self.committed = committed
+        temp = Path(str(self.path) + '.tmp')
+        temp.write_text(json.dumps({'crc32': self.crc, 'size': self.size, 'committed': committed}))
+        os.replace(temp, self.path)
+
+    def clear(self) -> None:
+        self.path.unlink(missing_ok=True)
+
+
+def provision(ser: serial.Serial, image: bytes, offset: int, baud: int,
+              checkpoint: Checkpoint) -> None:
+    """
+    Send image[offset:] to the device partition at the same offset.
+
+    Raises:
+        ProvisionAborted: If the device aborts the transfer
+        TimeoutError: If the device stops responding
+    """
+    data = image[offset:]
+    blocks = (len(data) + BLOCK_SIZE - 1) // BLOCK_SIZE
+
+    ser.write(f'u {baud} {offset} {len(data)}\n'.encode('utf-8'))
+    expect_prefix(ser, 'CONSOLE:0:Provisioning', RESPONSE_TIMEOUT)
+
+    time.sleep(BAUD_SWITCH_DELAY)
+    ser.baudrate = baud
+
+    start = time.time()
+    next_block = 0
+    limit = 0
+
+    while True:
+        line = read_line(ser, RESPONSE_TIMEOUT)
+
+        if line.startswith('PROV:1:'):
+            reason, _, committed = line[7:].rpartition(', committed ')
+            checkpoint.update(int(committed))
+            raise ProvisionAborted(f'Provisioning aborted: {reason}', int(committed))
+
+        if line.startswith('PROV:0:Wrote'):
+            logger.info(f"Device: {line[7:]}")
+            break
+
+        if not line.startswith('PROV:0:'):
+            continue
+
+        verified, limit, committed = (int(value) for value in line[7:].split())
+        checkpoint.update(committed)
+        logger.debug(f"Verified {verified}/{blocks} blocks, window up to {limit}, committed {committed}")
+
+        while next_block < limit:
+            block = data[next_block * BLOCK_SIZE:(next_block + 1) * BLOCK_SIZE]
+            ser.write(block + struct.pack('<I', zlib.crc32(block)))
+            next_block += 1
+
+    elapsed = time.time() - start
+    logger.info(f"Sent {len(data)} bytes in {elapsed:.2f} s ({len(data) / elapsed / 1024:.1f} KiB/s)")
+
+    ser.baudrate = DEFAULT_BAUD
+    logger.info(f"Device: {expect_prefix(ser, 'CONSOLE:0:Provisioning complete', RESPONSE_TIMEOUT)}")
+
+
+def recover(ser: serial.Serial, port: str) -> serial.Serial:
+    """
+    Bring the link back to the console baud rate after a failed attempt.
+
+    The device drops back to DEFAULT_BAUD once it stops receiving. A newline
+    ends any partial command left on the console, and the console output is
+    drained before the next attempt. A port that has gone away is reopened.
+    """
+    try:
+        ser.baudrate = DEFAULT_BAUD
+        time.sleep(DEVICE_TIMEOUT + BAUD_SWITCH_DELAY)
+        ser.write(b'\n')
+        time.sleep(BAUD_SWITCH_DELAY)
+        ser.reset_input_buffer()
+        return ser
+    except (serial.SerialException, OSError) as e:
+        logger.warning(f"Serial port lost ({e}), reopening")
+        ser.close()
+
+    deadline = time.time() + RESPONSE_TIMEOUT
+    while True:
+        try:
+            ser = serial.Serial(port, DEFAULT_BAUD, timeout=1.0)
+            ser.reset_input_buffer()
+            return ser
+        except serial.SerialException:
+            if time.time() > deadline:
+                raise
+            time.sleep(0.5)
+
+
+def provision_with_resume(port: str, image: bytes, offset: int, baud: int,
+                          checkpoint: Checkpoint, retries: int) -> None:
+    """
+    Provision the image, resuming from the last committed offset after errors.
+
+    Raises:
+        RuntimeError: If the device keeps aborting
+        TimeoutError: If the device keeps failing to respond
+    """
+    checkpoint.committed = offset
+    ser = serial.Serial(port, DEFAULT_BAUD, timeout=1.0)
+    try:
+        ser.reset_input_buffer()
+        attempt = 0
+        while True:
+            try:
+                provision(ser, image, offset, baud, checkpoint)
+                checkpoint.clear()
+                return
+            except (ProvisionAborted, TimeoutError, serial.SerialException) as e:
+                attempt += 1
+                if attempt > retries:
+                    raise
+                # Committed flash survives resets, so only the window in flight is lost
+                offset = checkpoint.committed - checkpoint.committed % BLOCK_SIZE
+                logger.warning(f"{e}; resuming from offset {offset} ({attempt}/{retries})")
+                ser = recover(ser, port)
+    finally:
+        ser.close()
+
+
+def main() -> None:
+    """
+    Main application entry point.
+    """
+    parser = argparse.ArgumentParser(
+        description='Provisions the flash payload library of ttgo-fsk-tx.',
+        formatter_class=argparse.RawDescriptionHelpFormatter,
+        epilog="""
+Examples:
+  %(prog)s /dev/ttyUSB0 library.bin
+  %(prog)s /dev/ttyUSB0 library.bin -b 2000000
+  %(prog)s /dev/ttyUSB0 library.bin --offset 0
+        """
+    )
+    parser.add_argument('port', help='Serial port device (e.g., /dev/ttyUSB0, COM3)')
+    parser.add_argument('image', type=Path, help='Library image built by build_library.py')
+    parser.add_argument('-b', '--baud', type=int, default=PROVISION_BAUD, metavar='RATE',
+                        help=f'Baud rate for the transfer (default: {PROVISION_BAUD})')
+    parser.add_argument('--offset', type=int, metavar='BYTES',
+                        help=f'Start at this image offset (multiple of {BLOCK_SIZE}); '
+                             f'default: the saved checkpoint, or 0')
+    parser.add_argument('--retries', type=int, default=DEFAULT_RETRIES,
+                        help=f'Automatic resumes after errors (default: {DEFAULT_RETRIES})')
+    parser.add_argument('-v', '--verbose', action='store_true', help='Enable verbose logging')
+    args = parser.parse_args()
+
+    if args.offset is not None and args.offset % BLOCK_SIZE != 0:
+        parser.error(f'offset must be a multiple of {BLOCK_SIZE}')
+
+    if args.verbose:
+        logging.getLogger().setLevel(logging.DEBUG)
+
+    try:
+        image = args.image.read_bytes()
+        checkpoint = Checkpoint(args.image, image)
+
+        offset = args.offset
+        if offset is None:
+            offset = checkpoint.load()
+            offset -= offset % BLOCK_SIZE
+            if offset:
+                logger.info(f"Resuming from saved checkpoint at offset {offset}")
+        if offset >= len(image):
+            parser.error('offset is past the end of the image')
+
+        provision_with_resume(args.port, image, offset, args.baud, checkpoint, args.retries)
+    except KeyboardInterrupt:
+        logger.info("Operation cancelled by user")
+        sys.exit(130)
+    except (serial.SerialException, RuntimeError, TimeoutError, IOError) as e:
+        logger.error(f"Provisioning failed: {e}")
+        sys.exit(1)
+
+
+if __name__ == '__main__':
+    main()
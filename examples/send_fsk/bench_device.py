@@ -0,0 +1,165 @@
+#!/usr/bin/env python3
+"""
+On-Device Self-Benchmark Runner for ttgo-fsk-tx
+
+Runs the firmware's `b` command and prints its single BENCH response as JSON,
+so boards and firmware builds can be qualified in the field.
+
+Protocol:
+    b <on_air> <serial_bytes>
+        on_air        1 to send a short test packet at the current frequency
+                      and power, measuring FIFO interrupt to refill latency
+        serial_bytes  bytes the host streams for the ingestion rate test
+
+With --rtt N the runner also times N console round trips (a short unknown
+command answered with CONSOLE:9). --compare prints two saved result files
+side by side, for example the default build against the UART driver build.
+"""
+
+from __future__ import annotations
+
+import argparse
+import json
+import logging
+import os
+import sys
+import time
+from typing import Dict, List
+
+import serial
+
+from main import (DEFAULT_BAUD, DEFAULT_TIMEOUT, drain_startup, expect_console_success,
+                  read_response, send_command, validate_serial_port)
+
+DEFAULT_SERIAL_BYTES = 16384  # Serial ingestion test size
+RTT_COMMAND = 'z 0'  # Unknown command: parsed and answered, nothing else
+
+logger = logging.getLogger(__name__)
+
+
+def parse_bench(line: str) -> Dict[str, object]:
+    """Convert a BENCH:0:key=value,... line into a dictionary."""
+    results: Dict[str, object] = {}
+    for field in line.split(':', 2)[2].split(','):
+        key, value = field.split('=', 1)
+        results[key] = [int(v) for v in value.split('/')] if '/' in value else int(value)
+    return results
+
+
+def run_bench(ser: serial.Serial, on_air: bool, serial_bytes: int, timeout: float) -> Dict[str, object]:
+    """
+    Run the self-benchmark and return its parsed results.
+
+    Raises:
+        RuntimeError: If the device reports an error
+        TimeoutError: If the benchmark does not finish within timeout
+    """
+    send_command(ser, f'b {int(on_air)} {serial_bytes}')
+
+    if serial_bytes > 0:
+        expect_console_success(ser, f'Waiting for {serial_bytes} bytes', timeout)
+        ser.write(os.urandom(serial_bytes))
+        ser.flush()
+
+    while True:
+        line = read_response(ser, timeout)
+        if line is None:
+            raise TimeoutError(f'No benchmark result after {timeout} seconds')
+        if line.startswith('BENCH:0:'):
+            return parse_bench(line)
+        if line.startswith('BENCH:') or line.startswith('CONSOLE:9:'):
+            raise RuntimeError(f'Benchmark failed: {line}')
+
+
+def measure_rtt(ser: serial.Serial, count: int, timeout: float) -> Dict[str, object]:
+    """
+    Time console round trips: command written to error line read back.
+
+    Raises:
+        TimeoutError: If a reply does not arrive within timeout
+    """
+    samples: List[float] = []
+    for _ in range(count):
+        start = time.perf_counter()
+        send_command(ser, RTT_COMMAND)
+        while True:
+            line = read_response(ser, timeout)
+            if line is None:
+                raise TimeoutError(f'No reply to {RTT_COMMAND!r} after {timeout} seconds')
+            if line.startswith('CONSOLE:9:'):
+                break
+        samples.append((time.perf_counter() - start) * 1e6)
+
+    samples.sort()
+    return {
+        'rtt_avg_us': int(sum(samples) / len(samples)),
+        'rtt_p99_us': int(samples[min(len(samples) - 1, len(samples) * 99 // 100)]),
+        'rtt_max_us': int(samples[-1]),
+    }
+
+
+def compare(paths: List[str]) -> None:
+    """Print two result files side by side with the relative change."""
+    results = []
+    for path in paths:
+        with open(path) as f:
+            results.append(json.load(f))
+    a, b = results
+
+    width = max(len(key) for key in list(a) + list(b))
+    print(f"{'':{width}}  {os.path.basename(paths[0]):>14}  {os.path.basename(paths[1]):>14}  change")
+    for key in list(a) + [k for k in b if k not in a]:
+        left, right = a.get(key, '-'), b.get(key, '-')
+        change = ''
+        if isinstance(left, int) and isinstance(right, int) and left:
+            change = f'{(right - left) * 100 / left:+.1f}%'
+        print(f"{key:{width}}  {str(left):>14}  {str(right):>14}  {change}")
+
+
+def main() -> None:
+    """
+    Main application entry point.
+    """
+    parser = argparse.ArgumentParser(description='Runs the ttgo-fsk-tx on-device benchmark.')
+    parser.add_argument('port', nargs='?', help='Serial port device (e.g., /dev/ttyUSB0, COM3)')
+    parser.add_argument('-b', '--baud', type=int, default=DEFAULT_BAUD, help=f'Serial baud rate (default: {DEFAULT_BAUD})')
+    parser.add_argument('--on-air', action='store_true',
+                        help='Transmit a test packet to measure interrupt latency (check your licence)')
+    parser.add_argument('--serial-bytes', type=int, default=DEFAULT_SERIAL_BYTES,
+                        help=f'Bytes for the serial ingestion test, 0 to skip (default: {DEFAULT_SERIAL_BYTES})')
+    parser.add_argument('--rtt', type=int, default=0, metavar='N',
+                        help='Also time N console round trips (default: 0)')
+    parser.add_argument('--compare', nargs=2, metavar='JSON',
+                        help='Print two saved results side by side instead of running')
+    args = parser.parse_args()
+
+    logging.getLogger().setLevel(logging.WARNING)
+
+    if args.compare:
+        try:
+            compare(args.compare)
+        except (OSError, ValueError) as e:
+            logger.error(f"Compare failed: {e}")
+            sys.exit(1)
+        return
+    if args.port is None:
+        parser.error('port is required unless --compare is given')
+
+    try:
+        ser = validate_serial_port(args.port, args.baud)
+        try:
+            drain_startup(ser, timeout=0.5)
+            results = run_bench(ser, args.on_air, args.serial_bytes, DEFAULT_TIMEOUT)
+            if args.rtt > 0:
+                results.update(measure_rtt(ser, args.rtt, DEFAULT_TIMEOUT))
+        finally:
+            ser.close()
+    except (serial.SerialException, RuntimeError, TimeoutError) as e:
+        logger.error(f"Benchmark failed: {e}")
+        sys.exit(1)
+
+    print(json.dumps(results, indent=2))
+
+
+if __name__ == '__main__':
+    main()
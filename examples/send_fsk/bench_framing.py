@@ -0,0 +1,118 @@
+#!/usr/bin/env python3
+"""
+Hardware vs Software Framing Benchmark for ttgo-fsk-tx
+
+Compares preparing packets on the host (CRC and PN9 whitening computed in
+software, exactly as the SX127x packet engine would) with leaving both to the
+radio via the `h` command. The offline part times the host work and counts
+upload bytes; with --port it also measures upload-to-TX:0 latency on a device.
+
+The software framing here matches the SX127x: CRC-CCITT (init 0x1D0F, result
+inverted) or CRC-IBM (init 0xFFFF), transmitted MSB first, then PN9 whitening
+(x^9 + x^5 + 1, seed 0x1FF) over payload and CRC. It comes from codec.py, which
+uses the shared fsk_codec kernels when host/build/libfsk_codec_c.so is built.
+"""
+
+from __future__ import annotations
+
+import argparse
+import logging
+import os
+import time
+from typing import Dict, List, Optional
+
+from codec import frame
+from main import (DEFAULT_BAUD, DEFAULT_TIMEOUT, configure_device, drain_startup,
+                  expect_console_success, expect_tx_success, send_command, validate_serial_port)
+
+BENCH_SIZES = [16, 64, 255, 1024, 2045]  # Payload sizes; 2045 + 2 CRC bytes hits the framing limit
+OFFLINE_ROUNDS = 200  # Host-side repetitions per size
+UART_BITS_PER_BYTE = 10  # 8N1
+
+logger = logging.getLogger(__name__)
+
+
+def bench_offline(ibm: bool, whitening: bool, baud: int) -> List[Dict[str, float]]:
+    """Time software framing per size and estimate the upload cost of each mode."""
+    results = []
+    for size in BENCH_SIZES:
+        payload = os.urandom(size)
+        start = time.perf_counter()
+        for _ in range(OFFLINE_ROUNDS):
+            framed = frame(payload, 'ibm' if ibm else 'ccitt', whitening)
+        prep_us = (time.perf_counter() - start) / OFFLINE_ROUNDS * 1e6
+
+        results.append({
+            'size': size,
+            'sw_prep_us': prep_us,
+            'sw_upload_bytes': len(framed),
+            'hw_upload_bytes': size,
+            'sw_upload_ms': len(framed) * UART_BITS_PER_BYTE / baud * 1000,
+            'hw_upload_ms': size * UART_BITS_PER_BYTE / baud * 1000,
+        })
+    return results
+
+
+def timed_transmit(ser, data: bytes, timeout: float) -> float:
+    """Upload data with `m` and return seconds from command to TX:0."""
+    start = time.perf_counter()
+    send_command(ser, f'm {len(data)}')
+    expect_console_success(ser, f'Waiting for {len(data)} bytes', timeout)
+    ser.write(data)
+    ser.flush()
+    expect_console_success(ser, f'Accepted {len(data)} bytes', timeout)
+    expect_tx_success(ser, timeout)
+    return time.perf_counter() - start
+
+
+def bench_device(port: str, baud: int, crc: str, ibm: bool, whitening: bool,
+                 size: int, rounds: int) -> Dict[str, float]:
+    """Measure end-to-end latency on a device for both framing modes."""
+    ser = validate_serial_port(port, baud)
+    try:
+        drain_startup(ser, timeout=0.5)
+        payload = os.urandom(size)
+
+        configure_device(ser, None, None, DEFAULT_TIMEOUT, 'off', False)
+        framed = frame(payload, 'ibm' if ibm else 'ccitt', whitening)
+        software = [timed_transmit(ser, framed, DEFAULT_TIMEOUT) for _ in range(rounds)]
+
+        configure_device(ser, None, None, DEFAULT_TIMEOUT, crc, whitening)
+        hardware = [timed_transmit(ser, payload, DEFAULT_TIMEOUT) for _ in range(rounds)]
+
+        configure_device(ser, None, None, DEFAULT_TIMEOUT, 'off', False)
+    finally:
+        ser.close()
+
+    return {'software_ms': sum(software) / rounds * 1000, 'hardware_ms': sum(hardware) / rounds * 1000}
+
+
+def main() -> None:
+    """
+    Main application entry point.
+    """
+    parser = argparse.ArgumentParser(description='Benchmarks hardware against software packet framing.')
+    parser.add_argument('--crc', choices=['ccitt', 'ibm'], default='ccitt', help='CRC flavour (default: ccitt)')
+    parser.add_argument('--whitening', action='store_true', help='Include PN9 whitening')
+    parser.add_argument('-b', '--baud', type=int, default=DEFAULT_BAUD, help=f'Serial baud rate (default: {DEFAULT_BAUD})')
+    parser.add_argument('--port', help='Also measure end-to-end latency on the device at this port')
+    parser.add_argument('--size', type=int, default=255, help='Payload size for the device run (default: 255)')
+    parser.add_argument('--rounds', type=int, default=5, help='Transmissions per mode on the device (default: 5)')
+    args = parser.parse_args()
+
+    logging.getLogger().setLevel(logging.WARNING)
+    ibm = args.crc == 'ibm'
+
+    print(f"{'size':>6} {'sw prep us':>11} {'sw bytes':>9} {'hw bytes':>9} {'sw upload ms':>13} {'hw upload ms':>13}")
+    for row in bench_offline(ibm, args.whitening, args.baud):
+        print(f"{row['size']:>6} {row['sw_prep_us']:>11.1f} {row['sw_upload_bytes']:>9} {row['hw_upload_bytes']:>9} "
+              f"{row['sw_upload_ms']:>13.2f} {row['hw_upload_ms']:>13.2f}")
+
+    if args.port:
+        result = bench_device(args.port, args.baud, args.crc, ibm, args.whitening, args.size, args.rounds)
+        print(f"device, {args.size} bytes: software framing {result['software_ms']:.1f} ms, "
+              f"hardware framing {result['hardware_ms']:.1f} ms (command to TX:0)")
+
+
+if __name__ == '__main__':
+    main()
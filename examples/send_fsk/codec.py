@@ -0,0 +1,219 @@
+"""
+Python Binding for the fsk_codec Encoder Kernels
+
+Loads the C API of the shared encoder library (lib/fsk_codec, built as
+host/build/libfsk_codec_c.so) through ctypes, so host tools frame packets with
+the same code as the firmware. Set TTGO_FSK_CODEC to the library path to use
+another build. Without the library, pure-Python versions of the kernels are
+used; selfcheck() compares both and the golden vectors.
+
+Bit order is MSB first throughout, as the SX127x shifts bytes out.
+"""
+
+from __future__ import annotations
+
+import ctypes
+import os
+import struct
+from pathlib import Path
+from typing import List, Optional, Sequence
+
+PN9_PERIOD = 511
+BCH_POLY = 0x769  # x^10 + x^9 + x^8 + x^6 + x^5 + x^3 + 1
+CRC_PARAMS = {'ccitt': (0x1021, 0x1D0F, 0xFFFF), 'ibm': (0x8005, 0xFFFF, 0x0000)}  # poly, init, final XOR
+
+DEFAULT_LIBRARY = Path(__file__).resolve().parents[2] / 'host' / 'build' / 'libfsk_codec_c.so'
+
+
+def _load() -> Optional[ctypes.CDLL]:
+    path = os.environ.get('TTGO_FSK_CODEC', str(DEFAULT_LIBRARY))
+    try:
+        lib = ctypes.CDLL(path)
+    except OSError:
+        return None
+
+    lib.fsk_codec_crc16.restype = ctypes.c_uint16
+    lib.fsk_codec_crc16.argtypes = [ctypes.c_char_p, ctypes.c_size_t, ctypes.c_int]
+    lib.fsk_codec_pn9_apply.restype = None
+    lib.fsk_codec_pn9_apply.argtypes = [ctypes.c_void_p, ctypes.c_size_t, ctypes.c_size_t]
+    lib.fsk_codec_bch3121_encode.restype = ctypes.c_uint32
+    lib.fsk_codec_bch3121_encode.argtypes = [ctypes.c_uint32]
+    lib.fsk_codec_interleave8.restype = None
+    lib.fsk_codec_interleave8.argtypes = [ctypes.c_void_p, ctypes.c_size_t, ctypes.c_void_p]
+    lib.fsk_codec_manchester_encode.restype = None
+    lib.fsk_codec_manchester_encode.argtypes = [ctypes.c_char_p, ctypes.c_size_t, ctypes.c_void_p]
+    lib.fsk_codec_selftest.restype = ctypes.c_int
+    return lib
+
+
+_lib = _load()
+NATIVE = _lib is not None  # True when the compiled kernels are in use
+
+
+def py_crc16(data: bytes, ibm: bool) -> int:
+    """Compute the SX127x packet CRC of data (pure Python)."""
+    poly, crc, final = CRC_PARAMS['ibm' if ibm else 'ccitt']
+    for byte in data:
+        crc ^= byte << 8
+        for _ in range(8):
+            crc = ((crc << 1) ^ poly) & 0xFFFF if crc & 0x8000 else (crc << 1) & 0xFFFF
+    return crc ^ final
+
+
+def py_pn9_whiten(data: bytes, offset: int = 0) -> bytes:
+    """Apply SX127x PN9 data whitening to data starting `offset` bytes into the packet (pure Python)."""
+    lfsr = 0x1FF
+    for _ in range((offset % PN9_PERIOD) * 8):
+        lfsr = (lfsr >> 1) | ((((lfsr >> 5) ^ lfsr) & 1) << 8)
+    out = bytearray(len(data))
+    for index, byte in enumerate(data):
+        out[index] = byte ^ (lfsr & 0xFF)
+        for _ in range(8):
+            lfsr = (lfsr >> 1) | ((((lfsr >> 5) ^ lfsr) & 1) << 8)
+    return bytes(out)
+
+
+def py_bch3121_encode(data: int) -> int:
+    """Encode 21 data bits into a 32-bit codeword with BCH check bits and even parity (pure Python)."""
+    word = (data & 0x1FFFFF) << 10
+    remainder = word
+    for bit in range(30, 9, -1):
+        if remainder >> bit & 1:
+            remainder ^= BCH_POLY << (bit - 10)
+    word = (word | remainder) << 1
+    return word | (bin(word).count('1') & 1)
+
+
+def py_interleave8(words: Sequence[int]) -> bytes:
+    """Interleave blocks of 8 codewords bit by bit, bit 31 of every word first (pure Python)."""
+    out = bytearray()
+    for block in range(0, len(words), 8):
+        group = words[block:block + 8]
+        for bit in range(31, -1, -1):
+            byte = 0
+            for word in group:
+                byte = (byte << 1) | (word >> bit & 1)
+            out.append(byte)
+    return bytes(out)
+
+
+def py_manchester_encode(data: bytes) -> bytes:
+    """Manchester encode data, 0 as 10 and 1 as 01 (pure Python)."""
+    out = bytearray()
+    for byte in data:
+        code = 0
+        for bit in range(7, -1, -1):
+            code = (code << 2) | (0b01 if byte >> bit & 1 else 0b10)
+        out += code.to_bytes(2, 'big')
+    return bytes(out)
+
+
+def crc16(data: bytes, ibm: bool) -> int:
+    """Compute the SX127x packet CRC of data."""
+    if _lib is None:
+        return py_crc16(data, ibm)
+    return _lib.fsk_codec_crc16(bytes(data), len(data), int(ibm))
+
+
+def pn9_whiten(data: bytes, offset: int = 0) -> bytes:
+    """Apply SX127x PN9 data whitening to data starting `offset` bytes into the packet."""
+    if _lib is None:
+        return py_pn9_whiten(data, offset)
+    buffer = ctypes.create_string_buffer(bytes(data), len(data))
+    _lib.fsk_codec_pn9_apply(buffer, len(data), offset)
+    return buffer.raw
+
+
+def bch3121_encode(data: int) -> int:
+    """Encode 21 data bits into a 32-bit BCH(31,21) codeword with even parity."""
+    if _lib is None:
+        return py_bch3121_encode(data)
+    return _lib.fsk_codec_bch3121_encode(data)
+
+
+def interleave8(words: Sequence[int]) -> bytes:
+    """Interleave blocks of 8 codewords bit by bit; len(words) must be a multiple of 8."""
+    if len(words) % 8:
+        raise ValueError('interleave8 takes whole blocks of 8 codewords')
+    if _lib is None:
+        return py_interleave8(words)
+    packed = struct.pack(f'<{len(words)}I', *words)
+    out = ctypes.create_string_buffer(len(words) * 4)
+    _lib.fsk_codec_interleave8(packed, len(words) // 8, out)
+    return out.raw
+
+
+def manchester_encode(data: bytes) -> bytes:
+    """Manchester encode data, 0 as 10 and 1 as 01."""
+    if _lib is None:
+        return py_manchester_encode(data)
+    out = ctypes.create_string_buffer(len(data) * 2)
+    _lib.fsk_codec_manchester_encode(bytes(data), len(data), out)
+    return out.raw
+
+
+def frame(payload: bytes, crc: Optional[str], whitening: bool) -> bytes:
+    """
+    Build the on-air bytes of the SX127x packet engine in software.
+
+    Args:
+        payload: Packet payload
+        crc: 'ccitt', 'ibm' or None to append no CRC
+        whitening: Apply PN9 whitening over payload and CRC
+
+    Returns:
+        Payload with the CRC appended MSB first, whitened if requested
+    """
+    framed = bytes(payload)
+    if crc is not None:
+        value = crc16(framed, crc == 'ibm')
+        framed += bytes([value >> 8, value & 0xFF])
+    return pn9_whiten(framed) if whitening else framed
+
+
+def selfcheck() -> List[str]:
+    """
+    Check the kernels against the golden vectors and, with the native library,
+    against the pure-Python versions.
+
+    Returns:
+        Descriptions of any mismatches; empty if all agree
+    """
+    failures = []
+    check = b'123456789'
+
+    if crc16(check, False) != 0x1A33 or crc16(check, True) != 0xAEE7:
+        failures.append('crc16 golden vector')
+    if pn9_whiten(bytes(8)) != bytes.fromhex('FFE11D9AED853324'):
+        failures.append('pn9 golden vector')
+    if bch3121_encode(0x7A89C197 >> 11) != 0x7A89C197 or bch3121_encode(0x7CD215D8 >> 11) != 0x7CD215D8:
+        failures.append('bch3121 golden vector')
+    if manchester_encode(b'\x00\xff\xa5\x3c') != bytes.fromhex('AAAA55556699A55A'):
+        failures.append('manchester golden vector')
+
+    if _lib is not None:
+        if _lib.fsk_codec_selftest() != 0:
+            failures.append('native selftest')
+
+        data = os.urandom(1000)
+        words = [bch3121_encode(int.from_bytes(os.urandom(3), 'big')) for _ in range(64)]
+        for ibm in (False, True):
+            if crc16(data, ibm) != py_crc16(data, ibm):
+                failures.append(f'crc16 native/python ({"ibm" if ibm else "ccitt"})')
+        if pn9_whiten(data, 37) != py_pn9_whiten(data, 37):
+            failures.append('pn9 native/python')
+        if interleave8(words) != py_interleave8(words):
+            failures.append('interleave8 native/python')
+        if manchester_encode(data) != py_manchester_encode(data):
+            failures.append('manchester native/python')
+        if any(bch3121_encode(w >> 11) != py_bch3121_encode(w >> 11) for w in words):
+            failures.append('bch3121 native/python')
+
+    return failures
+
+
+if __name__ == '__main__':
+    problems = selfcheck()
+    print(f"fsk_codec ({'native' if NATIVE else 'pure Python'}): "
+          f"{'OK' if not problems else 'FAILED: ' + ', '.join(problems)}")
+    raise SystemExit(1 if problems else 0)
@@ -0,0 +1,142 @@
+#!/usr/bin/env python3
+"""
+Transmission History Reader for ttgo-fsk-tx
+
+Pages through the firmware's per-transmission history ring with the `o`
+command and prints the records as a table or JSON, so a slow or failed
+message can be looked at after the fact.
+
+Protocol:
+    o <from> <count>
+        from   sequence number of the first record; negative counts back
+               from the newest
+        count  records to list, at most 64 per command
+
+Each record comes back as one HIST:0: line of comma-separated fields (see
+HISTORY_FIELDS), followed by
+CONSOLE:0:Listed <n> records, next <seq>, uptime_ms <ms>.
+"""
+
+from __future__ import annotations
+
+import argparse
+import json
+import logging
+import re
+import sys
+from typing import Dict, List, Tuple
+
+import serial
+
+from main import DEFAULT_BAUD, DEFAULT_TIMEOUT, drain_startup, read_response, send_command, validate_serial_port
+
+HISTORY_FIELDS = ('seq', 'time_ms', 'id', 'length', 'frequency_khz', 'power', 'upload_us', 'queue_us',
+                  'first_bit_us', 'airtime_ms', 'underruns', 'result')
+PAGE_SIZE = 64  # HISTORY_PAGE_MAX in defaults.h
+HISTORY_ENTRIES = 256  # records the device keeps
+
+LISTED_PATTERN = re.compile(r'CONSOLE:0:Listed (\d+) records, next (\d+), uptime_ms (\d+)')
+
+logger = logging.getLogger(__name__)
+
+
+def read_page(ser: serial.Serial, start: int, count: int, timeout: float) -> Tuple[List[Dict[str, int]], int, int]:
+    """
+    List up to count records from sequence number start.
+
+    Returns:
+        The records, the sequence number to continue from, and the device uptime in ms
+
+    Raises:
+        RuntimeError: If the device rejects the command
+        TimeoutError: If the listing does not finish within timeout
+    """
+    send_command(ser, f'o {start} {count}')
+    records: List[Dict[str, int]] = []
+
+    while True:
+        line = read_response(ser, timeout)
+        if line is None:
+            raise TimeoutError(f'No history listing after {timeout} seconds')
+        if line.startswith('HIST:0:'):
+            values = [int(v) for v in line[len('HIST:0:'):].split(',')]
+            records.append(dict(zip(HISTORY_FIELDS, values)))
+            continue
+        match = LISTED_PATTERN.match(line)
+        if match:
+            return records, int(match.group(2)), int(match.group(3))
+        if line.startswith('CONSOLE:'):
+            raise RuntimeError(f'History listing failed: {line}')
+
+
+def read_history(ser: serial.Serial, last: int, timeout: float) -> Tuple[List[Dict[str, int]], int]:
+    """Read the newest `last` records, oldest first, page by page."""
+    records, start, uptime_ms = read_page(ser, -last, PAGE_SIZE, timeout)
+
+    while len(records) < last:
+        page, start, uptime_ms = read_page(ser, start, min(PAGE_SIZE, last - len(records)), timeout)
+        if not page:
+            break
+        records.extend(page)
+
+    return records, uptime_ms
+
+
+def print_table(records: List[Dict[str, int]], uptime_ms: int) -> None:
+    """One row per record; age is seconds before the listing."""
+    header = f"{'seq':>6} {'age_s':>8} {'id':>10} {'bytes':>7} {'MHz':>9} {'dBm':>3} " \
+             f"{'upload_ms':>9} {'queue_ms':>8} {'first_us':>8} {'air_ms':>8} {'under':>5} {'res':>3}"
+    print(header)
+    for r in records:
+        print(f"{r['seq']:>6} {(uptime_ms - r['time_ms']) / 1000:>8.1f} {r['id']:>10} {r['length']:>7} "
+              f"{r['frequency_khz'] / 1000:>9.3f} {r['power']:>3} {r['upload_us'] / 1000:>9.1f} "
+              f"{r['queue_us'] / 1000:>8.1f} {r['first_bit_us']:>8} {r['airtime_ms']:>8} "
+              f"{r['underruns']:>5} {r['result']:>3}")
+
+
+def total_ms(record: Dict[str, int]) -> float:
+    """Command to TX result, in milliseconds."""
+    return (record['upload_us'] + record['queue_us']) / 1000 + record['airtime_ms']
+
+
+def main() -> None:
+    """
+    Main application entry point.
+    """
+    parser = argparse.ArgumentParser(description='Reads the ttgo-fsk-tx transmission history.')
+    parser.add_argument('port', help='Serial port device (e.g., /dev/ttyUSB0, COM3)')
+    parser.add_argument('-b', '--baud', type=int, default=DEFAULT_BAUD, help=f'Serial baud rate (default: {DEFAULT_BAUD})')
+    parser.add_argument('-n', '--last', type=int, default=HISTORY_ENTRIES,
+                        help=f'Newest records to read (default: {HISTORY_ENTRIES}, the whole ring)')
+    parser.add_argument('--slowest', type=int, default=0, metavar='K',
+                        help='Only show the K records with the longest command-to-result time')
+    parser.add_argument('--json', action='store_true', help='Print JSON instead of a table')
+    args = parser.parse_args()
+
+    if args.last < 1:
+        parser.error('--last must be at least 1')
+
+    logging.getLogger().setLevel(logging.WARNING)
+
+    try:
+        ser = validate_serial_port(args.port, args.baud)
+        try:
+            drain_startup(ser, timeout=0.5)
+            records, uptime_ms = read_history(ser, args.last, DEFAULT_TIMEOUT)
+        finally:
+            ser.close()
+    except (serial.SerialException, RuntimeError, TimeoutError) as e:
+        logger.error(f"History read failed: {e}")
+        sys.exit(1)
+
+    if args.slowest > 0:
+        records = sorted(records, key=total_ms, reverse=True)[:args.slowest]
+
+    if args.json:
+        print(json.dumps({'uptime_ms': uptime_ms, 'records': records}, indent=2))
+    else:
+        print_table(records, uptime_ms)
+
+
+if __name__ == '__main__':
+    main()
@@ -0,0 +1,295 @@
+#!/usr/bin/env python3
+"""
+Transmission Job Files for ttgo-fsk-tx
+
+A job file bundles many transmissions for one serial session: the radio
+settings, an index of payloads with schedule times, priorities and
+idempotency keys, and the payloads themselves. send_job.py memory-maps it
+and streams the payloads to the device, so jobs of any size are sent without
+loading them into memory.
+
+Layout (little-endian):
+    header   48 bytes   magic 'TTGOJOB1', version, flags, entry count,
+                        16-byte job ID, frequency (MHz), power (dBm),
+                        CRC mode, whitening, blob offset
+    index    32 bytes   per entry: blob offset, schedule time (Unix ms,
+                        0 = as soon as possible), length, key (device
+                        message ID, 0 = none), priority (higher first)
+    blob                payloads, back to back
+
+Flags mark which radio settings the header carries; settings without their
+flag are left as the device has them.
+
+Usage:
+    jobfile.py build job.ttj manifest.json
+    jobfile.py show job.ttj
+"""
+
+from __future__ import annotations
+
+import argparse
+import json
+import mmap
+import os
+import shutil
+import struct
+import sys
+import uuid
+from dataclasses import dataclass
+from datetime import datetime
+from pathlib import Path
+from typing import List, Optional, Union
+
+from main import CRC_MODES, MAX_CHUNK, MAX_POWER, MIN_POWER
+
+MAGIC = b'TTGOJOB1'
+VERSION = 1
+HEADER = struct.Struct('<8sHHI16sfbBBxQ')
+ENTRY = struct.Struct('<QQIIB7x')
+
+FLAG_FREQUENCY = 0x01  # Header frequency is set
+FLAG_POWER = 0x02  # Header power is set
+FLAG_FRAMING = 0x04  # Header CRC mode and whitening are set
+
+COPY_CHUNK = 1 << 20  # Bytes copied at a time when building the blob
+
+
+@dataclass
+class JobSettings:
+    """Radio settings applied once at the start of a job; None keeps the device's."""
+    frequency: Optional[float] = None
+    power: Optional[int] = None
+    crc: Optional[str] = None
+    whitening: bool = False
+
+
+@dataclass
+class JobEntry:
+    """One transmission of a job."""
+    index: int
+    offset: int  # Within the blob
+    length: int
+    schedule_ms: int = 0
+    key: int = 0
+    priority: int = 0
+
+
+class JobFile:
+    """
+    Read-only, memory-mapped view of a job file.
+
+    Payloads are returned as memoryview slices of the mapping, so only the
+    pages being sent are read from disk.
+    """
+
+    def __init__(self, path: Union[str, Path]):
+        self.path = Path(path)
+        self._file = open(self.path, 'rb')
+        try:
+            size = os.fstat(self._file.fileno()).st_size
+            if size < HEADER.size:
+                raise ValueError(f"{self.path}: too short for a job file")
+            self._map = mmap.mmap(self._file.fileno(), 0, access=mmap.ACCESS_READ)
+        except Exception:
+            self._file.close()
+            raise
+        self._view = memoryview(self._map)
+
+        try:
+            self._parse(size)
+        except Exception:
+            self.close()
+            raise
+
+    def _parse(self, size: int) -> None:
+        (magic, version, flags, count, job_id, frequency, power, crc, whitening,
+         blob_offset) = HEADER.unpack_from(self._map, 0)
+
+        if magic != MAGIC:
+            raise ValueError(f"{self.path}: not a job file")
+        if version != VERSION:
+            raise ValueError(f"{self.path}: unsupported job file version {version}")
+        if blob_offset != HEADER.size + count * ENTRY.size or blob_offset > size:
+            raise ValueError(f"{self.path}: index does not match the file size")
+
+        crc_names = {value: name for name, value in CRC_MODES.items()}
+        if flags & FLAG_FRAMING and crc not in crc_names:
+            raise ValueError(f"{self.path}: unknown CRC mode {crc}")
+        if flags & FLAG_POWER and not MIN_POWER <= power <= MAX_POWER:
+            raise ValueError(f"{self.path}: power {power} dBm out of range")
+
+        self.job_id = job_id.hex()
+        self.settings = JobSettings(
+            frequency=round(frequency, 4) if flags & FLAG_FREQUENCY else None,
+            power=power if flags & FLAG_POWER else None,
+            crc=crc_names[crc] if flags & FLAG_FRAMING else None,
+            whitening=bool(whitening) if flags & FLAG_FRAMING else False,
+        )
+        self._blob_offset = blob_offset
+        blob_size = size - blob_offset
+
+        self.entries: List[JobEntry] = []
+        for index in range(count):
+            offset, schedule_ms, length, key, priority = ENTRY.unpack_from(
+                self._map, HEADER.size + index * ENTRY.size)
+            if not 1 <= length <= MAX_CHUNK or offset + length > blob_size:
+                raise ValueError(f"{self.path}: entry {index} has an invalid payload range")
+            self.entries.append(JobEntry(index, offset, length, schedule_ms, key, priority))
+
+    def payload(self, entry: JobEntry) -> memoryview:
+        """Return an entry's payload as a view into the mapping."""
+        start = self._blob_offset + entry.offset
+        return self._view[start:start + entry.length]
+
+    def close(self) -> None:
+        self._view.release()
+        self._map.close()
+        self._file.close()
+
+    def __enter__(self) -> JobFile:
+        return self
+
+    def __exit__(self, *exc) -> None:
+        self.close()
+
+
+def write_job(path: Union[str, Path], settings: JobSettings, entries: List[dict]) -> str:
+    """
+    Write a job file, copying payloads from their source files in chunks.
+
+    Args:
+        path: Job file to create
+        settings: Radio settings for the job
+        entries: Dicts with 'file' (or 'hex'), and optional 'at' (Unix seconds or
+            ISO 8601 time), 'priority' (0-255) and 'key' (1-4294967295, 0 for none)
+
+    Returns:
+        The job ID, as hex
+
+    Raises:
+        ValueError: If an entry or setting is invalid
+    """
+    flags = 0
+    if settings.frequency is not None:
+        flags |= FLAG_FREQUENCY
+    if settings.power is not None:
+        if not MIN_POWER <= settings.power <= MAX_POWER:
+            raise ValueError(f"power must be between {MIN_POWER} and {MAX_POWER} dBm")
+        flags |= FLAG_POWER
+    if settings.crc is not None:
+        flags |= FLAG_FRAMING
+
+    sources = []
+    index = bytearray()
+    offset = 0
+    keys = set()
+    for number, entry in enumerate(entries):
+        if 'hex' in entry:
+            source: Union[bytes, Path] = bytes.fromhex(entry['hex'])
+            length = len(source)
+        else:
+            source = Path(entry['file'])
+            length = source.stat().st_size
+        if not 1 <= length <= MAX_CHUNK:
+            raise ValueError(f"entry {number}: payload of {length} bytes, must be 1 to {MAX_CHUNK}")
+
+        key = int(entry.get('key', 0))
+        if not 0 <= key <= 0xFFFFFFFF:
+            raise ValueError(f"entry {number}: key must be between 1 and 4294967295, or 0 for none")
+        if key and key in keys:
+            raise ValueError(f"entry {number}: duplicate key {key}")
+        keys.add(key)
+
+        priority = int(entry.get('priority', 0))
+        if not 0 <= priority <= 255:
+            raise ValueError(f"entry {number}: priority must be between 0 and 255")
+
+        index += ENTRY.pack(offset, parse_schedule(entry.get('at')), length, key, priority)
+        sources.append(source)
+        offset += length
+
+    job_id = uuid.uuid4().bytes
+    header = HEADER.pack(MAGIC, VERSION, flags, len(sources), job_id,
+                         settings.frequency or 0.0, settings.power or 0,
+                         CRC_MODES.get(settings.crc, 0), int(settings.whitening),
+                         HEADER.size + len(index))
+
+    temp = Path(str(path) + '.tmp')
+    with open(temp, 'wb') as out:
+        out.write(header)
+        out.write(index)
+        for source in sources:
+            if isinstance(source, bytes):
+                out.write(source)
+            else:
+                with open(source, 'rb') as f:
+                    shutil.copyfileobj(f, out, COPY_CHUNK)
+        out.flush()
+        os.fsync(out.fileno())
+    os.replace(temp, path)
+
+    return job_id.hex()
+
+
+def parse_schedule(value: Union[None, int, float, str]) -> int:
+    """Convert Unix seconds or an ISO 8601 time to Unix milliseconds; None is 0 (unscheduled)."""
+    if value is None:
+        return 0
+    if isinstance(value, (int, float)):
+        return int(value * 1000)
+    return int(datetime.fromisoformat(value).timestamp() * 1000)
+
+
+def build(args: argparse.Namespace) -> None:
+    manifest_path = Path(args.manifest)
+    with open(manifest_path) as f:
+        manifest = json.load(f)
+
+    if manifest.get('crc') is not None and manifest['crc'] not in CRC_MODES:
+        raise ValueError(f"crc must be one of {', '.join(CRC_MODES)}")
+    settings = JobSettings(manifest.get('frequency'), manifest.get('power'),
+                           manifest.get('crc'), bool(manifest.get('whitening', False)))
+
+    # Payload files are relative to the manifest
+    entries = []
+    for entry in manifest['entries']:
+        entry = dict(entry)
+        if 'file' in entry:
+            entry['file'] = manifest_path.parent / entry['file']
+        entries.append(entry)
+
+    job_id = write_job(args.job, settings, entries)
+    print(f"{args.job}: job {job_id}, {len(entries)} entries")
+
+
+def show(args: argparse.Namespace) -> None:
+    with JobFile(args.job) as job:
+        print(f"job {job.job_id}: {len(job.entries)} entries, {job.settings}")
+        for entry in job.entries:
+            at = datetime.fromtimestamp(entry.schedule_ms / 1000).isoformat() if entry.schedule_ms else '-'
+            print(f"{entry.index:6d}  {entry.length:5d} bytes  at {at}  priority {entry.priority}  key {entry.key or '-'}")
+
+
+def main() -> None:
+    parser = argparse.ArgumentParser(description='Builds and inspects ttgo-fsk-tx job files.')
+    commands = parser.add_subparsers(dest='command', required=True)
+
+    build_parser = commands.add_parser('build', help='Build a job file from a JSON manifest')
+    build_parser.add_argument('job', help='Job file to write')
+    build_parser.add_argument('manifest', help='JSON manifest: frequency, power, crc, whitening and entries')
+    build_parser.set_defaults(func=build)
+
+    show_parser = commands.add_parser('show', help='List the settings and entries of a job file')
+    show_parser.add_argument('job', help='Job file to read')
+    show_parser.set_defaults(func=show)
+
+    args = parser.parse_args()
+    try:
+        args.func(args)
+    except (OSError, ValueError, KeyError) as e:
+        print(f"error: {e}", file=sys.stderr)
+        sys.exit(1)
+
+
+if __name__ == '__main__':
+    main()
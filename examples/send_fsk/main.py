@@ -11,20 +11,33 @@ Protocol:
     Commands:
         f <freq>   - Set frequency in MHz
         p <power>  - Set transmit power in dBm (2-17)
-        m <length> - Transmit binary data of specified length
+        h <crc> <whitening> - Hardware CRC (0=off, 1=CCITT, 2=IBM) and whitening
+        m <length> [id] - Transmit binary data of specified length, optionally
+                          tagged with a message ID so a retry after a reset
+                          is answered with the original result
+        d <length> <base_length> <base_crc32> <delta_bytes> [id]
+                        - Transmit a payload sent as changed ranges against
+                          the previous payload still on the device
+        k <ms>     - Print an HB:0: heartbeat line every <ms> milliseconds
+                     (0 = off), also while transmitting
 """
 
 from __future__ import annotations
 
 import argparse
 import logging
+import struct
 import sys
 import time
+import zlib
+from dataclasses import dataclass
 from pathlib import Path
-from typing import List, Optional, Union
+from typing import Dict, List, Optional, Tuple, Union
 
 import serial
 
+from pipeline import Pipeline, PipelineOptions
+
 # Configuration constants
 MAX_CHUNK = 2048  # Maximum bytes per transmission (console.cpp limit)
 DEFAULT_BAUD = 115200  # Default serial baud rate (matches defaults.h)
@@ -35,6 +48,14 @@ SERIAL_READ_TIMEOUT = 1.0  # Serial port read timeout
 DEVICE_RESET_DELAY = 2.0  # Delay after device reset
 DTR_TOGGLE_DELAY = 0.1  # DTR toggle delay for reset
 POLL_INTERVAL = 0.01  # Polling interval for non-blocking reads
+WAKE_DELAY = 0.005  # Time for the device to leave light sleep after a wake newline
+PREFETCH_DEPTH = 2  # Files queued between pipeline stages
+CRC_MODES = {'off': 0, 'ccitt': 1, 'ibm': 2}  # Hardware CRC modes (framing.h)
+DELTA_RECORD = struct.Struct('<HH')  # Delta record header: offset, length (console.cpp)
+HEARTBEAT_PREFIX = 'HB:'  # Heartbeat lines (heartbeat.cpp), never a response
+HEARTBEAT_MIN_MS = 10  # Heartbeat interval limits (defaults.h)
+HEARTBEAT_MAX_MS = 60000
+HEARTBEAT_MISSED_LIMIT = 3  # Heartbeat intervals without a line before the device counts as dead
 
 # Logging configuration
 logging.basicConfig(
@@ -45,6 +66,24 @@ logging.basicConfig(
 logger = logging.getLogger(__name__)
 
 
+class HeartbeatLost(TimeoutError):
+    """The device stopped sending heartbeats while a response was due."""
+
+
+@dataclass
+class Heartbeat:
+    """Heartbeat enabled on a serial connection, and when the device was last heard."""
+    interval_ms: int
+    last_heard: float
+
+
+# Connections with the device heartbeat on; see enable_heartbeat
+heartbeats: Dict[serial.Serial, Heartbeat] = {}
+
+# Resets issued through reset_device, per connection; each one restores the firmware defaults
+device_resets: Dict[serial.Serial, int] = {}
+
+
 def parse_args() -> argparse.Namespace:
     """
     Parse and validate command line arguments.
@@ -63,8 +102,11 @@ Examples:
   %(prog)s /dev/ttyUSB0 data.bin
   %(prog)s COM3 packet.bin -f 433.5 -p 10
   %(prog)s /dev/ttyUSB0 message.txt -b 9600 -t 60
+  %(prog)s /dev/ttyUSB0 page.bin --id 1042
+  %(prog)s /dev/ttyUSB0 pages/*.bin --hash-ids --stats
 
-Supported file formats: Any binary file up to 2048 bytes
+Supported file formats: Any binary file up to 2048 bytes. Several files are
+sent in order; the next ones are read and prepared while one is on air.
         """
     )
     
@@ -75,7 +117,8 @@ Supported file formats: Any binary file up to 2048 bytes
     parser.add_argument(
         'file',
         type=Path,
-        help='Path to file to transmit (max 2048 bytes)'
+        nargs='+',
+        help='Path to file(s) to transmit (max 2048 bytes each)'
     )
     parser.add_argument(
         '-f', '--frequency',
@@ -103,6 +146,68 @@ Supported file formats: Any binary file up to 2048 bytes
         default=DEFAULT_TIMEOUT,
         help=f'Response timeout in seconds (default: {DEFAULT_TIMEOUT})'
     )
+    parser.add_argument(
+        '--crc',
+        choices=sorted(CRC_MODES),
+        help='Have the radio append a hardware CRC instead of including one in the file'
+    )
+    parser.add_argument(
+        '--whitening',
+        action='store_true',
+        help='Have the radio apply PN9 data whitening (requires --crc to be set, use "off" for none)'
+    )
+    parser.add_argument(
+        '--soft-crc',
+        choices=['ccitt', 'ibm'],
+        help='Append the SX127x CRC on the host instead of in the radio'
+    )
+    parser.add_argument(
+        '--soft-whitening',
+        action='store_true',
+        help='Apply SX127x PN9 whitening on the host instead of in the radio'
+    )
+    parser.add_argument(
+        '--id',
+        type=int,
+        metavar='ID',
+        help='Message ID (1-4294967295); resending the same ID never transmits twice. '
+             'Further files get the following IDs'
+    )
+    parser.add_argument(
+        '--hash-ids',
+        action='store_true',
+        help='Derive each message ID from a SHA-256 of the file, so resending a file never transmits it twice'
+    )
+    parser.add_argument(
+        '--no-delta',
+        action='store_true',
+        help='Always upload whole files, never only the bytes changed since the previous file'
+    )
+    parser.add_argument(
+        '--prefetch',
+        type=int,
+        metavar='N',
+        default=PREFETCH_DEPTH,
+        help=f'Files prepared ahead per pipeline stage (default: {PREFETCH_DEPTH})'
+    )
+    parser.add_argument(
+        '--stats',
+        action='store_true',
+        help='Log pipeline queue wait and stage times at the end'
+    )
+    parser.add_argument(
+        '--wake',
+        action='store_true',
+        help='Send a wake-up newline first (device idle mode 2, light sleep)'
+    )
+    parser.add_argument(
+        '--heartbeat',
+        type=int,
+        metavar='MS',
+        default=0,
+        help='Have the device send a heartbeat every MS milliseconds and give up after '
+             f'{HEARTBEAT_MISSED_LIMIT} missed beats instead of waiting for the timeout'
+    )
     parser.add_argument(
         '-v', '--verbose',
         action='store_true',
@@ -124,21 +229,44 @@ Supported file formats: Any binary file up to 2048 bytes
     if args.frequency is not None and not (100.0 <= args.frequency <= 1000.0):
         parser.error('frequency must be between 100 and 1000 MHz')
     
-    # Validate file existence and size
-    if not args.file.is_file():
-        parser.error(f"file '{args.file}' does not exist or is not a file")
+    # Validate file existence and size (software CRC bytes count against the limit)
+    max_size = MAX_CHUNK - (2 if args.soft_crc else 0)
+    for path in args.file:
+        if not path.is_file():
+            parser.error(f"file '{path}' does not exist or is not a file")
+        
+        file_size = path.stat().st_size
+        if file_size > max_size:
+            parser.error(f"file '{path}' size {file_size} exceeds maximum of {max_size} bytes")
+        
+        if file_size == 0:
+            parser.error(f"file '{path}' is empty")
+    
+    # Whitening is configured together with the CRC mode
+    if args.whitening and args.crc is None:
+        parser.error('--whitening requires --crc (use --crc off for whitening only)')
+    
+    # Framing is done either by the radio or on the host, not both
+    if (args.soft_crc or args.soft_whitening) and (args.crc not in (None, 'off') or args.whitening):
+        parser.error('--soft-crc/--soft-whitening cannot be combined with hardware --crc/--whitening')
+    
+    # Validate message ID
+    if args.id is not None and not (1 <= args.id <= 0xFFFFFFFF):
+        parser.error('id must be between 1 and 4294967295')
     
-    file_size = args.file.stat().st_size
-    if file_size > MAX_CHUNK:
-        parser.error(f"file size {file_size} exceeds maximum of {MAX_CHUNK} bytes")
+    if args.id is not None and args.hash_ids:
+        parser.error('--id and --hash-ids are mutually exclusive')
     
-    if file_size == 0:
-        parser.error("file is empty")
+    if args.prefetch < 1:
+        parser.error('prefetch must be at least 1')
     
     # Validate timeout
     if args.timeout <= 0:
         parser.error('timeout must be positive')
     
+    if args.heartbeat and not (HEARTBEAT_MIN_MS <= args.heartbeat <= HEARTBEAT_MAX_MS):
+        parser.error(f'heartbeat must be between {HEARTBEAT_MIN_MS} and {HEARTBEAT_MAX_MS} ms')
+    
     # Configure logging level
     if args.verbose:
         logging.getLogger().setLevel(logging.DEBUG)
@@ -170,7 +298,7 @@ def drain_startup(ser: serial.Serial, timeout: float = 1.0) -> List[str]:
         if ser.in_waiting:
             try:
                 line = ser.readline().decode('utf-8', errors='replace').rstrip()
-                if line:
+                if line and not line.startswith(HEARTBEAT_PREFIX):
                     logger.info(f"Device: {line}")
                     messages.append(line)
             except UnicodeDecodeError:
@@ -215,6 +343,8 @@ def read_response(ser: serial.Serial, timeout: Optional[float] = None) -> Option
     
     This function handles timeout, decoding errors, and empty lines gracefully.
     It returns the first non-empty line received or None if no data is available.
+    Heartbeat lines are skipped; like any other line they count as a sign of
+    life for heartbeat_wait.
     
     Args:
         ser: Open serial connection to the device
@@ -229,26 +359,109 @@ def read_response(ser: serial.Serial, timeout: Optional[float] = None) -> Option
     original_timeout = ser.timeout
     if timeout is not None:
         ser.timeout = timeout
+    deadline = None if ser.timeout is None else time.time() + ser.timeout
     
     try:
-        raw = ser.readline()
-        if not raw:
-            return None
+        while True:
+            raw = ser.readline()
+            if not raw:
+                return None
+                
+            line = raw.decode('utf-8', errors='replace').strip()
+            if not line:
+                return None
+            
+            beat = heartbeats.get(ser)
+            if beat is not None:
+                beat.last_heard = time.time()
             
-        line = raw.decode('utf-8', errors='replace').strip()
-        if line:
-            logger.debug(f"Received: {line}")
-            return line
-        return None
+            if not line.startswith(HEARTBEAT_PREFIX):
+                logger.debug(f"Received: {line}")
+                return line
+            
+            # Keep reading for whatever is left of the timeout
+            if deadline is not None:
+                remaining = deadline - time.time()
+                if remaining <= 0:
+                    return None
+                ser.timeout = remaining
         
     except serial.SerialException as e:
         logger.error(f"Serial read error: {e}")
         raise
     finally:
-        if timeout is not None:
+        if ser.timeout != original_timeout:
             ser.timeout = original_timeout
 
 
+def enable_heartbeat(ser: serial.Serial, interval_ms: int, timeout: float) -> None:
+    """
+    Have the device print a heartbeat every interval_ms milliseconds (0 = off).
+    
+    While the heartbeat is on, the expect functions give up with HeartbeatLost
+    once nothing has been heard from the device for HEARTBEAT_MISSED_LIMIT
+    intervals, rather than waiting out the full response timeout. The device
+    keeps beating during a transmission, so a long packet is not mistaken for
+    a wedged device. The device is not reset then; that is left to the caller,
+    which may want to fail over to another device first.
+    
+    Raises:
+        RuntimeError: If the firmware does not support the heartbeat
+        TimeoutError: If the device doesn't respond within timeout
+    """
+    heartbeats.pop(ser, None)
+    send_command(ser, f'k {interval_ms}')
+    response = expect_console_success(ser, 'Heartbeat', timeout)
+    logger.info(f"Device heartbeat: {response}")
+    
+    if interval_ms:
+        heartbeats[ser] = Heartbeat(interval_ms, time.time())
+
+
+def heartbeat_wait(ser: serial.Serial, start_time: float, wait: float) -> float:
+    """
+    Shorten a read of up to wait seconds so that a lost heartbeat is noticed.
+    
+    Silence is counted from the last line received or from start_time, when
+    the caller started waiting, whichever is later; time the host spent
+    elsewhere does not count against the device.
+    
+    Returns:
+        How long the next read may block
+        
+    Raises:
+        HeartbeatLost: If the heartbeat is on and HEARTBEAT_MISSED_LIMIT
+            intervals have passed in silence
+    """
+    beat = heartbeats.get(ser)
+    if beat is None:
+        return wait
+    
+    limit = HEARTBEAT_MISSED_LIMIT * beat.interval_ms / 1000
+    silent = time.time() - max(beat.last_heard, start_time)
+    if silent >= limit:
+        logger.error(f"No heartbeat from the device for {silent * 1000:.0f} ms")
+        raise HeartbeatLost(f'No heartbeat from the device for {silent * 1000:.0f} ms')
+    
+    return max(min(wait, limit - silent), POLL_INTERVAL)
+
+
+def wake_device(ser: serial.Serial) -> None:
+    """
+    Wake the device from light sleep before sending commands.
+    
+    The UART activity that wakes the device is not received, so a blank line
+    (ignored by the firmware) is sent first, followed by a short pause.
+    
+    Args:
+        ser: Open serial connection to the device
+    """
+    ser.write(b'\n')
+    ser.flush()
+    time.sleep(WAKE_DELAY)
+    logger.debug("Sent wake-up newline")
+
+
 def reset_device(ser: serial.Serial) -> None:
     """
     Reset the device using DTR signal or port reconnection.
@@ -265,6 +478,10 @@ def reset_device(ser: serial.Serial) -> None:
     """
     logger.warning("Resetting device due to timeout or error")
     
+    # The device restarts with the heartbeat off
+    beat = heartbeats.pop(ser, None)
+    device_resets[ser] = device_resets.get(ser, 0) + 1
+    
     try:
         # Attempt DTR reset (preferred method)
         logger.debug("Attempting DTR reset")
@@ -295,15 +512,43 @@ def reset_device(ser: serial.Serial) -> None:
     startup_messages = drain_startup(ser, timeout=3.0)
     if startup_messages:
         logger.info(f"Device restarted, received {len(startup_messages)} startup messages")
+    
+    if beat is not None:
+        restart_heartbeat(ser, beat.interval_ms)
+
+
+def restart_heartbeat(ser: serial.Serial, interval_ms: int) -> None:
+    """
+    Turn the heartbeat back on after a reset.
+    
+    Unlike enable_heartbeat this never resets the device itself; if it does
+    not answer, the heartbeat stays off and the next response wait runs into
+    the ordinary timeout.
+    """
+    send_command(ser, f'k {interval_ms}')
+    start_time = time.time()
+    
+    while time.time() - start_time < SERIAL_READ_TIMEOUT:
+        line = read_response(ser, timeout=SERIAL_READ_TIMEOUT)
+        if line is None or not line.startswith('CONSOLE:'):
+            continue
+        if line.startswith('CONSOLE:0:Heartbeat'):
+            heartbeats[ser] = Heartbeat(interval_ms, time.time())
+            return
+        break
+    
+    logger.warning("Device did not turn the heartbeat back on after the reset")
 
 
-def expect_console_success(ser: serial.Serial, expected_msg_prefix: str, timeout: Optional[float]) -> str:
+def expect_console_success(ser: serial.Serial, expected_msg_prefix: Union[str, Tuple[str, ...]],
+                           timeout: Optional[float]) -> str:
     """
     Wait for a CONSOLE:0: success response with specific message prefix.
     
     Args:
         ser: Open serial connection to the device
-        expected_msg_prefix: Expected prefix of the message part
+        expected_msg_prefix: Expected prefix of the message part, or a tuple of
+            alternative prefixes
         timeout: Maximum time to wait for response in seconds
         
     Returns:
@@ -311,6 +556,7 @@ def expect_console_success(ser: serial.Serial, expected_msg_prefix: str, timeout
         
     Raises:
         TimeoutError: If no valid response is received within timeout
+        HeartbeatLost: If the heartbeat is on and stops
         RuntimeError: If the device returns an error response
     """
     logger.debug(f"Expecting CONSOLE:0: response with message prefix '{expected_msg_prefix}' (timeout: {timeout}s)")
@@ -323,7 +569,7 @@ def expect_console_success(ser: serial.Serial, expected_msg_prefix: str, timeout
             reset_device(ser)
             raise TimeoutError(f'No valid CONSOLE response after {timeout} seconds')
         
-        line = read_response(ser, timeout=min(1.0, timeout) if timeout else 1.0)
+        line = read_response(ser, timeout=heartbeat_wait(ser, start_time, min(1.0, timeout) if timeout else 1.0))
         if not line:
             continue
             
@@ -373,6 +619,7 @@ def expect_tx_success(ser: serial.Serial, timeout: Optional[float]) -> str:
         
     Raises:
         TimeoutError: If no valid response is received within timeout
+        HeartbeatLost: If the heartbeat is on and stops
         RuntimeError: If the device returns an error response
     """
     logger.debug(f"Expecting TX:0: success response (timeout: {timeout}s)")
@@ -385,7 +632,7 @@ def expect_tx_success(ser: serial.Serial, timeout: Optional[float]) -> str:
             reset_device(ser)
             raise TimeoutError(f'No valid TX response after {timeout} seconds')
         
-        line = read_response(ser, timeout=min(1.0, timeout) if timeout else 1.0)
+        line = read_response(ser, timeout=heartbeat_wait(ser, start_time, min(1.0, timeout) if timeout else 1.0))
         if not line:
             continue
             
@@ -437,6 +684,7 @@ def expect(ser: serial.Serial, prefixes: Union[str, List[str]], timeout: Optiona
         
     Raises:
         TimeoutError: If no valid response is received within timeout
+        HeartbeatLost: If the heartbeat is on and stops
         RuntimeError: If the device returns an error response (code != 0)
         serial.SerialException: If serial communication fails
     """
@@ -455,7 +703,7 @@ def expect(ser: serial.Serial, prefixes: Union[str, List[str]], timeout: Optiona
             raise TimeoutError(f'No valid response after {timeout} seconds')
         
         # Read next line
-        line = read_response(ser, timeout=min(1.0, timeout) if timeout else 1.0)
+        line = read_response(ser, timeout=heartbeat_wait(ser, start_time, min(1.0, timeout) if timeout else 1.0))
         if not line:
             continue
             
@@ -532,7 +780,8 @@ def validate_serial_port(port: str, baud: int) -> serial.Serial:
 
 
 def configure_device(ser: serial.Serial, frequency: Optional[float], 
-                    power: Optional[int], timeout: float) -> None:
+                    power: Optional[int], timeout: float,
+                    crc: Optional[str] = None, whitening: bool = False) -> None:
     """
     Configure device transmission parameters.
     
@@ -541,6 +790,8 @@ def configure_device(ser: serial.Serial, frequency: Optional[float],
         frequency: Frequency in MHz (if provided)
         power: Transmit power in dBm (if provided)
         timeout: Response timeout in seconds
+        crc: Hardware CRC mode from CRC_MODES (if provided)
+        whitening: Enable hardware whitening (only applied together with crc)
         
     Raises:
         RuntimeError: If device configuration fails
@@ -562,10 +813,18 @@ def configure_device(ser: serial.Serial, frequency: Optional[float],
         response = expect_console_success(ser, 'Frequency set to', timeout)
         logger.debug(f"Frequency configuration response: {response}")
     
+    # Set hardware framing if requested
+    if crc is not None:
+        logger.info(f"Setting hardware CRC to {crc}, whitening {'on' if whitening else 'off'}")
+        send_command(ser, f'h {CRC_MODES[crc]} {int(whitening)}')
+        response = expect_console_success(ser, 'Hardware framing set to', timeout)
+        logger.debug(f"Framing configuration response: {response}")
+    
     logger.info("Device configuration completed")
 
 
-def transmit_file(ser: serial.Serial, file_path: Path, timeout: float) -> int:
+def transmit_file(ser: serial.Serial, file_path: Path, timeout: float,
+                  message_id: Optional[int] = None) -> int:
     """
     Transmit file contents to the device.
     
@@ -573,6 +832,8 @@ def transmit_file(ser: serial.Serial, file_path: Path, timeout: float) -> int:
         ser: Open serial connection
         file_path: Path to file to transmit
         timeout: Response timeout in seconds
+        message_id: Optional message ID; if the device has already transmitted
+            this ID it replays the original result instead of transmitting
         
     Returns:
         Number of bytes successfully transmitted
@@ -590,23 +851,112 @@ def transmit_file(ser: serial.Serial, file_path: Path, timeout: float) -> int:
         logger.error(f"Failed to read file {file_path}: {e}")
         raise RuntimeError(f"File read error: {e}")
     
+    logger.info(f"File loaded: {len(data)} bytes")
+    transmit_data(ser, data, timeout, message_id)
+    return len(data)
+
+
+def make_delta(base: bytes, data: bytes) -> bytes:
+    """
+    Encode data as the ranges that differ from base, for the d command.
+    
+    Each range is a DELTA_RECORD header followed by its bytes, in ascending
+    order. Bytes past the end of base always differ. Unchanged runs no longer
+    than a record header are sent along rather than starting a new record.
+    """
+    ranges: List[List[int]] = []
+    for i in range(len(data)):
+        if i < len(base) and data[i] == base[i]:
+            continue
+        if ranges and i - ranges[-1][1] <= DELTA_RECORD.size:
+            ranges[-1][1] = i + 1
+        else:
+            ranges.append([i, i + 1])
+    
+    return b''.join(DELTA_RECORD.pack(start, end - start) + bytes(data[start:end])
+                    for start, end in ranges)
+
+
+def transmit_data(ser: serial.Serial, data: bytes, timeout: float,
+                  message_id: Optional[int] = None, base: Optional[bytes] = None) -> str:
+    """
+    Transmit one payload and wait for its result.
+    
+    With a base (the previous payload sent to the device) only the changed
+    ranges are uploaded with the d command, if that is fewer bytes than the
+    whole payload. The device checks the base against its buffer; if they
+    differ, for example after a reset, the whole payload is uploaded with m.
+    
+    Args:
+        ser: Open serial connection
+        data: Payload of 1 to MAX_CHUNK bytes
+        timeout: Response timeout in seconds
+        message_id: Optional message ID; if the device has already transmitted
+            this ID it replays the original result instead of transmitting
+        base: Previous payload uploaded in this session, if any
+        
+    Returns:
+        The TX success message (the original result for a duplicate ID)
+        
+    Raises:
+        RuntimeError: If transmission fails
+        TimeoutError: If device doesn't respond within timeout
+    """
     size = len(data)
-    logger.info(f"File loaded: {size} bytes")
+    suffix = '' if message_id is None else f' {message_id}'
+    
+    if base:
+        delta = make_delta(base, data)
+        if len(delta) < size:
+            logger.info(f"Starting delta transmission of {size} bytes ({len(delta)} bytes uploaded)")
+            try:
+                return upload(ser, f'd {size} {len(base)} {zlib.crc32(base):08x} {len(delta)}{suffix}',
+                              delta, size, timeout, message_id)
+            except RuntimeError as e:
+                if not any(reason in str(e) for reason in ('Delta base mismatch', 'Invalid delta')):
+                    raise
+                logger.info(f"Delta rejected ({e}), uploading the whole payload")
     
-    # Initiate transmission
     logger.info(f"Starting transmission of {size} bytes")
-    send_command(ser, f'm {size}')
-    response = expect_console_success(ser, f'Waiting for {size} bytes', timeout)
+    return upload(ser, f'm {size}{suffix}', data, size, timeout, message_id)
+
+
+def upload(ser: serial.Serial, command: str, payload: bytes, size: int, timeout: float,
+           message_id: Optional[int]) -> str:
+    """
+    Send an upload command and its payload, then wait for the TX result.
+    
+    Args:
+        ser: Open serial connection
+        command: The m or d command line
+        payload: Bytes the device waits for after the command
+        size: Length of the resulting message, as the device accepts it
+        timeout: Response timeout in seconds
+        message_id: Message ID in the command, for logging a duplicate
+        
+    Returns:
+        The TX success message (the original result for a duplicate ID)
+    """
+    send_command(ser, command)
+    response = expect_console_success(ser, (f'Waiting for {len(payload)} bytes', 'Duplicate of message'), timeout)
+    
+    # The device already transmitted this message ID: it replays the original result
+    if response.startswith('Duplicate of message'):
+        logger.warning(f"Message {message_id} was already sent, not transmitting again")
+        tx_response = expect_tx_success(ser, timeout)
+        logger.info(f"Original result: {tx_response}")
+        return tx_response
+    
     logger.debug(f"Device ready for data: {response}")
     
     # Send binary data
     logger.debug("Sending binary data")
     try:
-        bytes_written = ser.write(data)
+        bytes_written = ser.write(payload)
         ser.flush()
         
-        if bytes_written != size:
-            raise RuntimeError(f"Partial write: {bytes_written}/{size} bytes")
+        if bytes_written != len(payload):
+            raise RuntimeError(f"Partial write: {bytes_written}/{len(payload)} bytes")
             
         logger.debug(f"Binary data sent: {bytes_written} bytes")
     except serial.SerialException as e:
@@ -628,7 +978,14 @@ def transmit_file(ser: serial.Serial, file_path: Path, timeout: float) -> int:
     logger.debug(f"Transmission completed: {tx_response}")
     
     logger.info(f"Transmission completed successfully: {size} bytes")
-    return size
+    return tx_response
+
+
+def log_pipeline_stats(pipeline: Pipeline) -> None:
+    """Log queue wait and stage service times of a finished pipeline."""
+    for stage, times in pipeline.summary().items():
+        logger.info(f"Pipeline {stage}: " + ', '.join(f"{key}={value:.2f}" for key, value in times.items()))
+    logger.info(f"Pipeline: sender waited {pipeline.consumer_wait_s * 1000:.2f} ms for prepared files")
 
 
 def main() -> None:
@@ -636,14 +993,16 @@ def main() -> None:
     Main application entry point.
     
     Parses command line arguments, establishes serial communication,
-    configures the device, and transmits the specified file.
+    configures the device, and transmits the specified files. Files are
+    prepared by a prefetch pipeline while the previous one is on air.
     """
     try:
         args = parse_args()
         
         logger.info(f"FSK File Transmitter starting")
         logger.info(f"Target: {args.port} at {args.baud} baud")
-        logger.info(f"File: {args.file} ({args.file.stat().st_size} bytes)")
+        for path in args.file:
+            logger.info(f"File: {path} ({path.stat().st_size} bytes)")
         
         if args.dry_run:
             logger.info("Dry run mode: validation completed successfully")
@@ -662,11 +1021,34 @@ def main() -> None:
             else:
                 logger.info("Device ready (no startup messages - already initialized)")
             
+            if args.wake:
+                wake_device(ser)
+            
+            if args.heartbeat:
+                enable_heartbeat(ser, args.heartbeat, args.timeout)
+            
             # Configure transmission parameters
-            configure_device(ser, args.frequency, args.power, args.timeout)
+            configure_device(ser, args.frequency, args.power, args.timeout, args.crc, args.whitening)
             
-            # Transmit file
-            bytes_sent = transmit_file(ser, args.file, args.timeout)
+            # Transmit files as the pipeline delivers them
+            options = PipelineOptions(max_size=MAX_CHUNK - (2 if args.soft_crc else 0),
+                                      first_id=args.id, hash_ids=args.hash_ids,
+                                      soft_crc=args.soft_crc, soft_whitening=args.soft_whitening)
+            bytes_sent = 0
+            base = None  # Previous payload, still in the device buffer
+            with Pipeline(args.file, options, args.prefetch) as pipeline:
+                for job in pipeline:
+                    if job.error is not None:
+                        raise RuntimeError(f"File preparation failed: {job.error}")
+                    
+                    logger.info(f"Transmitting {job.path} (sha256 {job.digest[:16]})")
+                    transmit_data(ser, job.data, args.timeout, job.message_id, base)
+                    bytes_sent += len(job.data)
+                    if not args.no_delta:
+                        base = job.data
+                
+                if args.stats:
+                    log_pipeline_stats(pipeline)
             
             logger.info(f"Operation completed successfully: {bytes_sent} bytes transmitted")
             
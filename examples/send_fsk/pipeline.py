@@ -0,0 +1,190 @@
+"""
+Prefetch Pipeline for ttgo-fsk-tx Uploads
+
+Prepares the next payloads on worker threads while the current one is on
+air, so the next upload can start as soon as the device reports TX:0.
+Each job passes three stages, each on its own thread and connected by
+bounded queues:
+
+    read    load the file and check its size
+    hash    SHA-256 of the payload; optionally derive the message ID from it
+    encode  software framing (codec.frame), if requested
+
+Every job records how long it waited in each queue and how long each stage
+took, and the consumer records how long it waited for the pipeline. The
+payload is not compressed: the firmware transmits the uploaded bytes as
+they are, so compressing would change what goes on air.
+"""
+
+from __future__ import annotations
+
+import hashlib
+import queue
+import threading
+import time
+from dataclasses import dataclass, field
+from pathlib import Path
+from typing import Callable, Dict, Iterator, List, Optional
+
+from codec import frame
+
+STAGES = ('read', 'hash', 'encode')
+PUT_POLL = 0.1  # How often a blocked stage checks for shutdown
+
+
+@dataclass
+class Job:
+    """One file on its way through the pipeline."""
+    index: int
+    path: Path
+    message_id: Optional[int] = None
+    data: bytes = b''
+    digest: str = ''
+    error: Optional[Exception] = None
+    stage_s: Dict[str, float] = field(default_factory=dict)  # Service time per stage
+    queue_wait_s: Dict[str, float] = field(default_factory=dict)  # Time spent queued before each stage
+    enqueued: float = 0.0
+
+
+@dataclass
+class PipelineOptions:
+    """What the pipeline does to each payload."""
+    max_size: int
+    first_id: Optional[int] = None  # IDs are assigned in file order from here
+    hash_ids: bool = False  # Derive IDs from the payload hash instead
+    soft_crc: Optional[str] = None  # 'ccitt' or 'ibm': append a CRC on the host
+    soft_whitening: bool = False
+
+
+def hash_message_id(digest: bytes) -> int:
+    """Map a payload digest to a message ID (1 to 2^32 - 1)."""
+    return int.from_bytes(digest[:4], 'big') or 1
+
+
+class Pipeline:
+    """
+    Runs the read, hash and encode stages ahead of the consumer.
+
+    Iterating yields prepared jobs in file order. A job whose stage failed
+    is yielded with its error set instead of being dropped, so the consumer
+    decides whether to stop. At most `depth` jobs wait between two stages.
+    """
+
+    def __init__(self, paths: List[Path], options: PipelineOptions, depth: int = 2):
+        self.options = options
+        self.jobs: List[Job] = []
+        self.consumer_wait_s = 0.0  # Time the consumer spent waiting for the next job
+        self._stop = threading.Event()
+
+        self._queues = [queue.Queue(maxsize=depth) for _ in range(len(STAGES) + 1)]
+        stage_functions: List[Callable[[Job], None]] = [self._read, self._hash, self._encode]
+        self._threads = [
+            threading.Thread(target=self._run_stage, name=f'pipeline-{name}',
+                             args=(name, function, self._queues[i], self._queues[i + 1]), daemon=True)
+            for i, (name, function) in enumerate(zip(STAGES, stage_functions))
+        ]
+        self._feeder = threading.Thread(target=self._feed, args=(paths,), name='pipeline-feed', daemon=True)
+
+    def __enter__(self) -> Pipeline:
+        self._feeder.start()
+        for thread in self._threads:
+            thread.start()
+        return self
+
+    def __exit__(self, *exc) -> None:
+        self.close()
+
+    def close(self) -> None:
+        """Stop the stages, dropping jobs that were prepared but not consumed."""
+        self._stop.set()
+        for thread in [self._feeder] + self._threads:
+            thread.join()
+
+    def __iter__(self) -> Iterator[Job]:
+        output = self._queues[-1]
+        while True:
+            start = time.perf_counter()
+            job = output.get()
+            now = time.perf_counter()
+            self.consumer_wait_s += now - start
+            if job is None:
+                return
+            job.queue_wait_s['send'] = now - job.enqueued
+            self.jobs.append(job)
+            yield job
+
+    def _put(self, target: queue.Queue, item: Optional[Job]) -> bool:
+        if item is not None:
+            item.enqueued = time.perf_counter()
+        while not self._stop.is_set():
+            try:
+                target.put(item, timeout=PUT_POLL)
+                return True
+            except queue.Full:
+                continue
+        return False
+
+    def _feed(self, paths: List[Path]) -> None:
+        for index, path in enumerate(paths):
+            message_id = None
+            if self.options.first_id is not None:
+                message_id = (self.options.first_id + index - 1) % 0xFFFFFFFF + 1
+            if not self._put(self._queues[0], Job(index, path, message_id)):
+                return
+        self._put(self._queues[0], None)
+
+    def _run_stage(self, name: str, function: Callable[[Job], None],
+                   source: queue.Queue, target: queue.Queue) -> None:
+        while not self._stop.is_set():
+            try:
+                job = source.get(timeout=PUT_POLL)
+            except queue.Empty:
+                continue
+
+            if job is None:
+                self._put(target, None)
+                return
+
+            start = time.perf_counter()
+            job.queue_wait_s[name] = start - job.enqueued
+            if job.error is None:
+                try:
+                    function(job)
+                except (OSError, ValueError) as e:
+                    job.error = e
+            job.stage_s[name] = time.perf_counter() - start
+
+            if not self._put(target, job):
+                return
+
+    def _read(self, job: Job) -> None:
+        job.data = job.path.read_bytes()
+        if not 1 <= len(job.data) <= self.options.max_size:
+            raise ValueError(f"{job.path}: {len(job.data)} bytes, must be 1 to {self.options.max_size}")
+
+    def _hash(self, job: Job) -> None:
+        digest = hashlib.sha256(job.data).digest()
+        job.digest = digest.hex()
+        if self.options.hash_ids:
+            job.message_id = hash_message_id(digest)
+
+    def _encode(self, job: Job) -> None:
+        if self.options.soft_crc is not None or self.options.soft_whitening:
+            job.data = frame(job.data, self.options.soft_crc, self.options.soft_whitening)
+
+    def summary(self) -> Dict[str, Dict[str, float]]:
+        """Average and worst queue wait and service time per stage, in milliseconds."""
+        result: Dict[str, Dict[str, float]] = {}
+        for name in STAGES + ('send',):
+            waits = [job.queue_wait_s[name] for job in self.jobs if name in job.queue_wait_s]
+            times = [job.stage_s[name] for job in self.jobs if name in job.stage_s]
+            if not waits:
+                continue
+            result[name] = {
+                'queue_avg_ms': sum(waits) / len(waits) * 1000,
+                'queue_max_ms': max(waits) * 1000,
+            }
+            if times:
+                result[name]['stage_avg_ms'] = sum(times) / len(times) * 1000
+                result[name]['stage_max_ms'] = max(times) * 1000
+        return result
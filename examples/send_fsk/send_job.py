@@ -0,0 +1,271 @@
+#!/usr/bin/env python3
+"""
+Job File Sender for ttgo-fsk-tx
+
+Streams every payload of a job file (see jobfile.py) to the device in one
+serial session. The radio settings from the job header are applied once.
+Each entry is sent when its schedule time is reached. Among due entries the
+highest priority goes first, then the earliest schedule time, then file
+order.
+
+Progress is appended to a progress file (default: <job>.progress) and synced
+after every entry. Running the same command again after an interruption
+skips the entries already sent and retries failed ones. The entry that was
+in flight is sent again. Entries with a key are sent under that device message ID, so the
+device answers a resend with the original result instead of transmitting
+twice. Entries without a key may go on air twice after an interruption.
+"""
+
+from __future__ import annotations
+
+import argparse
+import heapq
+import json
+import logging
+import os
+import sys
+import time
+from pathlib import Path
+from typing import Dict, List, Optional
+
+import serial
+
+from jobfile import JobEntry, JobFile
+from main import (DEFAULT_BAUD, DEFAULT_TIMEOUT, HEARTBEAT_MAX_MS, HEARTBEAT_MIN_MS, HeartbeatLost,
+                  configure_device, device_resets, drain_startup, enable_heartbeat, reset_device,
+                  transmit_data, validate_serial_port, wake_device)
+
+MAX_SCHEDULE_WAIT = 1.0  # Longest sleep while waiting for the next scheduled entry
+
+# Device reset count at which the job settings were last applied, per connection
+job_configured: Dict[serial.Serial, int] = {}
+
+logger = logging.getLogger(__name__)
+
+
+class Progress:
+    """
+    Append-only record of finished entries, one JSON object per line.
+
+    The first line names the job, so a progress file is never applied to a
+    different job that happens to share its path.
+    """
+
+    def __init__(self, path: Path, job_id: str, restart: bool):
+        self.path = path
+        self.done: Dict[int, str] = {}
+
+        if path.exists() and not restart:
+            with open(path) as f:
+                lines = [json.loads(line) for line in f if line.strip()]
+            if lines and lines[0].get('job') != job_id:
+                raise RuntimeError(f"{path} belongs to job {lines[0].get('job')}, not {job_id} "
+                                   f"(use --restart to discard it)")
+            for record in lines[1:]:
+                self.done[record['index']] = record['result']
+            self._file = open(path, 'a')
+            if not lines:
+                self._append({'job': job_id})
+        else:
+            self._file = open(path, 'w')
+            self._append({'job': job_id})
+
+    def _append(self, record: dict) -> None:
+        self._file.write(json.dumps(record) + '\n')
+        self._file.flush()
+        os.fsync(self._file.fileno())
+
+    def record(self, entry: JobEntry, result: str, message: str) -> None:
+        self.done[entry.index] = result
+        self._append({'index': entry.index, 'result': result, 'message': message, 'time': time.time()})
+
+    def close(self) -> None:
+        self._file.close()
+
+
+class Schedule:
+    """Orders pending entries by schedule time, then priority among those due."""
+
+    def __init__(self, entries: List[JobEntry]):
+        self._waiting = [(e.schedule_ms, e.index, e) for e in entries]
+        heapq.heapify(self._waiting)
+        self._due: list = []
+
+    def __len__(self) -> int:
+        return len(self._waiting) + len(self._due)
+
+    def next(self) -> Optional[JobEntry]:
+        """Return the entry to send now, or None if nothing is due yet."""
+        now_ms = time.time() * 1000
+        while self._waiting and self._waiting[0][0] <= now_ms:
+            schedule_ms, index, entry = heapq.heappop(self._waiting)
+            heapq.heappush(self._due, (-entry.priority, schedule_ms, index, entry))
+        if not self._due:
+            return None
+        return heapq.heappop(self._due)[3]
+
+    def wait(self) -> None:
+        """Sleep until the next scheduled entry is due, in short steps."""
+        delay = self._waiting[0][0] / 1000 - time.time()
+        time.sleep(min(max(delay, 0.0), MAX_SCHEDULE_WAIT))
+
+
+def configure_job(ser: serial.Serial, job: JobFile, timeout: float) -> None:
+    """
+    Apply the job's radio settings, again if the device was reset since.
+
+    Every reset restores the firmware defaults, so without this a retry and
+    all later entries would go out on the default frequency, power and
+    framing.
+    """
+    resets = device_resets.get(ser, 0)
+    if job_configured.get(ser) == resets:
+        return
+    if ser in job_configured:
+        logger.info("Device was reset, applying the job settings again")
+    configure_device(ser, job.settings.frequency, job.settings.power, timeout,
+                     job.settings.crc, job.settings.whitening)
+    job_configured[ser] = resets
+
+
+def send_entry(ser: serial.Serial, job: JobFile, entry: JobEntry, timeout: float,
+               retries: int, base: Optional[bytes]) -> str:
+    """
+    Send one entry, retrying timeouts for entries with a key.
+
+    Retrying is only safe with a key: after a timeout the device is reset and
+    may or may not have transmitted the payload. A lost heartbeat gives up
+    without a reset, so the device is reset here. Job settings lost in a
+    reset are applied again before each attempt.
+
+    Raises:
+        RuntimeError: If the device reports an error
+        TimeoutError: If the device does not answer, after any retries
+    """
+    attempt = 0
+    while True:
+        try:
+            configure_job(ser, job, timeout)
+            return transmit_data(ser, job.payload(entry), timeout, entry.key or None, base)
+        except TimeoutError as e:
+            if isinstance(e, HeartbeatLost):
+                reset_device(ser)
+            attempt += 1
+            if not entry.key or attempt > retries:
+                raise
+            logger.warning(f"Entry {entry.index} timed out, retrying as message {entry.key} "
+                           f"({attempt}/{retries})")
+
+
+def run_job(ser: serial.Serial, job: JobFile, progress: Progress, timeout: float,
+            retries: int, stop_on_error: bool, delta: bool = True) -> Dict[str, int]:
+    """
+    Send all entries not yet in the progress file and return result counts.
+
+    With delta set, each entry is uploaded as its changes against the entry
+    sent before it, when that is shorter (see transmit_data).
+    """
+    pending = [e for e in job.entries if progress.done.get(e.index) != 'sent']
+    counts = {'sent': 0, 'failed': 0, 'skipped': len(job.entries) - len(pending)}
+    if counts['skipped']:
+        logger.info(f"Resuming: {counts['skipped']} of {len(job.entries)} entries already sent")
+
+    schedule = Schedule(pending)
+    base = None  # Previous payload, still in the device buffer
+    while len(schedule):
+        entry = schedule.next()
+        if entry is None:
+            schedule.wait()
+            continue
+
+        if entry.schedule_ms:
+            late = time.time() - entry.schedule_ms / 1000
+            if late > 1.0:
+                logger.warning(f"Entry {entry.index} is {late:.1f} s late")
+
+        logger.info(f"Entry {entry.index}: {entry.length} bytes, priority {entry.priority}")
+        try:
+            message = send_entry(ser, job, entry, timeout, retries, base)
+        except (RuntimeError, TimeoutError) as e:
+            progress.record(entry, 'failed', str(e))
+            counts['failed'] += 1
+            if stop_on_error:
+                raise
+            continue
+
+        progress.record(entry, 'sent', message)
+        counts['sent'] += 1
+        if delta:
+            base = job.payload(entry)
+
+    return counts
+
+
+def main() -> None:
+    parser = argparse.ArgumentParser(
+        description='Sends a ttgo-fsk-tx job file in one serial session, resuming where it stopped.')
+    parser.add_argument('port', help='Serial port device (e.g., /dev/ttyUSB0, COM3)')
+    parser.add_argument('job', type=Path, help='Job file (built with jobfile.py)')
+    parser.add_argument('-b', '--baud', type=int, metavar='RATE', default=DEFAULT_BAUD,
+                        help=f'Serial baud rate (default: {DEFAULT_BAUD})')
+    parser.add_argument('-t', '--timeout', type=float, metavar='SECONDS', default=DEFAULT_TIMEOUT,
+                        help=f'Response timeout in seconds (default: {DEFAULT_TIMEOUT})')
+    parser.add_argument('--progress', type=Path, metavar='FILE',
+                        help='Progress file (default: the job file with .progress appended)')
+    parser.add_argument('--restart', action='store_true',
+                        help='Discard recorded progress and send every entry')
+    parser.add_argument('--retries', type=int, default=2,
+                        help='Retries after a timeout, for entries with a key (default: 2)')
+    parser.add_argument('--stop-on-error', action='store_true',
+                        help='Stop at the first failed entry instead of continuing')
+    parser.add_argument('--no-delta', action='store_true',
+                        help='Always upload whole payloads, never only the changes since the previous one')
+    parser.add_argument('--wake', action='store_true',
+                        help='Send a wake-up newline first (device idle mode 2, light sleep)')
+    parser.add_argument('--heartbeat', type=int, metavar='MS', default=0,
+                        help='Have the device send a heartbeat every MS milliseconds and treat '
+                             'three missed beats as a timeout')
+    parser.add_argument('-v', '--verbose', action='store_true', help='Enable verbose logging')
+    args = parser.parse_args()
+
+    if args.heartbeat and not (HEARTBEAT_MIN_MS <= args.heartbeat <= HEARTBEAT_MAX_MS):
+        parser.error(f'--heartbeat must be between {HEARTBEAT_MIN_MS} and {HEARTBEAT_MAX_MS} ms')
+
+    if args.verbose:
+        logging.getLogger().setLevel(logging.DEBUG)
+
+    try:
+        with JobFile(args.job) as job:
+            progress = Progress(args.progress or Path(str(args.job) + '.progress'),
+                                job.job_id, args.restart)
+            try:
+                logger.info(f"Job {job.job_id}: {len(job.entries)} entries")
+                ser = validate_serial_port(args.port, args.baud)
+                try:
+                    drain_startup(ser, timeout=0.5)
+                    if args.wake:
+                        wake_device(ser)
+                    if args.heartbeat:
+                        enable_heartbeat(ser, args.heartbeat, args.timeout)
+                    configure_job(ser, job, args.timeout)
+                    counts = run_job(ser, job, progress, args.timeout, args.retries,
+                                     args.stop_on_error, not args.no_delta)
+                finally:
+                    ser.close()
+            finally:
+                progress.close()
+
+        logger.info(f"Job finished: {counts['sent']} sent, {counts['failed']} failed, "
+                    f"{counts['skipped']} sent earlier")
+        sys.exit(1 if counts['failed'] else 0)
+
+    except KeyboardInterrupt:
+        logger.info("Interrupted; run again to resume")
+        sys.exit(130)
+    except (OSError, ValueError, RuntimeError, TimeoutError, serial.SerialException) as e:
+        logger.error(f"Job failed: {e}")
+        sys.exit(1)
+
+
+if __name__ == '__main__':
+    main()
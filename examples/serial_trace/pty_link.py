@@ -0,0 +1,54 @@
+"""
+Pseudo-terminal helpers shared by record.py and replay.py.
+
+Host tools open the PTY slave as if it were the device's serial port. The
+master side watches the slave's termios settings to follow baud changes.
+"""
+
+from __future__ import annotations
+
+import os
+import termios
+import tty
+from typing import Dict, Optional, Tuple
+
+import serial
+
+# termios speed constant to baud rate, for the rates pyserial knows on this platform
+SPEED_TO_BAUD: Dict[int, int] = {v: k for k, v in getattr(serial.Serial, 'BAUDRATE_CONSTANTS', {}).items()}
+
+
+def open_pty(baud: int, link: Optional[str] = None) -> Tuple[int, int, str]:
+    """
+    Create a raw PTY pair.
+
+    Args:
+        baud: Initial baud rate, so a tool opening the PTY at it is not seen as a change
+        link: Optional path of a symlink to create to the slave device
+
+    Returns:
+        Master fd, slave fd and the path host tools should open. The slave fd
+        is kept open so the master does not see EIO while no tool is connected.
+    """
+    master, slave = os.openpty()
+    tty.setraw(slave)
+
+    speed = {k: v for v, k in SPEED_TO_BAUD.items()}.get(baud)
+    if speed is not None:
+        attrs = termios.tcgetattr(slave)
+        attrs[4] = attrs[5] = speed
+        termios.tcsetattr(slave, termios.TCSANOW, attrs)
+    path = os.ttyname(slave)
+
+    if link:
+        if os.path.islink(link):
+            os.unlink(link)
+        os.symlink(path, link)
+        path = link
+
+    return master, slave, path
+
+
+def pty_baud(master: int) -> Optional[int]:
+    """Baud rate the host has set on the slave, or None if it is non-standard."""
+    return SPEED_TO_BAUD.get(termios.tcgetattr(master)[5])
@@ -0,0 +1,135 @@
+#!/usr/bin/env python3
+"""
+Serial Session Recorder for ttgo-fsk-tx
+
+Sits between a host tool and a real device: the tool opens the PTY printed at
+startup instead of the device's port, and every byte in both directions is
+forwarded and written to a trace file (see tracefile.py) with its timing. Baud
+rate changes made by the tool (e.g. by provision.py) are applied to the device
+port and recorded too. DTR resets cannot pass through a PTY; use --reset to
+reset the device before the session starts.
+
+Stop recording with Ctrl-C, or after --duration seconds.
+"""
+
+from __future__ import annotations
+
+import argparse
+import logging
+import os
+import select
+import sys
+import time
+from pathlib import Path
+
+import serial
+
+from pty_link import open_pty, pty_baud
+from tracefile import DEVICE, HOST, TraceWriter
+
+DEFAULT_BAUD = 115200
+POLL_INTERVAL = 0.01  # select timeout, also how often baud changes are checked
+READ_SIZE = 4096
+DTR_TOGGLE_DELAY = 0.1
+DEVICE_RESET_DELAY = 2.0
+
+logging.basicConfig(
+    level=logging.INFO,
+    format='%(asctime)s - %(levelname)s - %(message)s',
+    datefmt='%Y-%m-%d %H:%M:%S'
+)
+logger = logging.getLogger(__name__)
+
+
+def clock_us() -> int:
+    return time.monotonic_ns() // 1000
+
+
+def record(ser: serial.Serial, master: int, writer: TraceWriter, duration: float) -> None:
+    """
+    Forward traffic between the PTY master and the device until interrupted.
+
+    Args:
+        ser: Open connection to the device
+        master: PTY master fd
+        writer: Trace to record into
+        duration: Seconds to record for, or 0 for no limit
+    """
+    counts = {HOST: 0, DEVICE: 0}
+    baud = ser.baudrate
+    deadline = time.monotonic() + duration if duration > 0 else None
+
+    try:
+        while deadline is None or time.monotonic() < deadline:
+            # Follow the tool's baud rate before forwarding anything sent at it
+            new_baud = pty_baud(master)
+            if new_baud is not None and new_baud != baud:
+                ser.flush()
+                ser.baudrate = new_baud
+                writer.write_baud(new_baud, clock_us())
+                logger.info(f"Baud rate changed to {new_baud}")
+                baud = new_baud
+
+            readable, _, _ = select.select([master, ser.fileno()], [], [], POLL_INTERVAL)
+
+            if master in readable:
+                data = os.read(master, READ_SIZE)
+                writer.write(HOST, data, clock_us())
+                ser.write(data)
+                counts[HOST] += len(data)
+
+            if ser.fileno() in readable:
+                data = ser.read(ser.in_waiting or 1)
+                if data:
+                    writer.write(DEVICE, data, clock_us())
+                    os.write(master, data)
+                    counts[DEVICE] += len(data)
+    except KeyboardInterrupt:
+        pass
+
+    logger.info(f"Recorded {counts[HOST]} host bytes and {counts[DEVICE]} device bytes")
+
+
+def main() -> None:
+    """
+    Main application entry point.
+    """
+    parser = argparse.ArgumentParser(description='Records a ttgo-fsk-tx serial session through a PTY.')
+    parser.add_argument('port', help='Device serial port (e.g., /dev/ttyUSB0, COM3)')
+    parser.add_argument('trace', type=Path, help='Trace file to write')
+    parser.add_argument('-b', '--baud', type=int, default=DEFAULT_BAUD, help=f'Initial baud rate (default: {DEFAULT_BAUD})')
+    parser.add_argument('--link', help='Create a symlink to the PTY at this path')
+    parser.add_argument('--duration', type=float, default=0, help='Stop after this many seconds (default: until Ctrl-C)')
+    parser.add_argument('--reset', action='store_true', help='Reset the device with DTR before recording')
+    args = parser.parse_args()
+
+    try:
+        ser = serial.Serial(args.port, args.baud, timeout=0)
+    except serial.SerialException as e:
+        logger.error(f"Cannot open {args.port}: {e}")
+        sys.exit(1)
+
+    master, slave, path = open_pty(args.baud, args.link)
+
+    try:
+        if args.reset:
+            ser.dtr = False
+            time.sleep(DTR_TOGGLE_DELAY)
+            ser.dtr = True
+            time.sleep(DEVICE_RESET_DELAY)
+            ser.reset_input_buffer()
+
+        with args.trace.open('wb') as out:
+            writer = TraceWriter(out, args.baud, clock_us())
+            logger.info(f"Recording {args.port} to {args.trace}, connect the host tool to {path}")
+            record(ser, master, writer, args.duration)
+    finally:
+        ser.close()
+        os.close(master)
+        os.close(slave)
+        if args.link:
+            os.unlink(args.link)
+
+
+if __name__ == '__main__':
+    main()
@@ -0,0 +1,186 @@
+#!/usr/bin/env python3
+"""
+Serial Session Replayer for ttgo-fsk-tx
+
+Impersonates a device on a PTY using a trace written by record.py, so host
+tools can be exercised and timed without hardware. Host tools open the PTY
+printed at startup as their serial port.
+
+Each device chunk is written once the host has sent everything that preceded
+it in the trace, after the recorded gap divided by --speed. Host bytes are
+checked against the trace; a mismatch means the tool under test no longer
+behaves like the recorded one. At the end, the replayed duration is compared
+with the recorded one, scaled by --speed.
+
+Exits non-zero if the host diverged from the trace or stopped sending.
+"""
+
+from __future__ import annotations
+
+import argparse
+import logging
+import os
+import select
+import sys
+import time
+from pathlib import Path
+
+from pty_link import open_pty, pty_baud
+from tracefile import BAUD, DEVICE, HOST, KIND_NAMES, TraceReader
+
+DEFAULT_TIMEOUT = 30.0  # Longest wait for host bytes before giving up
+DEFAULT_LINGER = 1.0  # Time the PTY stays open after the last record
+BAUD_POLL_INTERVAL = 0.001  # How often a pending host baud change is checked
+
+logging.basicConfig(
+    level=logging.INFO,
+    format='%(asctime)s - %(levelname)s - %(message)s',
+    datefmt='%Y-%m-%d %H:%M:%S'
+)
+logger = logging.getLogger(__name__)
+
+
+def read_exact(master: int, length: int, timeout: float) -> bytes:
+    """
+    Read length bytes from the host.
+
+    Raises:
+        TimeoutError: If the host sends fewer bytes within timeout
+    """
+    data = bytearray()
+    deadline = time.monotonic() + timeout
+
+    while len(data) < length:
+        remaining = deadline - time.monotonic()
+        if remaining <= 0 or not select.select([master], [], [], remaining)[0]:
+            raise TimeoutError(f'Host sent {len(data)} of {length} expected bytes')
+        data += os.read(master, length - len(data))
+
+    return bytes(data)
+
+
+def replay(reader: TraceReader, master: int, speed: float, timeout: float, strict: bool) -> int:
+    """
+    Play the device side of a trace against the host on the PTY master.
+
+    Args:
+        reader: Trace to replay
+        master: PTY master fd
+        speed: Time scale; 2.0 replays device responses twice as fast
+        timeout: Longest wait for host bytes
+        strict: Stop at the first host mismatch
+
+    Returns:
+        Number of host chunks and baud changes that did not match the trace
+
+    Raises:
+        TimeoutError: If the host stops sending before the trace ends
+    """
+    mismatches = 0
+    recorded_us = 0
+    offsets = {HOST: 0, DEVICE: 0}
+    start = None  # timing starts at the first record, so connecting is not counted
+    anchor = time.monotonic()  # when the previous record completed
+
+    for record in reader:
+        if start is not None:
+            recorded_us += record.delta_us
+
+        if record.kind == DEVICE:
+            delay = anchor + record.delta_us / 1e6 / speed - time.monotonic()
+            if delay > 0:
+                time.sleep(delay)
+            os.write(master, record.data)
+
+        elif record.kind == HOST:
+            data = read_exact(master, len(record.data), timeout)
+            if data != record.data:
+                mismatches += 1
+                logger.warning(f"Host bytes differ from the trace at host offset {offsets[HOST]}: "
+                               f"expected {record.data[:32]!r}, got {data[:32]!r}")
+                if strict:
+                    break
+
+        elif record.kind == BAUD:
+            # The host may still be reading the response that made it switch
+            deadline = time.monotonic() + timeout
+            while pty_baud(master) != record.baud and time.monotonic() < deadline:
+                time.sleep(BAUD_POLL_INTERVAL)
+            if pty_baud(master) != record.baud:
+                mismatches += 1
+                logger.warning(f"Trace switches to {record.baud} baud, host stayed at {pty_baud(master)}")
+                if strict:
+                    break
+
+        offsets[record.kind] = offsets.get(record.kind, 0) + len(record.data)
+        anchor = time.monotonic()
+        if start is None:
+            start = anchor
+
+    elapsed = time.monotonic() - start if start is not None else 0.0
+    target = recorded_us / 1e6 / speed
+    logger.info(f"Replayed {offsets[HOST]} host and {offsets[DEVICE]} device bytes in {elapsed:.3f} s "
+                f"(trace {recorded_us / 1e6:.3f} s, {target:.3f} s at {speed:g}x, "
+                f"host overhead {elapsed - target:+.3f} s)")
+
+    return mismatches
+
+
+def dump(reader: TraceReader) -> None:
+    """Print a trace in readable form."""
+    clock_us = 0
+    print(f"baud {reader.baud}")
+    for record in reader:
+        clock_us += record.delta_us
+        payload = str(record.baud) if record.kind == BAUD else repr(record.data)
+        print(f"{clock_us / 1e6:12.6f} {KIND_NAMES[record.kind]:6} {payload}")
+
+
+def main() -> None:
+    """
+    Main application entry point.
+    """
+    parser = argparse.ArgumentParser(description='Replays a recorded ttgo-fsk-tx session on a PTY.')
+    parser.add_argument('trace', type=Path, help='Trace file written by record.py')
+    parser.add_argument('-s', '--speed', type=float, default=1.0, help='Replay N times faster (default: 1.0)')
+    parser.add_argument('--link', help='Create a symlink to the PTY at this path')
+    parser.add_argument('--timeout', type=float, default=DEFAULT_TIMEOUT,
+                        help=f'Seconds to wait for host bytes (default: {DEFAULT_TIMEOUT})')
+    parser.add_argument('--linger', type=float, default=DEFAULT_LINGER,
+                        help=f'Seconds to keep the PTY open after the trace ends (default: {DEFAULT_LINGER})')
+    parser.add_argument('--strict', action='store_true', help='Stop at the first host mismatch')
+    parser.add_argument('--dump', action='store_true', help='Print the trace instead of replaying it')
+    args = parser.parse_args()
+
+    if args.speed <= 0:
+        parser.error('Speed must be positive')
+
+    try:
+        with args.trace.open('rb') as src:
+            reader = TraceReader(src)
+
+            if args.dump:
+                dump(reader)
+                return
+
+            master, slave, path = open_pty(reader.baud, args.link)
+            try:
+                logger.info(f"Replaying {args.trace} at {args.speed:g}x, connect the host tool to {path}")
+                mismatches = replay(reader, master, args.speed, args.timeout, args.strict)
+                time.sleep(args.linger)
+            finally:
+                os.close(master)
+                os.close(slave)
+                if args.link:
+                    os.unlink(args.link)
+    except (OSError, ValueError, TimeoutError) as e:
+        logger.error(f"Replay failed: {e}")
+        sys.exit(1)
+
+    if mismatches:
+        logger.error(f"{mismatches} host chunks or baud changes differed from the trace")
+        sys.exit(1)
+
+
+if __name__ == '__main__':
+    main()
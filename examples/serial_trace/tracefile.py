@@ -0,0 +1,129 @@
+"""
+Serial Session Trace Format for ttgo-fsk-tx
+
+A trace holds every byte exchanged with a device, in both directions, with
+microsecond timing. It is written by record.py and read by replay.py.
+
+Layout (integers are little-endian, varints are unsigned LEB128):
+    header  b'TTGOTRC1' + uint32 initial baud rate
+    record  varint (delta_us << 2 | kind), varint length, length bytes
+
+delta_us is the time since the previous record. kind is one of
+HOST (host to device), DEVICE (device to host) or BAUD (the host changed
+the baud rate, payload is the new rate as uint32).
+"""
+
+from __future__ import annotations
+
+import struct
+from dataclasses import dataclass
+from typing import BinaryIO, Iterator, Optional
+
+MAGIC = b'TTGOTRC1'
+
+HOST = 0
+DEVICE = 1
+BAUD = 2
+
+KIND_NAMES = {HOST: 'host', DEVICE: 'device', BAUD: 'baud'}
+
+
+@dataclass
+class TraceRecord:
+    """One chunk of traffic or a baud rate change."""
+    delta_us: int
+    kind: int
+    data: bytes
+
+    @property
+    def baud(self) -> int:
+        """New baud rate of a BAUD record."""
+        return struct.unpack('<I', self.data)[0]
+
+
+def _write_varint(out: BinaryIO, value: int) -> None:
+    encoded = bytearray()
+    while True:
+        byte = value & 0x7F
+        value >>= 7
+        if value:
+            encoded.append(byte | 0x80)
+        else:
+            encoded.append(byte)
+            break
+    out.write(encoded)
+
+
+def _read_varint(src: BinaryIO) -> Optional[int]:
+    value = 0
+    shift = 0
+    while True:
+        byte = src.read(1)
+        if not byte:
+            if shift:
+                raise ValueError('Trace truncated inside a varint')
+            return None
+        value |= (byte[0] & 0x7F) << shift
+        if not byte[0] & 0x80:
+            return value
+        shift += 7
+
+
+class TraceWriter:
+    """
+    Appends records to a trace file, timing them against a monotonic clock.
+
+    Args:
+        out: Binary file opened for writing
+        baud: Baud rate the session starts at
+        clock_us: Time of the session start in microseconds
+    """
+
+    def __init__(self, out: BinaryIO, baud: int, clock_us: int):
+        self.out = out
+        self.last_us = clock_us
+        out.write(MAGIC + struct.pack('<I', baud))
+
+    def write(self, kind: int, data: bytes, clock_us: int) -> None:
+        """Record data of the given kind seen at clock_us."""
+        delta_us = max(0, clock_us - self.last_us)
+        self.last_us = clock_us
+        _write_varint(self.out, delta_us << 2 | kind)
+        _write_varint(self.out, len(data))
+        self.out.write(data)
+
+    def write_baud(self, baud: int, clock_us: int) -> None:
+        """Record a baud rate change."""
+        self.write(BAUD, struct.pack('<I', baud), clock_us)
+
+
+class TraceReader:
+    """
+    Reads a trace file written by TraceWriter.
+
+    Args:
+        src: Binary file opened for reading
+
+    Raises:
+        ValueError: If the file is not a trace
+    """
+
+    def __init__(self, src: BinaryIO):
+        self.src = src
+        header = src.read(len(MAGIC) + 4)
+        if len(header) != len(MAGIC) + 4 or header[:len(MAGIC)] != MAGIC:
+            raise ValueError('Not a serial trace file')
+        self.baud = struct.unpack('<I', header[len(MAGIC):])[0]
+
+    def __iter__(self) -> Iterator[TraceRecord]:
+        while True:
+            tag = _read_varint(self.src)
+            if tag is None:
+                return
+            length = _read_varint(self.src)
+            if length is None:
+                raise ValueError('Trace truncated before a record length')
+            data = self.src.read(length)
+            if len(data) != length:
+                raise ValueError('Trace truncated inside a record')
+            yield TraceRecord(tag >> 2, tag & 3, data)
@@ -0,0 +1,148 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <deque>
+#include <functional>
+#include <memory>
+#include <string>
+
+#include "ttgo/mapped_file.h"
+
+namespace ttgo
+{
+
+// Largest payload of one 'm' command (console.cpp)
+constexpr size_t MAX_MESSAGE = 2048;
+
+// Device UART receive buffer (SERIAL_RX_BUFFER_SIZE in defaults.h). Bytes
+// pipelined ahead of the console must fit in it.
+constexpr size_t DEVICE_RX_BUFFER = 8448;
+
+// Result codes: non-negative values are the device's TX codes, negative ones
+// are raised by the client
+enum
+{
+    RESULT_OK = 0,            // TX:0 transmitted
+    RESULT_START_FAILED = 1,  // TX:1 radio failed to start
+    RESULT_CHANNEL_BUSY = 2,  // TX:2 listen-before-talk gave up
+    RESULT_INTERRUPTED = 3,   // TX:3 a reset interrupted the original attempt
+    RESULT_REJECTED = -1,     // the console answered with a non-zero CONSOLE code
+    RESULT_LINK_ERROR = -2,   // the serial link failed or was closed
+    RESULT_TIMEOUT = -3       // no progress within response_timeout_ms
+};
+
+struct Result
+{
+    int code;
+    std::string message;  // the device line that completed the request
+    uint64_t latency_us;  // from submission to completion
+};
+
+using Callback = std::function<void(const Result &)>;
+
+struct ClientOptions
+{
+    size_t window_bytes = DEVICE_RX_BUFFER;  // unconsumed bytes allowed on the link
+    int response_timeout_ms = 30000;         // fail everything in flight after this long without progress
+                                             // (any input; with the device heartbeat on, a few intervals)
+    bool wake = false;                       // wake the device from light sleep after idle periods
+    int wake_after_ms = 500;                 // idle time after which the device may sleep (IDLE_AFTER_MS)
+    int wake_delay_us = 5000;                // pause between the wake newline and the next command
+};
+
+// Asynchronous client for the device's serial console. Requests are queued
+// and written as the device's receive buffer allows, so the next command and
+// payload are already waiting when the console comes back from a
+// transmission. Responses are matched to requests in order.
+//
+// I/O is non-blocking and driven by an internal epoll set. Callers either run
+// run_once()/run_until_idle() themselves or add epoll_fd() to their own event
+// loop and call run_once(0) when it becomes readable.
+class FskClient
+{
+public:
+    // Takes ownership of a non-blocking serial (or socket) descriptor
+    explicit FskClient(int fd, const ClientOptions &options = ClientOptions());
+    ~FskClient();
+
+    FskClient(const FskClient &) = delete;
+    FskClient &operator=(const FskClient &) = delete;
+
+    // Queues a transmission of caller-owned data, which must stay valid until
+    // the callback runs. A non-zero id lets the device recognise a retry.
+    // Returns false if the payload is empty or longer than MAX_MESSAGE.
+    bool send(const uint8_t *data, size_t length, Callback done, uint32_t id = 0);
+
+    // Queues a transmission of part of a mapped file
+    bool send(std::shared_ptr<MappedFile> file, size_t offset, size_t length, Callback done, uint32_t id = 0);
+
+    // Queues a single-line console command such as "f 916.0". The callback
+    // gets RESULT_OK or RESULT_REJECTED with the device's CONSOLE line.
+    bool command(const std::string &line, Callback done);
+
+    // Waits up to timeout_ms (-1 for no limit) for I/O and processes it.
+    // Returns false once the link has failed.
+    bool run_once(int timeout_ms);
+
+    // Runs until every queued request has completed. Returns false on link failure.
+    bool run_until_idle();
+
+    size_t pending() const { return requests.size(); }
+    int epoll_fd() const { return epoll; }
+
+private:
+    enum request_kind
+    {
+        REQUEST_COMMAND,
+        REQUEST_MESSAGE
+    };
+
+    enum request_state
+    {
+        AWAIT_WAITING,   // command line sent, "Waiting for" not seen yet
+        AWAIT_ACCEPTED,  // payload consumed by the device once "Accepted" arrives
+        AWAIT_RESULT     // TX (or CONSOLE, for commands) result line pending
+    };
+
+    struct request
+    {
+        request_kind kind;
+        request_state state;
+        std::string header;               // command line including newline
+        const uint8_t *payload;
+        size_t payload_length;
+        std::shared_ptr<MappedFile> file;  // keeps mapped payloads alive
+        bool gated;                        // payload waits for "Waiting for" (retries may be answered without it)
+        size_t written;                    // bytes of header + payload written so far
+        Callback done;
+        uint64_t submitted_us;
+    };
+
+    bool enqueue(request &&req);
+    void flush_output();
+    void handle_input();
+    void handle_line(const std::string &line);
+    void skip_payload(request &req);
+    void complete(int code, const std::string &message);
+    void fail_all(int code, const std::string &message);
+    void update_events();
+    int next_timeout_ms(int timeout_ms) const;
+
+    int fd;
+    int epoll;
+    ClientOptions options;
+    std::deque<request> requests;  // oldest first; responses belong to the front
+    size_t write_index = 0;        // first request not completely written
+    size_t unconsumed_bytes = 0;   // written but not yet read by the device console
+    bool want_write = false;       // output is blocked until the descriptor becomes writable
+    bool events_write = false;     // EPOLLOUT is currently registered
+    bool failed = false;
+    std::string input;             // partial response line
+    uint64_t last_write_us = 0;
+    uint64_t last_progress_us = 0;
+    uint64_t hold_until_us = 0;    // output paused while the device wakes
+};
+
+}
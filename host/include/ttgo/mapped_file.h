@@ -0,0 +1,31 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <memory>
+
+namespace ttgo
+{
+
+// Read-only memory mapping of a whole file. Payloads can be sent straight from
+// the mapping; the client keeps a reference until they have been written.
+class MappedFile
+{
+public:
+    // Returns nullptr with errno set if the file cannot be opened or mapped
+    static std::shared_ptr<MappedFile> open(const char *path);
+
+    ~MappedFile();
+
+    const uint8_t *data() const { return bytes; }
+    size_t size() const { return length; }
+
+private:
+    MappedFile(const uint8_t *bytes, size_t length);
+
+    const uint8_t *bytes;
+    size_t length;
+};
+
+}
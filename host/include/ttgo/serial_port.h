@@ -0,0 +1,8 @@
+#pragma once
+
+// Opens a serial device in raw, non-blocking mode at the given baud rate.
+// Returns the file descriptor, or -1 with errno set.
+int serial_open(const char *path, int baud);
+
+// Changes the baud rate of an open serial device. Returns false with errno set on failure.
+bool serial_set_baud(int fd, int baud);
@@ -0,0 +1,140 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <condition_variable>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "ttgo/client.h"
+
+namespace ttgo
+{
+
+struct SpoolOptions
+{
+    size_t max_batch_bytes = 4 << 20;    // journal bytes written with one fdatasync at most
+    int commit_delay_us = 0;             // extra wait for more submissions before a commit; 0 commits at once
+    size_t compact_min_bytes = 16 << 20; // journal size before compaction is considered
+    double compact_garbage = 0.5;        // compact once completed records make up this share of the journal
+    bool sync = true;                    // fdatasync every batch; off only for tests
+};
+
+struct SpoolStats
+{
+    uint64_t submitted;
+    uint64_t completed;
+    uint64_t batches;        // group commits, one fdatasync each
+    uint64_t compactions;
+    uint64_t recovered;      // pending entries found in the journal at open
+    uint64_t truncated_bytes; // torn or corrupt tail dropped at open
+    uint64_t journal_bytes;
+};
+
+// Durable queue of pending transmissions: an append-only journal of submit
+// and completion records. A writer thread commits everything submitted while
+// the previous fdatasync ran in one batch (group commit), so intake is bounded
+// by disk bandwidth rather than sync latency. Opening a journal replays it and
+// keeps the entries that were committed but never completed. Once completed
+// records make up most of the journal, it is rewritten with only the pending
+// entries and renamed over the old one.
+//
+// Completion records are committed with the next batch; an entry completed
+// just before a crash is sent again after recovery. Give entries a message ID
+// so the device answers such a resend without transmitting twice.
+class Spool
+{
+public:
+    // Opens or creates a journal and replays it. Returns nullptr with errno set on failure.
+    static std::unique_ptr<Spool> open(const std::string &path, const SpoolOptions &options = SpoolOptions());
+
+    // Commits what is still buffered and stops the writer
+    ~Spool();
+
+    Spool(const Spool &) = delete;
+    Spool &operator=(const Spool &) = delete;
+
+    // Queues a payload of 1 to MAX_MESSAGE bytes and returns its sequence
+    // number, or 0 if the payload is invalid or the journal has failed.
+    // Safe to call from any thread.
+    uint64_t submit(const uint8_t *data, size_t length, uint32_t id = 0);
+
+    // Blocks until `seq` is on disk. Returns false if the journal has failed.
+    bool wait_durable(uint64_t seq);
+
+    // Drops a finished entry. Its payload must no longer be in use.
+    void complete(uint64_t seq);
+
+    struct entry
+    {
+        uint64_t seq;
+        uint32_t id;
+        std::vector<uint8_t> data;
+    };
+
+    // Appends up to `max` committed, pending entries after `after`, oldest
+    // first. Entries stay valid until they are completed.
+    size_t next(uint64_t after, size_t max, std::vector<const entry *> &out);
+
+    size_t pending() const;
+    SpoolStats stats() const;
+    bool failed() const;
+
+private:
+    Spool(const std::string &path, int fd, const SpoolOptions &options);
+
+    bool replay(uint64_t &valid_length);
+    void run_writer();
+    bool compact();
+
+    std::string path;
+    int fd;
+    SpoolOptions options;
+
+    mutable std::mutex lock;
+    std::condition_variable work;     // records buffered, or shutting down
+    std::condition_variable durable;  // committed_seq advanced, or the journal failed
+    std::map<uint64_t, entry> entries; // pending, by sequence number
+    std::vector<uint8_t> buffer;      // records not yet handed to the writer
+    uint64_t last_seq = 0;
+    uint64_t buffered_seq = 0;        // highest sequence number in `buffer`
+    uint64_t committed_seq = 0;       // every submission up to here is on disk
+    uint64_t live_bytes = 0;          // journal bytes of pending entries
+    bool stopping = false;
+    bool io_failed = false;
+    SpoolStats counters = {};
+    std::thread writer;
+};
+
+// Sends committed spool entries through a client in sequence order, with up
+// to `depth` in flight, and completes each once the device has answered it.
+// Entries that fail on the link stay in the spool for the next run.
+class SpoolFeeder
+{
+public:
+    SpoolFeeder(Spool &spool, FskClient &client, size_t depth = 16);
+
+    // Queues newly committed entries. Call from the client's loop.
+    void pump();
+
+    size_t in_flight() const { return outstanding; }
+    uint64_t sent() const { return answered; }
+    uint64_t failed() const { return link_failures; }
+
+private:
+    Spool &spool;
+    FskClient &client;
+    size_t depth;
+    uint64_t last_queued = 0;
+    size_t outstanding = 0;
+    uint64_t answered = 0;
+    uint64_t link_failures = 0;
+    std::vector<const Spool::entry *> batch;
+};
+
+}
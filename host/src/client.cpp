@@ -0,0 +1,497 @@
+#include <errno.h>
+#include <string.h>
+#include <sys/epoll.h>
+#include <sys/uio.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "ttgo/client.h"
+
+namespace ttgo
+{
+
+// Most iovecs handed to one writev call
+static const int IOV_BATCH = 16;
+
+static uint64_t now_us()
+{
+    timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+static bool starts_with(const std::string &text, size_t offset, const char *prefix)
+{
+    return text.compare(offset, strlen(prefix), prefix) == 0;
+}
+
+FskClient::FskClient(int fd, const ClientOptions &options) : fd(fd), options(options)
+{
+    epoll = epoll_create1(EPOLL_CLOEXEC);
+
+    epoll_event event = {};
+    event.events = EPOLLIN;
+    event.data.fd = fd;
+
+    if (epoll < 0 || epoll_ctl(epoll, EPOLL_CTL_ADD, fd, &event) < 0)
+    {
+        failed = true;
+    }
+
+    last_progress_us = now_us();
+}
+
+FskClient::~FskClient()
+{
+    if (epoll >= 0)
+    {
+        close(epoll);
+    }
+    close(fd);
+}
+
+bool FskClient::send(const uint8_t *data, size_t length, Callback done, uint32_t id)
+{
+    if (data == nullptr || length == 0 || length > MAX_MESSAGE)
+    {
+        return false;
+    }
+
+    request req = {};
+    req.kind = REQUEST_MESSAGE;
+    req.state = AWAIT_WAITING;
+    req.header = "m " + std::to_string(length) + (id ? " " + std::to_string(id) : std::string()) + "\n";
+    req.payload = data;
+    req.payload_length = length;
+    req.gated = id != 0; // a retried ID is answered without reading the payload
+    req.done = std::move(done);
+
+    return enqueue(std::move(req));
+}
+
+bool FskClient::send(std::shared_ptr<MappedFile> file, size_t offset, size_t length, Callback done, uint32_t id)
+{
+    if (!file || offset > file->size() || length > file->size() - offset)
+    {
+        return false;
+    }
+
+    const uint8_t *data = file->data() + offset;
+    if (!send(data, length, std::move(done), id))
+    {
+        return false;
+    }
+
+    requests.back().file = std::move(file);
+    return true;
+}
+
+bool FskClient::command(const std::string &line, Callback done)
+{
+    if (line.empty() || line.find('\n') != std::string::npos)
+    {
+        return false;
+    }
+
+    request req = {};
+    req.kind = REQUEST_COMMAND;
+    req.state = AWAIT_RESULT;
+    req.header = line + "\n";
+    req.done = std::move(done);
+
+    return enqueue(std::move(req));
+}
+
+bool FskClient::enqueue(request &&req)
+{
+    if (failed)
+    {
+        return false;
+    }
+
+    // Nothing was in flight, so the response timeout starts now
+    if (requests.empty())
+    {
+        last_progress_us = now_us();
+    }
+
+    req.submitted_us = now_us();
+    requests.push_back(std::move(req));
+    flush_output();
+
+    return true;
+}
+
+// Writes as much queued output as the device's receive buffer and gated
+// payloads allow, batching several requests into one writev
+void FskClient::flush_output()
+{
+    while (!failed)
+    {
+        uint64_t now = now_us();
+
+        if (now < hold_until_us || write_index >= requests.size())
+        {
+            break;
+        }
+
+        // The first byte after an idle period only wakes the device and is lost
+        if (options.wake && unconsumed_bytes == 0 && requests[write_index].written == 0 &&
+            now - last_write_us > (uint64_t)options.wake_after_ms * 1000)
+        {
+            static const char newline = '\n';
+            ssize_t n = write(fd, &newline, 1);
+            if (n == 1)
+            {
+                last_write_us = now;
+                hold_until_us = now + options.wake_delay_us;
+                continue;
+            }
+            if (n < 0 && errno != EAGAIN && errno != EINTR)
+            {
+                fail_all(RESULT_LINK_ERROR, strerror(errno));
+            }
+            want_write = n < 0 && errno == EAGAIN;
+            break;
+        }
+
+        iovec iov[IOV_BATCH];
+        int count = 0;
+        size_t planned = unconsumed_bytes;
+
+        for (size_t i = write_index; i < requests.size() && count < IOV_BATCH - 1; i++)
+        {
+            request &req = requests[i];
+            size_t header_length = req.header.size();
+            size_t total = header_length + req.payload_length;
+
+            // Start a request only if all of it fits in the device's receive buffer
+            if (req.written == 0 && planned > 0 && planned + total > options.window_bytes)
+            {
+                break;
+            }
+
+            if (req.written < header_length)
+            {
+                iov[count].iov_base = const_cast<char *>(req.header.data()) + req.written;
+                iov[count].iov_len = header_length - req.written;
+                count++;
+            }
+
+            // Nothing may follow a gated header until the device asks for its payload
+            if (req.gated && req.state == AWAIT_WAITING)
+            {
+                break;
+            }
+
+            size_t payload_written = req.written > header_length ? req.written - header_length : 0;
+            if (payload_written < req.payload_length)
+            {
+                iov[count].iov_base = const_cast<uint8_t *>(req.payload) + payload_written;
+                iov[count].iov_len = req.payload_length - payload_written;
+                count++;
+            }
+
+            planned += total - req.written;
+        }
+
+        if (count == 0)
+        {
+            want_write = false;
+            break;
+        }
+
+        ssize_t n = writev(fd, iov, count);
+        if (n < 0)
+        {
+            if (errno == EINTR)
+            {
+                continue;
+            }
+
+            want_write = errno == EAGAIN;
+            if (!want_write)
+            {
+                fail_all(RESULT_LINK_ERROR, strerror(errno));
+            }
+            break;
+        }
+
+        last_write_us = now;
+        last_progress_us = now;
+        unconsumed_bytes += n;
+
+        // Credit the written bytes to requests in order
+        size_t remaining = n;
+        for (size_t i = write_index; remaining > 0 && i < requests.size(); i++)
+        {
+            request &req = requests[i];
+            size_t total = req.header.size() + req.payload_length;
+            size_t step = std::min(remaining, total - req.written);
+
+            req.written += step;
+            remaining -= step;
+        }
+
+        while (write_index < requests.size() &&
+               requests[write_index].written == requests[write_index].header.size() + requests[write_index].payload_length)
+        {
+            write_index++;
+        }
+    }
+
+    update_events();
+}
+
+void FskClient::update_events()
+{
+    if (failed || want_write == events_write)
+    {
+        return;
+    }
+
+    epoll_event event = {};
+    event.events = want_write ? EPOLLIN | EPOLLOUT : EPOLLIN;
+    event.data.fd = fd;
+
+    if (epoll_ctl(epoll, EPOLL_CTL_MOD, fd, &event) == 0)
+    {
+        events_write = want_write;
+    }
+}
+
+void FskClient::handle_input()
+{
+    char buffer[4096];
+
+    while (!failed)
+    {
+        ssize_t n = read(fd, buffer, sizeof(buffer));
+        if (n < 0)
+        {
+            if (errno == EINTR)
+            {
+                continue;
+            }
+            if (errno != EAGAIN)
+            {
+                fail_all(RESULT_LINK_ERROR, strerror(errno));
+            }
+            return;
+        }
+        if (n == 0)
+        {
+            fail_all(RESULT_LINK_ERROR, "Serial link closed");
+            return;
+        }
+
+        last_progress_us = now_us();
+
+        for (ssize_t i = 0; i < n; i++)
+        {
+            char c = buffer[i];
+            if (c == '\n')
+            {
+                if (!input.empty() && input.back() == '\r')
+                {
+                    input.pop_back();
+                }
+                handle_line(input);
+                input.clear();
+            }
+            else
+            {
+                input += c;
+            }
+        }
+    }
+}
+
+// Responses arrive strictly in request order: the console handles one command
+// at a time and does not read the next until a transmission has finished
+void FskClient::handle_line(const std::string &line)
+{
+    size_t first = line.find(':');
+    size_t second = first == std::string::npos ? std::string::npos : line.find(':', first + 1);
+
+    if (second == std::string::npos || requests.empty())
+    {
+        return; // not a response, or unsolicited (FLEX frames, boot messages)
+    }
+
+    std::string prefix = line.substr(0, first);
+    int code = atoi(line.c_str() + first + 1);
+    size_t text = second + 1;
+    request &req = requests.front();
+
+    if (prefix == "CONSOLE")
+    {
+        if (req.kind == REQUEST_COMMAND)
+        {
+            unconsumed_bytes -= std::min(unconsumed_bytes, req.header.size());
+            complete(code == 0 ? RESULT_OK : RESULT_REJECTED, line);
+        }
+        else if (req.state == AWAIT_WAITING)
+        {
+            unconsumed_bytes -= std::min(unconsumed_bytes, req.header.size());
+
+            if (code == 0 && starts_with(line, text, "Waiting for"))
+            {
+                req.state = AWAIT_ACCEPTED;
+            }
+            else if (code == 0 && starts_with(line, text, "Duplicate of message"))
+            {
+                skip_payload(req);
+                req.state = AWAIT_RESULT; // the TX line replays the original result
+            }
+            else
+            {
+                skip_payload(req);
+                complete(RESULT_REJECTED, line);
+            }
+        }
+        else if (req.state == AWAIT_ACCEPTED && code == 0 && starts_with(line, text, "Accepted"))
+        {
+            unconsumed_bytes -= std::min(unconsumed_bytes, req.payload_length);
+            req.state = AWAIT_RESULT;
+        }
+    }
+    else if (prefix == "TX" && req.kind == REQUEST_MESSAGE && req.state == AWAIT_RESULT)
+    {
+        complete(code, line);
+    }
+
+    flush_output();
+}
+
+// Marks a gated payload as never to be sent
+void FskClient::skip_payload(request &req)
+{
+    if (req.gated && req.written <= req.header.size())
+    {
+        req.written = req.header.size() + req.payload_length;
+
+        while (write_index < requests.size() &&
+               requests[write_index].written == requests[write_index].header.size() + requests[write_index].payload_length)
+        {
+            write_index++;
+        }
+    }
+}
+
+void FskClient::complete(int code, const std::string &message)
+{
+    request req = std::move(requests.front());
+    requests.pop_front();
+    if (write_index > 0)
+    {
+        write_index--;
+    }
+
+    if (req.done)
+    {
+        req.done(Result{code, message, now_us() - req.submitted_us});
+    }
+}
+
+void FskClient::fail_all(int code, const std::string &message)
+{
+    std::deque<request> failed_requests;
+    failed_requests.swap(requests);
+
+    // The device's state is unknown, so start the link accounting afresh
+    write_index = 0;
+    unconsumed_bytes = 0;
+    input.clear();
+
+    if (code == RESULT_LINK_ERROR)
+    {
+        failed = true;
+    }
+
+    uint64_t now = now_us();
+    for (request &req : failed_requests)
+    {
+        if (req.done)
+        {
+            req.done(Result{code, message, now - req.submitted_us});
+        }
+    }
+}
+
+int FskClient::next_timeout_ms(int timeout_ms) const
+{
+    uint64_t now = now_us();
+    int64_t wait_us = timeout_ms < 0 ? -1 : (int64_t)timeout_ms * 1000;
+
+    if (hold_until_us > now && (wait_us < 0 || (int64_t)(hold_until_us - now) < wait_us))
+    {
+        wait_us = hold_until_us - now;
+    }
+
+    if (!requests.empty())
+    {
+        uint64_t deadline = last_progress_us + (uint64_t)options.response_timeout_ms * 1000;
+        int64_t until_deadline = deadline > now ? deadline - now : 0;
+        if (wait_us < 0 || until_deadline < wait_us)
+        {
+            wait_us = until_deadline;
+        }
+    }
+
+    return wait_us < 0 ? -1 : (int)((wait_us + 999) / 1000);
+}
+
+bool FskClient::run_once(int timeout_ms)
+{
+    if (failed)
+    {
+        return false;
+    }
+
+    flush_output();
+
+    epoll_event events[1];
+    int n = epoll_wait(epoll, events, 1, next_timeout_ms(timeout_ms));
+    if (n < 0 && errno != EINTR)
+    {
+        fail_all(RESULT_LINK_ERROR, strerror(errno));
+        return false;
+    }
+
+    if (n > 0)
+    {
+        if (events[0].events & (EPOLLIN | EPOLLHUP | EPOLLERR))
+        {
+            handle_input();
+        }
+        if (events[0].events & EPOLLOUT)
+        {
+            want_write = false;
+            flush_output();
+        }
+    }
+
+    if (!requests.empty() && now_us() - last_progress_us >= (uint64_t)options.response_timeout_ms * 1000)
+    {
+        fail_all(RESULT_TIMEOUT, "No response from device");
+    }
+
+    flush_output();
+    return !failed;
+}
+
+bool FskClient::run_until_idle()
+{
+    while (!requests.empty())
+    {
+        if (!run_once(-1))
+        {
+            return false;
+        }
+    }
+
+    return !failed;
+}
+
+}
@@ -0,0 +1,61 @@
+#include <errno.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "ttgo/mapped_file.h"
+
+namespace ttgo
+{
+
+std::shared_ptr<MappedFile> MappedFile::open(const char *path)
+{
+    int fd = ::open(path, O_RDONLY | O_CLOEXEC);
+    if (fd < 0)
+    {
+        return nullptr;
+    }
+
+    struct stat info;
+    if (fstat(fd, &info) < 0)
+    {
+        int saved = errno;
+        close(fd);
+        errno = saved;
+        return nullptr;
+    }
+
+    // Empty files cannot be mapped, but are still valid (and useless) payload sources
+    void *bytes = nullptr;
+    if (info.st_size > 0)
+    {
+        bytes = mmap(nullptr, info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (bytes == MAP_FAILED)
+        {
+            int saved = errno;
+            close(fd);
+            errno = saved;
+            return nullptr;
+        }
+
+        madvise(bytes, info.st_size, MADV_SEQUENTIAL);
+    }
+
+    close(fd);
+    return std::shared_ptr<MappedFile>(new MappedFile(static_cast<const uint8_t *>(bytes), info.st_size));
+}
+
+MappedFile::MappedFile(const uint8_t *bytes, size_t length) : bytes(bytes), length(length)
+{
+}
+
+MappedFile::~MappedFile()
+{
+    if (bytes != nullptr)
+    {
+        munmap(const_cast<uint8_t *>(bytes), length);
+    }
+}
+
+}
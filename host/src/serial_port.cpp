@@ -0,0 +1,105 @@
+#include <errno.h>
+#include <fcntl.h>
+#include <termios.h>
+#include <unistd.h>
+
+#include "ttgo/serial_port.h"
+
+struct baud_speed
+{
+    int baud;
+    speed_t speed;
+};
+
+static const baud_speed baud_speeds[] = {
+    {9600, B9600},
+    {19200, B19200},
+    {38400, B38400},
+    {57600, B57600},
+    {115200, B115200},
+    {230400, B230400},
+#ifdef B460800
+    {460800, B460800},
+#endif
+#ifdef B921600
+    {921600, B921600},
+#endif
+#ifdef B1000000
+    {1000000, B1000000},
+#endif
+#ifdef B1500000
+    {1500000, B1500000},
+#endif
+#ifdef B2000000
+    {2000000, B2000000},
+#endif
+#ifdef B2500000
+    {2500000, B2500000},
+#endif
+#ifdef B3000000
+    {3000000, B3000000},
+#endif
+#ifdef B4000000
+    {4000000, B4000000},
+#endif
+};
+
+bool serial_set_baud(int fd, int baud)
+{
+    for (const baud_speed &entry : baud_speeds)
+    {
+        if (entry.baud != baud)
+        {
+            continue;
+        }
+
+        termios tty;
+        if (tcgetattr(fd, &tty) < 0)
+        {
+            return false;
+        }
+
+        cfsetispeed(&tty, entry.speed);
+        cfsetospeed(&tty, entry.speed);
+        return tcsetattr(fd, TCSANOW, &tty) == 0;
+    }
+
+    errno = EINVAL;
+    return false;
+}
+
+int serial_open(const char *path, int baud)
+{
+    int fd = open(path, O_RDWR | O_NOCTTY | O_NONBLOCK | O_CLOEXEC);
+    if (fd < 0)
+    {
+        return -1;
+    }
+
+    termios tty;
+    if (tcgetattr(fd, &tty) < 0)
+    {
+        int saved = errno;
+        close(fd);
+        errno = saved;
+        return -1;
+    }
+
+    // Raw 8N1 without flow control. With VMIN 1 an empty non-blocking read
+    // fails with EAGAIN, so a read of 0 bytes only ever means hangup.
+    cfmakeraw(&tty);
+    tty.c_cflag |= CLOCAL | CREAD;
+    tty.c_cflag &= ~CRTSCTS;
+    tty.c_cc[VMIN] = 1;
+    tty.c_cc[VTIME] = 0;
+
+    if (tcsetattr(fd, TCSANOW, &tty) < 0 || !serial_set_baud(fd, baud))
+    {
+        int saved = errno;
+        close(fd);
+        errno = saved;
+        return -1;
+    }
+
+    return fd;
+}
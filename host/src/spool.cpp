@@ -0,0 +1,493 @@
+#include <errno.h>
+#include <fcntl.h>
+#include <libgen.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <array>
+#include <chrono>
+
+#include "ttgo/mapped_file.h"
+#include "ttgo/spool.h"
+
+namespace ttgo
+{
+
+// Journal layout (little-endian): a 16-byte file header of magic and the
+// sequence number to continue from, then records of a 24-byte header and a
+// payload. The record CRC-32 covers the rest of the header and the payload,
+// so a torn write at the tail is recognised and dropped on replay.
+static const char SPOOL_MAGIC[8] = {'T', 'T', 'G', 'O', 'S', 'P', 'L', '1'};
+static const size_t FILE_HEADER = 16;
+static const size_t RECORD_HEADER = 24;
+
+enum
+{
+    RECORD_SUBMIT = 1,
+    RECORD_COMPLETE = 2
+};
+
+static uint32_t crc32_update(uint32_t crc, const uint8_t *data, size_t length)
+{
+    // Built on first use; function-local statics are initialised thread-safely
+    static const std::array<uint32_t, 256> table = []
+    {
+        std::array<uint32_t, 256> t;
+        for (uint32_t n = 0; n < 256; n++)
+        {
+            uint32_t c = n;
+            for (int k = 0; k < 8; k++)
+            {
+                c = c & 1 ? 0xEDB88320 ^ (c >> 1) : c >> 1;
+            }
+            t[n] = c;
+        }
+        return t;
+    }();
+
+    crc = ~crc;
+    for (size_t i = 0; i < length; i++)
+    {
+        crc = table[(crc ^ data[i]) & 0xFF] ^ (crc >> 8);
+    }
+    return ~crc;
+}
+
+static void put_u32(uint8_t *out, uint32_t value)
+{
+    memcpy(out, &value, sizeof(value));
+}
+
+static void put_u64(uint8_t *out, uint64_t value)
+{
+    memcpy(out, &value, sizeof(value));
+}
+
+static uint32_t get_u32(const uint8_t *in)
+{
+    uint32_t value;
+    memcpy(&value, in, sizeof(value));
+    return value;
+}
+
+static uint64_t get_u64(const uint8_t *in)
+{
+    uint64_t value;
+    memcpy(&value, in, sizeof(value));
+    return value;
+}
+
+static void encode_record(std::vector<uint8_t> &out, uint8_t type, uint64_t seq, uint32_t id,
+                          const uint8_t *data, size_t length)
+{
+    size_t start = out.size();
+    out.resize(start + RECORD_HEADER + length);
+
+    uint8_t *header = &out[start];
+    header[4] = type;
+    header[5] = header[6] = header[7] = 0;
+    put_u32(header + 8, length);
+    put_u64(header + 12, seq);
+    put_u32(header + 20, id);
+    if (length)
+    {
+        memcpy(header + RECORD_HEADER, data, length);
+    }
+
+    put_u32(header, crc32_update(0, header + 4, RECORD_HEADER - 4 + length));
+}
+
+static void encode_file_header(std::vector<uint8_t> &out, uint64_t base_seq)
+{
+    out.resize(FILE_HEADER);
+    memcpy(out.data(), SPOOL_MAGIC, sizeof(SPOOL_MAGIC));
+    put_u64(out.data() + 8, base_seq);
+}
+
+static bool write_all(int fd, const uint8_t *data, size_t length)
+{
+    while (length > 0)
+    {
+        ssize_t n = write(fd, data, length);
+        if (n < 0)
+        {
+            if (errno == EINTR)
+            {
+                continue;
+            }
+            return false;
+        }
+        data += n;
+        length -= n;
+    }
+    return true;
+}
+
+// Makes a rename durable
+static bool sync_directory(const std::string &path)
+{
+    std::vector<char> copy(path.begin(), path.end());
+    copy.push_back('\0');
+
+    int dir = ::open(dirname(copy.data()), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if (dir < 0)
+    {
+        return false;
+    }
+
+    bool ok = fsync(dir) == 0;
+    close(dir);
+    return ok;
+}
+
+std::unique_ptr<Spool> Spool::open(const std::string &path, const SpoolOptions &options)
+{
+    int fd = ::open(path.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+    if (fd < 0)
+    {
+        return nullptr;
+    }
+
+    std::unique_ptr<Spool> spool(new Spool(path, fd, options));
+
+    uint64_t valid_length = 0;
+    if (!spool->replay(valid_length))
+    {
+        errno = EINVAL;
+        return nullptr;
+    }
+
+    // Drop a torn tail and continue appending after the last intact record
+    if (ftruncate(fd, valid_length) < 0 || lseek(fd, valid_length, SEEK_SET) < 0)
+    {
+        return nullptr;
+    }
+
+    spool->writer = std::thread(&Spool::run_writer, spool.get());
+    return spool;
+}
+
+Spool::Spool(const std::string &path, int fd, const SpoolOptions &options) : path(path), fd(fd), options(options)
+{
+}
+
+Spool::~Spool()
+{
+    {
+        std::lock_guard<std::mutex> guard(lock);
+        stopping = true;
+    }
+    work.notify_all();
+
+    if (writer.joinable())
+    {
+        writer.join();
+    }
+    close(fd);
+}
+
+bool Spool::replay(uint64_t &valid_length)
+{
+    struct stat st;
+    if (fstat(fd, &st) < 0)
+    {
+        return false;
+    }
+
+    // New (or torn at creation): start a journal
+    if ((size_t)st.st_size < FILE_HEADER)
+    {
+        std::vector<uint8_t> header;
+        encode_file_header(header, 0);
+        if (ftruncate(fd, 0) < 0 || pwrite(fd, header.data(), header.size(), 0) != (ssize_t)header.size() ||
+            (options.sync && fdatasync(fd) < 0))
+        {
+            return false;
+        }
+        valid_length = FILE_HEADER;
+        counters.journal_bytes = FILE_HEADER;
+        return true;
+    }
+
+    std::shared_ptr<MappedFile> file = MappedFile::open(path.c_str());
+    if (!file || memcmp(file->data(), SPOOL_MAGIC, sizeof(SPOOL_MAGIC)) != 0)
+    {
+        return false;
+    }
+
+    const uint8_t *data = file->data();
+    size_t size = file->size();
+    size_t offset = FILE_HEADER;
+    last_seq = get_u64(data + 8);
+
+    while (offset + RECORD_HEADER <= size)
+    {
+        const uint8_t *header = data + offset;
+        uint32_t length = get_u32(header + 8);
+
+        if (length > MAX_MESSAGE || offset + RECORD_HEADER + length > size ||
+            crc32_update(0, header + 4, RECORD_HEADER - 4 + length) != get_u32(header))
+        {
+            break;
+        }
+
+        uint64_t seq = get_u64(header + 12);
+        if (header[4] == RECORD_SUBMIT)
+        {
+            entry &e = entries[seq];
+            e.seq = seq;
+            e.id = get_u32(header + 20);
+            e.data.assign(header + RECORD_HEADER, header + RECORD_HEADER + length);
+            live_bytes += RECORD_HEADER + length;
+            last_seq = std::max(last_seq, seq);
+        }
+        else if (header[4] == RECORD_COMPLETE)
+        {
+            auto it = entries.find(seq);
+            if (it != entries.end())
+            {
+                live_bytes -= RECORD_HEADER + it->second.data.size();
+                entries.erase(it);
+            }
+        }
+
+        offset += RECORD_HEADER + length;
+    }
+
+    valid_length = offset;
+    committed_seq = buffered_seq = last_seq;
+    counters.recovered = entries.size();
+    counters.truncated_bytes = size - offset;
+    counters.journal_bytes = offset;
+    return true;
+}
+
+uint64_t Spool::submit(const uint8_t *data, size_t length, uint32_t id)
+{
+    if (data == nullptr || length == 0 || length > MAX_MESSAGE)
+    {
+        return 0;
+    }
+
+    std::unique_lock<std::mutex> guard(lock);
+
+    // Backpressure: producers wait while a full batch is already waiting for the disk
+    durable.wait(guard, [&] { return buffer.size() < options.max_batch_bytes || io_failed || stopping; });
+    if (io_failed || stopping)
+    {
+        return 0;
+    }
+
+    uint64_t seq = ++last_seq;
+    encode_record(buffer, RECORD_SUBMIT, seq, id, data, length);
+
+    entry &e = entries[seq];
+    e.seq = seq;
+    e.id = id;
+    e.data.assign(data, data + length);
+
+    live_bytes += RECORD_HEADER + length;
+    buffered_seq = seq;
+    counters.submitted++;
+
+    guard.unlock();
+    work.notify_one();
+    return seq;
+}
+
+bool Spool::wait_durable(uint64_t seq)
+{
+    std::unique_lock<std::mutex> guard(lock);
+    durable.wait(guard, [&] { return committed_seq >= seq || io_failed; });
+    return committed_seq >= seq;
+}
+
+void Spool::complete(uint64_t seq)
+{
+    std::unique_lock<std::mutex> guard(lock);
+
+    auto it = entries.find(seq);
+    if (it == entries.end())
+    {
+        return;
+    }
+
+    live_bytes -= RECORD_HEADER + it->second.data.size();
+    entries.erase(it);
+    encode_record(buffer, RECORD_COMPLETE, seq, 0, nullptr, 0);
+    counters.completed++;
+
+    guard.unlock();
+    work.notify_one();
+}
+
+size_t Spool::next(uint64_t after, size_t max, std::vector<const entry *> &out)
+{
+    std::lock_guard<std::mutex> guard(lock);
+    size_t count = 0;
+
+    for (auto it = entries.upper_bound(after); it != entries.end() && it->first <= committed_seq && count < max; ++it)
+    {
+        out.push_back(&it->second);
+        count++;
+    }
+
+    return count;
+}
+
+size_t Spool::pending() const
+{
+    std::lock_guard<std::mutex> guard(lock);
+    return entries.size();
+}
+
+SpoolStats Spool::stats() const
+{
+    std::lock_guard<std::mutex> guard(lock);
+    return counters;
+}
+
+bool Spool::failed() const
+{
+    std::lock_guard<std::mutex> guard(lock);
+    return io_failed;
+}
+
+// Group commit: everything buffered while the previous batch was syncing is
+// written and synced together
+void Spool::run_writer()
+{
+    std::vector<uint8_t> batch;
+    std::unique_lock<std::mutex> guard(lock);
+
+    while (true)
+    {
+        work.wait(guard, [&] { return !buffer.empty() || stopping; });
+        if (buffer.empty())
+        {
+            break;
+        }
+
+        if (options.commit_delay_us > 0 && !stopping)
+        {
+            work.wait_for(guard, std::chrono::microseconds(options.commit_delay_us),
+                          [&] { return buffer.size() >= options.max_batch_bytes || stopping; });
+        }
+
+        batch.swap(buffer);
+        uint64_t batch_seq = buffered_seq;
+        guard.unlock();
+
+        // Space for new submissions opened up
+        durable.notify_all();
+
+        bool ok = write_all(fd, batch.data(), batch.size()) && (!options.sync || fdatasync(fd) == 0);
+
+        guard.lock();
+        counters.journal_bytes += batch.size();
+        batch.clear();
+
+        if (ok)
+        {
+            committed_seq = batch_seq;
+            counters.batches++;
+
+            if (counters.journal_bytes >= options.compact_min_bytes &&
+                live_bytes < counters.journal_bytes * (1 - options.compact_garbage))
+            {
+                ok = compact();
+            }
+        }
+
+        if (!ok)
+        {
+            io_failed = true;
+            durable.notify_all();
+            break;
+        }
+
+        durable.notify_all();
+    }
+}
+
+// Rewrites the journal with only the pending, committed entries. Runs on the
+// writer thread with the lock held, so submissions wait for it; entries still
+// in `buffer` go to the new journal with the next batch.
+bool Spool::compact()
+{
+    std::vector<uint8_t> image;
+    encode_file_header(image, last_seq);
+
+    for (auto it = entries.begin(); it != entries.end() && it->first <= committed_seq; ++it)
+    {
+        encode_record(image, RECORD_SUBMIT, it->first, it->second.id, it->second.data.data(), it->second.data.size());
+    }
+
+    std::string temp = path + ".compact";
+    int out = ::open(temp.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (out < 0)
+    {
+        return false;
+    }
+
+    if (!write_all(out, image.data(), image.size()) || (options.sync && fdatasync(out) < 0) ||
+        rename(temp.c_str(), path.c_str()) < 0 || (options.sync && !sync_directory(path)))
+    {
+        close(out);
+        unlink(temp.c_str());
+        return false;
+    }
+
+    close(fd);
+    fd = out;
+    counters.journal_bytes = image.size();
+    counters.compactions++;
+    return true;
+}
+
+SpoolFeeder::SpoolFeeder(Spool &spool, FskClient &client, size_t depth) : spool(spool), client(client), depth(depth)
+{
+}
+
+void SpoolFeeder::pump()
+{
+    while (outstanding < depth)
+    {
+        batch.clear();
+        if (spool.next(last_queued, depth - outstanding, batch) == 0)
+        {
+            return;
+        }
+
+        for (const Spool::entry *e : batch)
+        {
+            uint64_t seq = e->seq;
+            auto done = [this, seq](const Result &result)
+            {
+                outstanding--;
+
+                // Link failures leave the entry for the next run; device answers, including errors, finish it
+                if (result.code == RESULT_LINK_ERROR || result.code == RESULT_TIMEOUT)
+                {
+                    link_failures++;
+                    return;
+                }
+
+                spool.complete(seq);
+                answered++;
+            };
+
+            if (!client.send(e->data.data(), e->data.size(), done, e->id))
+            {
+                link_failures++;
+                return;
+            }
+
+            last_queued = seq;
+            outstanding++;
+        }
+    }
+}
+
+}
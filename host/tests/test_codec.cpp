@@ -0,0 +1,32 @@
+// Golden vectors and bulk/scalar cross-check of the fsk_codec kernels, run by
+// ctest. The same vectors run on the device and natively in test/test_codec.
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <vector>
+
+#include "codec_check.h"
+
+int main()
+{
+    // Fixed seed, so a failure can be reproduced
+    srand(1);
+
+    std::vector<uint8_t> input(4097);
+    std::vector<uint32_t> words(1024);
+    for (uint8_t &byte : input)
+    {
+        byte = rand();
+    }
+    for (uint32_t &word : words)
+    {
+        word = codec_bch3121_encode(rand());
+    }
+
+    int golden = codec_selftest();
+    int cross = codec_cross_check(input, words);
+
+    printf("golden vectors: %d failures, bulk/scalar: %d mismatches\n", golden, cross);
+    return golden || cross ? 1 : 0;
+}
@@ -0,0 +1,308 @@
+#include <math.h>
+#include <string.h>
+
+#include <algorithm>
+
+#include "baseband.h"
+#include "fsk_codec.h"
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+#if defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
+// Integration steps per sample when building the pulse tables
+static const int PULSE_STEPS = 32;
+
+// Neighbouring bits whose pulse reaches less than this into a bit are dropped
+static const double PULSE_TAIL = 1e-3;
+
+std::vector<uint8_t> build_frame(const uint8_t *payload, size_t length, const FrameOptions &options)
+{
+    std::vector<uint8_t> frame(options.preamble_bits / 8, 0xAA);
+    frame.insert(frame.end(), options.sync.begin(), options.sync.end());
+
+    size_t start = frame.size();
+    frame.insert(frame.end(), payload, payload + length);
+
+    if (options.crc != 0)
+    {
+        uint16_t crc = codec_crc16(payload, length, options.crc == 2);
+        frame.push_back(crc >> 8);
+        frame.push_back(crc & 0xFF);
+    }
+
+    // The packet engine whitens the payload and CRC, not the preamble or sync word
+    if (options.whitening)
+    {
+        codec_pn9_apply(frame.data() + start, frame.size() - start, 0);
+    }
+
+    return frame;
+}
+
+bool parse_frame(const std::vector<uint8_t> &bits, size_t length, const FrameOptions &options,
+                 std::vector<uint8_t> &payload, bool &crc_ok, size_t &sync_bit)
+{
+    std::vector<uint8_t> sync_bits;
+    for (uint8_t byte : options.sync)
+    {
+        for (int b = 7; b >= 0; b--)
+        {
+            sync_bits.push_back((byte >> b) & 1);
+        }
+    }
+
+    auto found = std::search(bits.begin(), bits.end(), sync_bits.begin(), sync_bits.end());
+    if (found == bits.end())
+    {
+        return false;
+    }
+
+    sync_bit = found - bits.begin();
+    size_t start = sync_bit + sync_bits.size();
+    size_t crc_bytes = options.crc != 0 ? 2 : 0;
+    size_t available = (bits.size() - start) / 8;
+    size_t total = length ? std::min(length + crc_bytes, available) : available;
+
+    std::vector<uint8_t> bytes(total, 0);
+    for (size_t i = 0; i < total * 8; i++)
+    {
+        bytes[i / 8] |= bits[start + i] << (7 - i % 8);
+    }
+
+    if (options.whitening)
+    {
+        codec_pn9_apply(bytes.data(), bytes.size(), 0);
+    }
+
+    crc_ok = true;
+    if (crc_bytes)
+    {
+        if (total < crc_bytes)
+        {
+            crc_ok = false;
+            payload.clear();
+            return true;
+        }
+
+        total -= crc_bytes;
+        uint16_t crc = codec_crc16(bytes.data(), total, options.crc == 2);
+        crc_ok = bytes[total] == (crc >> 8) && bytes[total + 1] == (crc & 0xFF);
+    }
+
+    payload.assign(bytes.begin(), bytes.begin() + total);
+    return true;
+}
+
+// Gaussian-filtered rectangular frequency pulse of one bit centred on t = 0,
+// in bits; the pulses of all bits sum to 1
+static double gaussian_pulse(double t, double bt)
+{
+    double c = M_PI * bt * sqrt(2 / log(2.0));
+    return 0.5 * (erf(c * (t + 0.5)) - erf(c * (t - 0.5)));
+}
+
+FskModulator::FskModulator(const ModulatorOptions &options) : options(options)
+{
+    // The first bit left out starts half a bit further out than the span reaches
+    pulse_span = 1;
+    if (options.bt > 0)
+    {
+        while (pulse_span < BASEBAND_MAX_SPAN && gaussian_pulse(pulse_span / 2 + 0.5, options.bt) > PULSE_TAIL)
+        {
+            pulse_span += 2;
+        }
+    }
+
+    int sps = options.samples_per_bit;
+    int half = pulse_span / 2;
+    size_t patterns = (size_t)1 << pulse_span;
+    double radians_per_bit = 2 * M_PI * options.deviation_hz / options.bitrate_bps;
+
+    table.resize(patterns * sps * 2);
+    table_swapped.resize(patterns * sps * 2);
+    advance.resize(patterns);
+
+    // Pattern bit b (LSB first) is the bit `half - b` positions after the one being rendered
+    for (size_t pattern = 0; pattern < patterns; pattern++)
+    {
+        auto frequency = [&](double tau)
+        {
+            if (options.bt <= 0)
+            {
+                return (pattern >> half) & 1 ? 1.0 : -1.0;
+            }
+
+            double weighted = 0;
+            double total = 0;
+            for (int b = 0; b < pulse_span; b++)
+            {
+                double weight = gaussian_pulse(tau - 0.5 - (half - b), options.bt);
+                weighted += ((pattern >> b) & 1 ? 1.0 : -1.0) * weight;
+                total += weight;
+            }
+            return weighted / total;  // the truncated pulse still reaches full deviation on long runs
+        };
+
+        double phase = 0;
+        for (int k = 0; k <= sps; k++)
+        {
+            if (k == sps)
+            {
+                advance[pattern] = std::polar(1.0, phase);
+                break;
+            }
+
+            float *entry = &table[(pattern * sps + k) * 2];
+            float *swapped = &table_swapped[(pattern * sps + k) * 2];
+            entry[0] = cos(phase);
+            entry[1] = sin(phase);
+            swapped[0] = -entry[1];
+            swapped[1] = entry[0];
+
+            for (int step = 0; step < PULSE_STEPS; step++)
+            {
+                double tau = (k + (step + 0.5) / PULSE_STEPS) / sps;
+                phase += radians_per_bit * frequency(tau) / (sps * PULSE_STEPS);
+            }
+        }
+    }
+}
+
+// out = phasor * row, for interleaved (re, im) floats: re * row + im * row_swapped
+static void rotate_row(float re, float im, const float *row, const float *row_swapped, float *out, int floats)
+{
+    int i = 0;
+
+#if defined(__SSE2__)
+    __m128 vre = _mm_set1_ps(re);
+    __m128 vim = _mm_set1_ps(im);
+    for (; i + 4 <= floats; i += 4)
+    {
+        __m128 product = _mm_add_ps(_mm_mul_ps(vre, _mm_loadu_ps(row + i)),
+                                    _mm_mul_ps(vim, _mm_loadu_ps(row_swapped + i)));
+        _mm_storeu_ps(out + i, product);
+    }
+#elif defined(__ARM_NEON)
+    for (; i + 4 <= floats; i += 4)
+    {
+        float32x4_t product = vmulq_n_f32(vld1q_f32(row + i), re);
+        vst1q_f32(out + i, vmlaq_n_f32(product, vld1q_f32(row_swapped + i), im));
+    }
+#endif
+
+    for (; i < floats; i++)
+    {
+        out[i] = re * row[i] + im * row_swapped[i];
+    }
+}
+
+void FskModulator::render(const uint8_t *data, size_t bit_count,
+                          const std::function<void(const iq_sample *, size_t)> &sink, size_t chunk_bits)
+{
+    if (bit_count == 0)
+    {
+        return;
+    }
+
+    int sps = options.samples_per_bit;
+    int half = pulse_span / 2;
+    size_t mask = ((size_t)1 << pulse_span) - 1;
+
+    // Bits before the start and after the end repeat the first and last bit
+    auto bit = [&](long index)
+    {
+        size_t i = std::min((size_t)std::max(index, 0L), bit_count - 1);
+        return (data[i / 8] >> (7 - i % 8)) & 1;
+    };
+
+    size_t pattern = 0;
+    for (long i = -half; i <= half; i++)
+    {
+        pattern = (pattern << 1) | bit(i);
+    }
+
+    std::vector<iq_sample> buffer(std::min(chunk_bits, bit_count) * sps);
+    size_t filled = 0;
+
+    for (size_t i = 0; i < bit_count; i++)
+    {
+        size_t row = pattern * sps * 2;
+        rotate_row((float)phase.real(), (float)phase.imag(), &table[row], &table_swapped[row],
+                   reinterpret_cast<float *>(&buffer[filled]), sps * 2);
+        filled += sps;
+
+        // Renormalised every bit so the carrier amplitude does not drift over hours of samples
+        phase *= advance[pattern];
+        phase /= std::abs(phase);
+
+        pattern = ((pattern << 1) | bit(i + half + 1)) & mask;
+
+        if (filled == buffer.size())
+        {
+            sink(buffer.data(), filled);
+            filled = 0;
+        }
+    }
+
+    if (filled)
+    {
+        sink(buffer.data(), filled);
+    }
+}
+
+// Phase change across one bit, from its first sample to the first sample of the next
+static float bit_sum(const iq_sample *samples, size_t count, size_t start, int samples_per_bit)
+{
+    size_t end = std::min(start + samples_per_bit, count - 1);
+    float sum = 0;
+
+    for (size_t n = start + 1; n <= end; n++)
+    {
+        sum += std::arg(samples[n] * std::conj(samples[n - 1]));
+    }
+
+    return sum;
+}
+
+std::vector<uint8_t> demodulate(const iq_sample *samples, size_t count, int samples_per_bit, int offset)
+{
+    std::vector<uint8_t> bits;
+
+    for (size_t start = offset; start + samples_per_bit <= count; start += samples_per_bit)
+    {
+        bits.push_back(bit_sum(samples, count, start, samples_per_bit) > 0);
+    }
+
+    return bits;
+}
+
+int find_bit_offset(const iq_sample *samples, size_t count, int samples_per_bit)
+{
+    const size_t probe_bits = 1024;
+    int best = 0;
+    double best_metric = -1;
+
+    for (int offset = 0; offset < samples_per_bit; offset++)
+    {
+        double metric = 0;
+        size_t bits = 0;
+
+        for (size_t start = offset; start + samples_per_bit <= count && bits < probe_bits; start += samples_per_bit)
+        {
+            metric += fabs(bit_sum(samples, count, start, samples_per_bit));
+            bits++;
+        }
+
+        if (bits && metric / bits > best_metric)
+        {
+            best_metric = metric / bits;
+            best = offset;
+        }
+    }
+
+    return best;
+}
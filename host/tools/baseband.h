@@ -0,0 +1,81 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <complex>
+#include <functional>
+#include <vector>
+
+#include "defaults.h"
+
+// beginFSK() leaves data shaping off and loads RadioLib's default sync word
+#define BASEBAND_SHAPING_BT 0.0
+#define BASEBAND_SYNC_WORD {0x12, 0xAD}
+
+// Longest Gaussian pulse kept, in bits; the pulse tables grow as 2^span
+#define BASEBAND_MAX_SPAN 7
+
+using iq_sample = std::complex<float>;
+
+// What the firmware hands the radio: preamble, sync word and the payload
+// with the configured framing (see framing.cpp)
+struct FrameOptions
+{
+    int preamble_bits = PREAMBLE_LENGTH;           // 0xAA bytes, as beginFSK() takes it in bits
+    std::vector<uint8_t> sync = BASEBAND_SYNC_WORD;
+    int crc = 0;                                   // 0 off, 1 CCITT, 2 IBM (framing_crc_mode)
+    bool whitening = false;
+};
+
+struct ModulatorOptions
+{
+    double bitrate_bps = TX_BITRATE * 1000;
+    double deviation_hz = TX_DEVIATION * 1000;
+    double bt = BASEBAND_SHAPING_BT;  // Gaussian bandwidth-time product; 0 is unshaped 2-FSK
+    int samples_per_bit = 16;
+};
+
+// On-air bytes of one packet, MSB first
+std::vector<uint8_t> build_frame(const uint8_t *payload, size_t length, const FrameOptions &options);
+
+// Finds the sync word in demodulated bits and returns the payload that
+// follows: `length` bytes, or everything up to the last whole byte when
+// `length` is 0. Whitening is removed and a CRC checked and stripped, with
+// `crc_ok` reporting the result. Returns false without a sync word.
+bool parse_frame(const std::vector<uint8_t> &bits, size_t length, const FrameOptions &options,
+                 std::vector<uint8_t> &payload, bool &crc_ok, size_t &sync_bit);
+
+// Continuous-phase (G)FSK modulator. The frequency pulse of every pattern of
+// `span` neighbouring bits is integrated once into a table of unit phasors,
+// so rendering a bit is one complex multiply per sample: the carrier phase at
+// the bit start times the table row, vectorised with SSE2 or NEON.
+class FskModulator
+{
+public:
+    explicit FskModulator(const ModulatorOptions &options);
+
+    // Renders `bit_count` bits of `data` (MSB first), handing out samples in
+    // blocks of at most `chunk_bits` bits. The phase carries over between calls.
+    void render(const uint8_t *data, size_t bit_count,
+                const std::function<void(const iq_sample *, size_t)> &sink, size_t chunk_bits = 4096);
+
+    double sample_rate() const { return options.bitrate_bps * options.samples_per_bit; }
+    int span() const { return pulse_span; }
+
+private:
+    ModulatorOptions options;
+    int pulse_span;                        // odd number of bits the frequency pulse reaches
+    std::vector<float> table;              // per pattern: samples_per_bit phasors (re, im)
+    std::vector<float> table_swapped;      // the same phasors as (-im, re)
+    std::vector<std::complex<double>> advance; // per pattern: rotation over the whole bit
+    std::complex<double> phase{1, 0};
+};
+
+// Quadrature discriminator: sums the phase steps across each bit and slices
+// on the sign. `offset` is the sample at which the first bit starts; use
+// find_bit_offset() when it is not known.
+std::vector<uint8_t> demodulate(const iq_sample *samples, size_t count, int samples_per_bit, int offset);
+
+// Bit timing: the sample offset whose bit sums have the largest mean magnitude
+int find_bit_offset(const iq_sample *samples, size_t count, int samples_per_bit);
@@ -0,0 +1,100 @@
+// Benchmarks the client against the simulated device: stop-and-wait (as
+// main.py works) against pipelined submission, from caller buffers and from
+// a memory-mapped file.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#include "load.h"
+#include "sim_device.h"
+#include "ttgo/client.h"
+#include "ttgo/serial_port.h"
+
+struct scenario
+{
+    const char *name;
+    int baud;
+    double bitrate_bps;
+    size_t size;
+    size_t depth;
+    bool from_file;
+};
+
+static const scenario scenarios[] = {
+    {"stop_and_wait", 921600, 0, 256, 1, false},
+    {"pipelined", 921600, 0, 256, 16, false},
+    {"pipelined_mmap", 921600, 0, 256, 16, true},
+    {"stop_and_wait_2k", 921600, 0, 2048, 1, false},
+    {"pipelined_2k", 921600, 0, 2048, 16, false},
+    {"stop_and_wait_air", 921600, 100000, 256, 1, false},
+    {"pipelined_air", 921600, 100000, 256, 16, false},
+};
+
+static std::shared_ptr<ttgo::MappedFile> make_payload_file(size_t size)
+{
+    char path[] = "/tmp/ttgo_bench_XXXXXX";
+    int fd = mkstemp(path);
+    if (fd < 0)
+    {
+        return nullptr;
+    }
+
+    for (size_t i = 0; i < size; i++)
+    {
+        uint8_t byte = rand();
+        if (write(fd, &byte, 1) != 1)
+        {
+            break;
+        }
+    }
+    close(fd);
+
+    std::shared_ptr<ttgo::MappedFile> file = ttgo::MappedFile::open(path);
+    unlink(path); // the mapping stays valid
+    return file;
+}
+
+int main(int argc, char **argv)
+{
+    int count = argc > 1 ? atoi(argv[1]) : 200;
+    int failures = 0;
+
+    for (const scenario &s : scenarios)
+    {
+        SimOptions sim_options;
+        sim_options.baud = s.baud;
+        sim_options.bitrate_bps = s.bitrate_bps;
+
+        SimDevice sim(sim_options);
+        if (!sim.start())
+        {
+            perror("simulator");
+            return 1;
+        }
+
+        int fd = serial_open(sim.path().c_str(), s.baud);
+        if (fd < 0)
+        {
+            perror(sim.path().c_str());
+            return 1;
+        }
+
+        LoadOptions load;
+        load.count = count;
+        load.size = s.size;
+        load.depth = s.depth;
+        if (s.from_file)
+        {
+            load.file = make_payload_file(s.size * 64);
+        }
+
+        ttgo::FskClient client(fd);
+        LoadResult result = run_load(client, load);
+        print_load_result(s.name, load, result);
+
+        failures += result.failed;
+    }
+
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,244 @@
+// Benchmarks the message spool: intake with one fdatasync per submission
+// against group commit from concurrent producers, replay time of a large
+// journal, compaction, and in-order feeding of the simulated device.
+//
+// The journal goes to the directory given (default: the current one); on
+// tmpfs fdatasync is free and the intake numbers say little.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#include <chrono>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "sim_device.h"
+#include "ttgo/client.h"
+#include "ttgo/serial_port.h"
+#include "ttgo/spool.h"
+
+using steady = std::chrono::steady_clock;
+
+static double seconds_since(steady::time_point start)
+{
+    return std::chrono::duration<double>(steady::now() - start).count();
+}
+
+static std::vector<uint8_t> make_payload(size_t size)
+{
+    std::vector<uint8_t> payload(size);
+    for (uint8_t &byte : payload)
+    {
+        byte = rand();
+    }
+    return payload;
+}
+
+// Each producer submits its share and waits until the submission is durable,
+// as a service acknowledging every request would
+static bool run_intake(const char *name, const std::string &path, int producers, int count, bool wait_each)
+{
+    unlink(path.c_str());
+    std::unique_ptr<ttgo::Spool> spool = ttgo::Spool::open(path);
+    if (!spool)
+    {
+        perror(path.c_str());
+        return false;
+    }
+
+    std::vector<uint8_t> payload = make_payload(256);
+    std::vector<std::thread> threads;
+    steady::time_point start = steady::now();
+
+    for (int p = 0; p < producers; p++)
+    {
+        threads.emplace_back([&]
+        {
+            uint64_t seq = 0;
+            for (int i = 0; i < count / producers; i++)
+            {
+                seq = spool->submit(payload.data(), payload.size());
+                if (wait_each)
+                {
+                    spool->wait_durable(seq);
+                }
+            }
+            spool->wait_durable(seq);
+        });
+    }
+
+    for (std::thread &thread : threads)
+    {
+        thread.join();
+    }
+
+    double elapsed = seconds_since(start);
+    ttgo::SpoolStats stats = spool->stats();
+    printf("%-14s producers=%d submitted=%llu seconds=%.3f rate=%.0f/s batches=%llu per_batch=%.1f\n", name,
+           producers, (unsigned long long)stats.submitted, elapsed, stats.submitted / elapsed,
+           (unsigned long long)stats.batches, stats.batches ? (double)stats.submitted / stats.batches : 0.0);
+    return !spool->failed();
+}
+
+static bool run_recovery(const std::string &path, int count)
+{
+    unlink(path.c_str());
+    {
+        ttgo::SpoolOptions options;
+        options.sync = false;
+        std::unique_ptr<ttgo::Spool> spool = ttgo::Spool::open(path, options);
+        if (!spool)
+        {
+            perror(path.c_str());
+            return false;
+        }
+
+        std::vector<uint8_t> payload = make_payload(256);
+        for (int i = 0; i < count; i++)
+        {
+            uint64_t seq = spool->submit(payload.data(), payload.size(), i + 1);
+            if (i % 2)
+            {
+                spool->complete(seq);
+            }
+        }
+    }
+
+    // A torn record at the tail, as a crash in the middle of a write leaves it
+    FILE *file = fopen(path.c_str(), "ab");
+    if (file)
+    {
+        fwrite("\x01\x02\x03\x04\x01\x00\x00", 1, 7, file);
+        fclose(file);
+    }
+
+    steady::time_point start = steady::now();
+    std::unique_ptr<ttgo::Spool> spool = ttgo::Spool::open(path);
+    double elapsed = seconds_since(start);
+    if (!spool)
+    {
+        perror(path.c_str());
+        return false;
+    }
+
+    ttgo::SpoolStats stats = spool->stats();
+    printf("%-14s records=%d journal_bytes=%llu recovered=%llu truncated_bytes=%llu ms=%.1f\n", "recovery",
+           count + count / 2, (unsigned long long)stats.journal_bytes, (unsigned long long)stats.recovered,
+           (unsigned long long)stats.truncated_bytes, elapsed * 1000);
+    return stats.recovered == (uint64_t)(count - count / 2) && stats.truncated_bytes == 7;
+}
+
+static bool run_compaction(const std::string &path, int count)
+{
+    unlink(path.c_str());
+    ttgo::SpoolOptions options;
+    options.compact_min_bytes = 1 << 20;
+    std::unique_ptr<ttgo::Spool> spool = ttgo::Spool::open(path, options);
+    if (!spool)
+    {
+        perror(path.c_str());
+        return false;
+    }
+
+    // Submissions complete a few behind, as the feeder keeps them
+    std::vector<uint8_t> payload = make_payload(1024);
+    std::vector<uint64_t> seqs;
+    steady::time_point start = steady::now();
+
+    for (int i = 0; i < count; i++)
+    {
+        seqs.push_back(spool->submit(payload.data(), payload.size()));
+        if (i >= 16)
+        {
+            spool->complete(seqs[i - 16]);
+        }
+    }
+    spool->wait_durable(seqs.back());
+
+    double elapsed = seconds_since(start);
+    ttgo::SpoolStats stats = spool->stats();
+    printf("%-14s submitted=%llu pending=%zu compactions=%llu journal_bytes=%llu seconds=%.3f\n", "compaction",
+           (unsigned long long)stats.submitted, spool->pending(), (unsigned long long)stats.compactions,
+           (unsigned long long)stats.journal_bytes, elapsed);
+    spool.reset();
+
+    // The compacted journal replays to the same pending entries
+    spool = ttgo::Spool::open(path);
+    return spool && spool->pending() == 16 && !spool->failed();
+}
+
+static bool run_feed(const std::string &path, int count)
+{
+    unlink(path.c_str());
+    std::unique_ptr<ttgo::Spool> spool = ttgo::Spool::open(path);
+    if (!spool)
+    {
+        perror(path.c_str());
+        return false;
+    }
+
+    SimOptions sim_options;
+    sim_options.baud = 921600;
+    SimDevice sim(sim_options);
+    if (!sim.start())
+    {
+        perror("simulator");
+        return false;
+    }
+
+    int fd = serial_open(sim.path().c_str(), sim_options.baud);
+    if (fd < 0)
+    {
+        perror(sim.path().c_str());
+        return false;
+    }
+
+    ttgo::FskClient client(fd);
+    ttgo::SpoolFeeder feeder(*spool, client);
+
+    // A producer thread keeps submitting while the client loop feeds the device
+    std::vector<uint8_t> payload = make_payload(256);
+    std::thread producer([&]
+    {
+        for (int i = 0; i < count; i++)
+        {
+            spool->submit(payload.data(), payload.size(), i + 1);
+        }
+    });
+
+    steady::time_point start = steady::now();
+    while (feeder.sent() + feeder.failed() < (uint64_t)count)
+    {
+        feeder.pump();
+        if (!client.run_once(feeder.in_flight() ? 100 : 1))
+        {
+            break;
+        }
+    }
+    double elapsed = seconds_since(start);
+    producer.join();
+
+    printf("%-14s sent=%llu failed=%llu pending=%zu seconds=%.3f rate=%.0f/s\n", "feed",
+           (unsigned long long)feeder.sent(), (unsigned long long)feeder.failed(), spool->pending(), elapsed,
+           feeder.sent() / elapsed);
+    return feeder.sent() == (uint64_t)count && spool->pending() == 0;
+}
+
+int main(int argc, char **argv)
+{
+    int count = argc > 1 ? atoi(argv[1]) : 2000;
+    std::string path = std::string(argc > 2 ? argv[2] : ".") + "/ttgo_bench_spool.journal";
+    int failures = 0;
+
+    failures += !run_intake("sync_each", path, 1, count, true);
+    failures += !run_intake("group_commit", path, 16, count * 8, true);
+    failures += !run_intake("async", path, 1, count * 8, false);
+    failures += !run_recovery(path, count * 50);
+    failures += !run_compaction(path, count * 4);
+    failures += !run_feed(path, count);
+
+    unlink(path.c_str());
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,40 @@
+// C entry points to the fsk_codec kernels for the Python binding
+// (examples/send_fsk/codec.py). Bulk variants are used where they exist.
+
+#include "fsk_codec_bulk.h"
+#include "fsk_codec_vectors.h"
+
+extern "C"
+{
+
+uint16_t fsk_codec_crc16(const uint8_t *data, size_t length, int ibm)
+{
+    return codec_crc16_final(codec_crc16_update_bulk(codec_crc16_init(ibm), data, length, ibm), ibm);
+}
+
+void fsk_codec_pn9_apply(uint8_t *data, size_t length, size_t offset)
+{
+    codec_pn9_apply_bulk(data, length, offset);
+}
+
+uint32_t fsk_codec_bch3121_encode(uint32_t data)
+{
+    return codec_bch3121_encode(data);
+}
+
+void fsk_codec_interleave8(const uint32_t *words, size_t blocks, uint8_t *out)
+{
+    codec_interleave8_bulk(words, blocks, out);
+}
+
+void fsk_codec_manchester_encode(const uint8_t *in, size_t length, uint8_t *out)
+{
+    codec_manchester_encode_bulk(in, length, out);
+}
+
+int fsk_codec_selftest()
+{
+    return codec_selftest();
+}
+
+}
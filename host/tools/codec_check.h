@@ -0,0 +1,56 @@
+#pragma once
+
+// Cross-check of the fsk_codec bulk kernels against the scalar ones, shared
+// by ttgo_bench_codec and the ttgo_test_codec test
+
+#include <string.h>
+
+#include <vector>
+
+#include "fsk_codec_bulk.h"
+#include "fsk_codec_vectors.h"
+
+// Returns the number of mismatches. `input` must hold at least 4097 bytes.
+static inline int codec_cross_check(const std::vector<uint8_t> &input, const std::vector<uint32_t> &words)
+{
+    int failures = 0;
+
+    // Odd lengths and offsets exercise the scalar tails of the bulk loops
+    for (size_t length : {0, 1, 15, 16, 17, 511, 1000, 4097})
+    {
+        for (size_t offset : {0, 7, 510, 1023})
+        {
+            std::vector<uint8_t> scalar(input.begin(), input.begin() + length);
+            std::vector<uint8_t> bulk(scalar);
+            codec_pn9_apply(scalar.data(), length, offset);
+            codec_pn9_apply_bulk(bulk.data(), length, offset);
+            failures += scalar != bulk;
+        }
+
+        for (bool ibm : {false, true})
+        {
+            failures += codec_crc16_update(codec_crc16_init(ibm), input.data(), length, ibm) !=
+                        codec_crc16_update_bulk(codec_crc16_init(ibm), input.data(), length, ibm);
+        }
+
+        std::vector<uint8_t> scalar(2 * length), bulk(2 * length);
+        codec_manchester_encode(input.data(), length, scalar.data());
+        codec_manchester_encode_bulk(input.data(), length, bulk.data());
+        failures += scalar != bulk;
+    }
+
+    size_t blocks = words.size() / 8;
+    std::vector<uint8_t> scalar(32 * blocks), bulk(32 * blocks);
+    for (size_t b = 0; b < blocks; b++)
+    {
+        codec_interleave8(&words[8 * b], &scalar[32 * b]);
+    }
+    codec_interleave8_bulk(words.data(), blocks, bulk.data());
+    failures += scalar != bulk;
+
+    uint8_t vector_out[32];
+    codec_interleave8_bulk(codec_vector_interleave_in, 1, vector_out);
+    failures += memcmp(vector_out, codec_vector_interleave_out, sizeof(vector_out)) != 0;
+
+    return failures;
+}
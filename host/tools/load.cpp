@@ -0,0 +1,114 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include <algorithm>
+#include <vector>
+
+#include "load.h"
+
+static double now_s()
+{
+    timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+LoadResult run_load(ttgo::FskClient &client, const LoadOptions &options)
+{
+    std::vector<uint8_t> buffer(options.size);
+    for (uint8_t &byte : buffer)
+    {
+        byte = rand();
+    }
+
+    std::vector<double> latencies;
+    LoadResult result = {};
+    int submitted = 0;
+    size_t file_offset = 0;
+    double start = now_s();
+
+    auto done = [&](const ttgo::Result &r)
+    {
+        if (r.code == ttgo::RESULT_OK)
+        {
+            result.sent++;
+            latencies.push_back(r.latency_us / 1000.0);
+        }
+        else
+        {
+            result.failed++;
+            fprintf(stderr, "Message failed (%d): %s\n", r.code, r.message.c_str());
+        }
+    };
+
+    while (submitted < options.count)
+    {
+        double due = options.rate > 0 ? start + submitted / options.rate : 0;
+        double now = now_s();
+
+        if (now < due || client.pending() >= options.depth)
+        {
+            int wait_ms = now < due ? (int)((due - now) * 1000) + 1 : -1;
+            if (!client.run_once(wait_ms))
+            {
+                break;
+            }
+            continue;
+        }
+
+        uint32_t id = options.first_id ? options.first_id + submitted : 0;
+        bool queued;
+
+        if (options.file)
+        {
+            if (file_offset >= options.file->size())
+            {
+                file_offset = 0;
+            }
+            size_t length = std::min(options.size, options.file->size() - file_offset);
+            queued = client.send(options.file, file_offset, length, done, id);
+            file_offset += length;
+        }
+        else
+        {
+            queued = client.send(buffer.data(), buffer.size(), done, id);
+        }
+
+        if (!queued)
+        {
+            fprintf(stderr, "Message %d rejected by the client\n", submitted);
+            result.failed++;
+        }
+        submitted++;
+    }
+
+    client.run_until_idle();
+    result.elapsed_s = now_s() - start;
+
+    if (!latencies.empty())
+    {
+        std::sort(latencies.begin(), latencies.end());
+        double total = 0;
+        for (double latency : latencies)
+        {
+            total += latency;
+        }
+        result.avg_latency_ms = total / latencies.size();
+        result.p50_latency_ms = latencies[latencies.size() / 2];
+        result.p99_latency_ms = latencies[std::min(latencies.size() - 1, latencies.size() * 99 / 100)];
+        result.max_latency_ms = latencies.back();
+    }
+
+    return result;
+}
+
+void print_load_result(const char *name, const LoadOptions &options, const LoadResult &result)
+{
+    double rate = result.elapsed_s > 0 ? result.sent / result.elapsed_s : 0;
+
+    printf("%-24s sent=%d failed=%d elapsed_s=%.3f msgs_per_s=%.1f payload_Bps=%.0f "
+           "latency_ms avg=%.2f p50=%.2f p99=%.2f max=%.2f\n",
+           name, result.sent, result.failed, result.elapsed_s, rate, rate * options.size,
+           result.avg_latency_ms, result.p50_latency_ms, result.p99_latency_ms, result.max_latency_ms);
+}
@@ -0,0 +1,34 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <memory>
+
+#include "ttgo/client.h"
+
+struct LoadOptions
+{
+    int count = 100;                       // messages to send
+    size_t size = 256;                     // payload bytes per message
+    double rate = 0;                       // messages per second; 0 sends as fast as the link allows
+    size_t depth = 16;                     // requests queued in the client at once; 1 waits for each result
+    uint32_t first_id = 0;                 // tag messages with IDs from here on; 0 sends untagged
+    std::shared_ptr<ttgo::MappedFile> file; // take payloads from consecutive file slices instead of a buffer
+};
+
+struct LoadResult
+{
+    int sent;
+    int failed;
+    double elapsed_s;
+    double avg_latency_ms;
+    double p50_latency_ms;
+    double p99_latency_ms;
+    double max_latency_ms;
+};
+
+// Drives the client with the given load and collects throughput and latency
+LoadResult run_load(ttgo::FskClient &client, const LoadOptions &options);
+
+void print_load_result(const char *name, const LoadOptions &options, const LoadResult &result);
@@ -0,0 +1,116 @@
+// Load generator: sends a stream of messages to a device (or the simulator)
+// and reports throughput and submission-to-result latency.
+
+#include <errno.h>
+#include <getopt.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "load.h"
+#include "sim_device.h"
+#include "ttgo/client.h"
+#include "ttgo/serial_port.h"
+
+static void usage(const char *program)
+{
+    fprintf(stderr,
+            "Usage: %s [options] <port>|--sim\n"
+            "  -b, --baud N       serial baud rate (default 115200)\n"
+            "  -n, --count N      messages to send (default 100)\n"
+            "  -s, --size N       payload bytes per message, 1-2048 (default 256)\n"
+            "  -r, --rate N       messages per second, 0 for unlimited (default 0)\n"
+            "  -d, --depth N      requests queued at once, 1 waits for each result (default 16)\n"
+            "  -i, --id N         tag messages with IDs starting at N\n"
+            "  -f, --file PATH    send consecutive slices of a memory-mapped file\n"
+            "  -w, --wake         wake the device from light sleep after idle periods\n"
+            "      --sim          run against a simulated device\n"
+            "      --bitrate N    simulated on-air bit rate, 0 for instant (default 0)\n",
+            program);
+}
+
+int main(int argc, char **argv)
+{
+    static const option long_options[] = {
+        {"baud", required_argument, nullptr, 'b'},
+        {"count", required_argument, nullptr, 'n'},
+        {"size", required_argument, nullptr, 's'},
+        {"rate", required_argument, nullptr, 'r'},
+        {"depth", required_argument, nullptr, 'd'},
+        {"id", required_argument, nullptr, 'i'},
+        {"file", required_argument, nullptr, 'f'},
+        {"wake", no_argument, nullptr, 'w'},
+        {"sim", no_argument, nullptr, 'S'},
+        {"bitrate", required_argument, nullptr, 'B'},
+        {nullptr, 0, nullptr, 0},
+    };
+
+    LoadOptions load;
+    ttgo::ClientOptions client_options;
+    SimOptions sim_options;
+    int baud = 115200;
+    bool simulate = false;
+    const char *file = nullptr;
+    int opt;
+
+    while ((opt = getopt_long(argc, argv, "b:n:s:r:d:i:f:w", long_options, nullptr)) != -1)
+    {
+        switch (opt)
+        {
+        case 'b': baud = atoi(optarg); break;
+        case 'n': load.count = atoi(optarg); break;
+        case 's': load.size = atoi(optarg); break;
+        case 'r': load.rate = atof(optarg); break;
+        case 'd': load.depth = atoi(optarg); break;
+        case 'i': load.first_id = strtoul(optarg, nullptr, 0); break;
+        case 'f': file = optarg; break;
+        case 'w': client_options.wake = true; break;
+        case 'S': simulate = true; break;
+        case 'B': sim_options.bitrate_bps = atof(optarg); break;
+        default: usage(argv[0]); return 2;
+        }
+    }
+
+    if ((simulate == (optind < argc)) || load.size < 1 || load.size > ttgo::MAX_MESSAGE || load.depth < 1)
+    {
+        usage(argv[0]);
+        return 2;
+    }
+
+    if (file != nullptr)
+    {
+        load.file = ttgo::MappedFile::open(file);
+        if (!load.file || load.file->size() == 0)
+        {
+            fprintf(stderr, "Cannot map %s: %s\n", file, load.file ? "file is empty" : strerror(errno));
+            return 1;
+        }
+    }
+
+    sim_options.baud = baud;
+    SimDevice sim(sim_options);
+    const char *port = simulate ? nullptr : argv[optind];
+
+    if (simulate)
+    {
+        if (!sim.start())
+        {
+            fprintf(stderr, "Cannot start simulator: %s\n", strerror(errno));
+            return 1;
+        }
+        port = sim.path().c_str();
+    }
+
+    int fd = serial_open(port, baud);
+    if (fd < 0)
+    {
+        fprintf(stderr, "Cannot open %s: %s\n", port, strerror(errno));
+        return 1;
+    }
+
+    ttgo::FskClient client(fd, client_options);
+    LoadResult result = run_load(client, load);
+    print_load_result(simulate ? "simulator" : port, load, result);
+
+    return result.failed ? 1 : 0;
+}
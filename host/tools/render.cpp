@@ -0,0 +1,396 @@
+// Offline baseband renderer: turns a payload into the IQ samples the radio
+// would send, using the firmware's framing and FSK settings, and demodulates
+// IQ files back into payloads to check transmit bitstreams without an SDR.
+
+#include <errno.h>
+#include <getopt.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include <string>
+#include <vector>
+
+#include "baseband.h"
+
+enum iq_format
+{
+    IQ_CF32,  // interleaved float32, as GNU Radio and SigMF cf32_le
+    IQ_CS16,  // interleaved int16, full scale 32767
+    IQ_CU8    // interleaved unsigned 8-bit around 127.5, as rtl_sdr writes
+};
+
+static void usage(const char *program)
+{
+    fprintf(stderr,
+            "Usage: %s [options] <payload> <out.iq>      render a packet\n"
+            "       %s -d [options] <in.iq> [payload]    demodulate and decode a packet\n"
+            "       %s -c [options] <payload>            render, demodulate and compare bits\n"
+            "  -r, --bitrate N     bit rate in kbps (default %g, TX_BITRATE)\n"
+            "  -D, --deviation N   frequency deviation in kHz (default %g, TX_DEVIATION)\n"
+            "  -g, --bt N          Gaussian shaping BT (0.3, 0.5, 1.0), 0 for none (default 0)\n"
+            "  -s, --sps N         samples per bit (default 16)\n"
+            "  -p, --preamble N    preamble bits (default %d, PREAMBLE_LENGTH)\n"
+            "  -S, --sync HEX      sync word (default 12AD)\n"
+            "  -C, --crc MODE      packet CRC: off, ccitt, ibm (default off)\n"
+            "  -w, --whitening     PN9 whitening, as set with the h command\n"
+            "  -f, --format F      cf32, cs16 or cu8 (default cf32)\n"
+            "  -F, --frequency N   carrier in MHz for .sigmf-meta (default %g, TX_FREQ_DEFAULT)\n"
+            "  -n, --repeat N      render the packet N times back to back (default 1)\n"
+            "  -l, --length N      payload bytes to decode (default: up to the end)\n",
+            program, program, program, TX_BITRATE, (double)TX_DEVIATION, PREAMBLE_LENGTH, TX_FREQ_DEFAULT);
+}
+
+static double now_s()
+{
+    timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static bool read_file(const char *path, std::vector<uint8_t> &data)
+{
+    FILE *file = fopen(path, "rb");
+    if (file == nullptr)
+    {
+        return false;
+    }
+
+    uint8_t chunk[65536];
+    size_t count;
+    while ((count = fread(chunk, 1, sizeof(chunk), file)) > 0)
+    {
+        data.insert(data.end(), chunk, chunk + count);
+    }
+
+    bool ok = !ferror(file);
+    fclose(file);
+    return ok;
+}
+
+static bool parse_hex(const char *text, std::vector<uint8_t> &bytes)
+{
+    size_t length = strlen(text);
+    if (length == 0 || length % 2 != 0)
+    {
+        return false;
+    }
+
+    bytes.clear();
+    for (size_t i = 0; i < length; i += 2)
+    {
+        char pair[3] = {text[i], text[i + 1], 0};
+        char *end;
+        bytes.push_back(strtoul(pair, &end, 16));
+        if (*end != 0)
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+static size_t sample_size(iq_format format)
+{
+    return format == IQ_CF32 ? 8 : format == IQ_CS16 ? 4 : 2;
+}
+
+static bool write_samples(FILE *file, iq_format format, const iq_sample *samples, size_t count)
+{
+    if (format == IQ_CF32)
+    {
+        return fwrite(samples, sizeof(iq_sample), count, file) == count;
+    }
+
+    static std::vector<uint8_t> converted;
+    converted.resize(count * sample_size(format));
+
+    for (size_t i = 0; i < count; i++)
+    {
+        if (format == IQ_CS16)
+        {
+            int16_t pair[2] = {(int16_t)lrintf(samples[i].real() * 32767), (int16_t)lrintf(samples[i].imag() * 32767)};
+            memcpy(&converted[i * 4], pair, sizeof(pair));
+        }
+        else
+        {
+            converted[i * 2] = (uint8_t)lrintf(127.5f + samples[i].real() * 127.5f);
+            converted[i * 2 + 1] = (uint8_t)lrintf(127.5f + samples[i].imag() * 127.5f);
+        }
+    }
+
+    return fwrite(converted.data(), 1, converted.size(), file) == converted.size();
+}
+
+static std::vector<iq_sample> decode_samples(const std::vector<uint8_t> &raw, iq_format format)
+{
+    size_t count = raw.size() / sample_size(format);
+    std::vector<iq_sample> samples(count);
+
+    for (size_t i = 0; i < count; i++)
+    {
+        if (format == IQ_CF32)
+        {
+            memcpy(&samples[i], &raw[i * 8], 8);
+        }
+        else if (format == IQ_CS16)
+        {
+            int16_t pair[2];
+            memcpy(pair, &raw[i * 4], sizeof(pair));
+            samples[i] = iq_sample(pair[0] / 32767.0f, pair[1] / 32767.0f);
+        }
+        else
+        {
+            samples[i] = iq_sample((raw[i * 2] - 127.5f) / 127.5f, (raw[i * 2 + 1] - 127.5f) / 127.5f);
+        }
+    }
+
+    return samples;
+}
+
+// SigMF metadata next to a .sigmf-data file, so SDR tools pick up the rate and format
+static void write_sigmf_meta(const std::string &data_path, iq_format format, double sample_rate,
+                             double frequency_mhz, const ModulatorOptions &modulator)
+{
+    static const char *datatypes[] = {"cf32_le", "ci16_le", "cu8"};
+    std::string meta_path = data_path.substr(0, data_path.size() - strlen(".sigmf-data")) + ".sigmf-meta";
+
+    FILE *file = fopen(meta_path.c_str(), "w");
+    if (file == nullptr)
+    {
+        fprintf(stderr, "Cannot write %s: %s\n", meta_path.c_str(), strerror(errno));
+        return;
+    }
+
+    fprintf(file,
+            "{\"global\": {\"core:datatype\": \"%s\", \"core:sample_rate\": %.1f, \"core:version\": \"1.0.0\",\n"
+            " \"core:description\": \"ttgo-fsk-tx baseband, %.3f kbps, deviation %.3f kHz, BT %.2f\"},\n"
+            " \"captures\": [{\"core:sample_start\": 0, \"core:frequency\": %.1f}],\n"
+            " \"annotations\": []}\n",
+            datatypes[format], sample_rate, modulator.bitrate_bps / 1000, modulator.deviation_hz / 1000,
+            modulator.bt, frequency_mhz * 1e6);
+    fclose(file);
+}
+
+static size_t count_bit_errors(const std::vector<uint8_t> &frame, const std::vector<uint8_t> &bits, size_t repeat)
+{
+    size_t errors = 0;
+    size_t expected_bits = frame.size() * 8 * repeat;
+
+    for (size_t i = 0; i < expected_bits; i++)
+    {
+        size_t bit = i % (frame.size() * 8);
+        uint8_t expected = (frame[bit / 8] >> (7 - bit % 8)) & 1;
+        errors += i >= bits.size() || bits[i] != expected;
+    }
+
+    return errors;
+}
+
+int main(int argc, char **argv)
+{
+    static const option long_options[] = {
+        {"demodulate", no_argument, nullptr, 'd'},
+        {"check", no_argument, nullptr, 'c'},
+        {"bitrate", required_argument, nullptr, 'r'},
+        {"deviation", required_argument, nullptr, 'D'},
+        {"bt", required_argument, nullptr, 'g'},
+        {"sps", required_argument, nullptr, 's'},
+        {"preamble", required_argument, nullptr, 'p'},
+        {"sync", required_argument, nullptr, 'S'},
+        {"crc", required_argument, nullptr, 'C'},
+        {"whitening", no_argument, nullptr, 'w'},
+        {"format", required_argument, nullptr, 'f'},
+        {"frequency", required_argument, nullptr, 'F'},
+        {"repeat", required_argument, nullptr, 'n'},
+        {"length", required_argument, nullptr, 'l'},
+        {nullptr, 0, nullptr, 0},
+    };
+
+    ModulatorOptions modulator;
+    FrameOptions framing;
+    iq_format format = IQ_CF32;
+    double frequency_mhz = TX_FREQ_DEFAULT;
+    bool demodulate_mode = false;
+    bool check_mode = false;
+    long repeat = 1;
+    size_t length = 0;
+    int opt;
+
+    while ((opt = getopt_long(argc, argv, "dcr:D:g:s:p:S:C:wf:F:n:l:", long_options, nullptr)) != -1)
+    {
+        switch (opt)
+        {
+        case 'd': demodulate_mode = true; break;
+        case 'c': check_mode = true; break;
+        case 'r': modulator.bitrate_bps = atof(optarg) * 1000; break;
+        case 'D': modulator.deviation_hz = atof(optarg) * 1000; break;
+        case 'g': modulator.bt = atof(optarg); break;
+        case 's': modulator.samples_per_bit = atoi(optarg); break;
+        case 'p': framing.preamble_bits = atoi(optarg); break;
+        case 'F': frequency_mhz = atof(optarg); break;
+        case 'n': repeat = atol(optarg); break;
+        case 'l': length = strtoul(optarg, nullptr, 0); break;
+        case 'w': framing.whitening = true; break;
+        case 'S':
+            if (!parse_hex(optarg, framing.sync))
+            {
+                usage(argv[0]);
+                return 2;
+            }
+            break;
+        case 'C':
+            framing.crc = !strcmp(optarg, "ccitt") ? 1 : !strcmp(optarg, "ibm") ? 2 : !strcmp(optarg, "off") ? 0 : -1;
+            break;
+        case 'f':
+            format = !strcmp(optarg, "cs16") ? IQ_CS16 : !strcmp(optarg, "cu8") ? IQ_CU8 : IQ_CF32;
+            if (format == IQ_CF32 && strcmp(optarg, "cf32") != 0)
+            {
+                usage(argv[0]);
+                return 2;
+            }
+            break;
+        default: usage(argv[0]); return 2;
+        }
+    }
+
+    int positional = argc - optind;
+    bool arguments_ok = demodulate_mode ? positional == 1 || positional == 2
+                        : check_mode     ? positional == 1
+                                         : positional == 2;
+
+    // Above 0.5 of the sample rate the per-sample phase step aliases
+    double max_deviation = modulator.bitrate_bps * modulator.samples_per_bit / 2;
+
+    if (!arguments_ok || (demodulate_mode && check_mode) || framing.crc < 0 || repeat < 1 ||
+        modulator.bitrate_bps <= 0 || modulator.samples_per_bit < 2 || modulator.bt < 0 ||
+        modulator.deviation_hz <= 0 || modulator.deviation_hz >= max_deviation || framing.preamble_bits < 0)
+    {
+        usage(argv[0]);
+        if (modulator.deviation_hz >= max_deviation)
+        {
+            fprintf(stderr, "Deviation must stay below %.0f Hz at this bit rate and sample count\n", max_deviation);
+        }
+        return 2;
+    }
+
+    std::vector<uint8_t> input;
+    if (!read_file(argv[optind], input))
+    {
+        fprintf(stderr, "Cannot read %s: %s\n", argv[optind], strerror(errno));
+        return 1;
+    }
+
+    if (demodulate_mode)
+    {
+        std::vector<iq_sample> samples = decode_samples(input, format);
+        int offset = find_bit_offset(samples.data(), samples.size(), modulator.samples_per_bit);
+        std::vector<uint8_t> bits = demodulate(samples.data(), samples.size(), modulator.samples_per_bit, offset);
+
+        std::vector<uint8_t> payload;
+        bool crc_ok;
+        size_t sync_bit;
+        if (!parse_frame(bits, length, framing, payload, crc_ok, sync_bit))
+        {
+            fprintf(stderr, "No sync word in %zu demodulated bits (bit timing offset %d)\n", bits.size(), offset);
+            return 1;
+        }
+
+        printf("bits=%zu offset=%d sync_bit=%zu payload=%zu crc=%s\n", bits.size(), offset, sync_bit,
+               payload.size(), framing.crc ? (crc_ok ? "ok" : "bad") : "off");
+
+        if (positional == 2)
+        {
+            FILE *out = fopen(argv[optind + 1], "wb");
+            if (out == nullptr || fwrite(payload.data(), 1, payload.size(), out) != payload.size())
+            {
+                fprintf(stderr, "Cannot write %s: %s\n", argv[optind + 1], strerror(errno));
+                return 1;
+            }
+            fclose(out);
+        }
+
+        return crc_ok ? 0 : 1;
+    }
+
+    std::vector<uint8_t> frame = build_frame(input.data(), input.size(), framing);
+    std::vector<uint8_t> stream;
+    stream.reserve(frame.size() * repeat);
+    for (long i = 0; i < repeat; i++)
+    {
+        stream.insert(stream.end(), frame.begin(), frame.end());
+    }
+
+    FskModulator fsk(modulator);
+    FILE *out = nullptr;
+    std::vector<iq_sample> rendered;
+    bool write_ok = true;
+
+    if (!check_mode)
+    {
+        out = fopen(argv[optind + 1], "wb");
+        if (out == nullptr)
+        {
+            fprintf(stderr, "Cannot write %s: %s\n", argv[optind + 1], strerror(errno));
+            return 1;
+        }
+    }
+
+    size_t samples = 0;
+    double start = now_s();
+    fsk.render(stream.data(), stream.size() * 8, [&](const iq_sample *block, size_t count)
+    {
+        samples += count;
+        if (check_mode)
+        {
+            rendered.insert(rendered.end(), block, block + count);
+        }
+        else
+        {
+            write_ok = write_ok && write_samples(out, format, block, count);
+        }
+    });
+    double elapsed = now_s() - start;
+
+    if (out != nullptr)
+    {
+        write_ok = fclose(out) == 0 && write_ok;
+        if (!write_ok)
+        {
+            fprintf(stderr, "Cannot write %s: %s\n", argv[optind + 1], strerror(errno));
+            return 1;
+        }
+
+        std::string path = argv[optind + 1];
+        if (path.size() > strlen(".sigmf-data") && path.compare(path.size() - strlen(".sigmf-data"), std::string::npos, ".sigmf-data") == 0)
+        {
+            write_sigmf_meta(path, format, fsk.sample_rate(), frequency_mhz, modulator);
+        }
+    }
+
+    double airtime = stream.size() * 8 / modulator.bitrate_bps;
+    printf("bits=%zu samples=%zu sample_rate=%.0f span=%d airtime_s=%.3f render_s=%.3f realtime_x=%.0f\n",
+           stream.size() * 8, samples, fsk.sample_rate(), fsk.span(), airtime, elapsed,
+           elapsed > 0 ? airtime / elapsed : 0.0);
+
+    if (!check_mode)
+    {
+        return 0;
+    }
+
+    std::vector<uint8_t> bits = demodulate(rendered.data(), rendered.size(), modulator.samples_per_bit, 0);
+    size_t errors = count_bit_errors(frame, bits, repeat);
+
+    std::vector<uint8_t> payload;
+    bool crc_ok = false;
+    size_t sync_bit = 0;
+    bool decoded = parse_frame(bits, input.size(), framing, payload, crc_ok, sync_bit) && payload == input;
+
+    printf("bit_errors=%zu decoded=%s crc=%s\n", errors, decoded ? "ok" : "bad",
+           framing.crc ? (crc_ok ? "ok" : "bad") : "off");
+
+    return errors == 0 && decoded && crc_ok ? 0 : 1;
+}
@@ -0,0 +1,254 @@
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <pty.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <termios.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <chrono>
+#include <set>
+
+#include "sim_device.h"
+
+// Time on air around the payload: preamble, sync word and length byte
+static const int AIR_OVERHEAD_BYTES = 8;
+
+static uint64_t now_ns()
+{
+    timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+static void sleep_until_ns(uint64_t deadline)
+{
+    timespec ts;
+    ts.tv_sec = deadline / 1000000000;
+    ts.tv_nsec = deadline % 1000000000;
+    while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, nullptr) == EINTR)
+    {
+    }
+}
+
+SimDevice::SimDevice(const SimOptions &options) : options(options)
+{
+}
+
+SimDevice::~SimDevice()
+{
+    stop();
+}
+
+bool SimDevice::start()
+{
+    char name[64];
+    if (openpty(&master, &slave, name, nullptr, nullptr) < 0)
+    {
+        return false;
+    }
+
+    termios tty;
+    tcgetattr(slave, &tty);
+    cfmakeraw(&tty);
+    tcsetattr(slave, TCSANOW, &tty);
+
+    slave_path = name;
+    running = true;
+    worker = std::thread(&SimDevice::run, this);
+    uart = std::thread(&SimDevice::run_uart, this);
+    return true;
+}
+
+void SimDevice::stop()
+{
+    if (running.exchange(false))
+    {
+        worker.join();
+        uart.join();
+    }
+
+    if (master >= 0)
+    {
+        close(master);
+        close(slave);
+        master = slave = -1;
+    }
+}
+
+// Moves bytes from the PTY into the receive buffer at the simulated line rate
+void SimDevice::run_uart()
+{
+    uint64_t byte_ns = 10000000000ULL / options.baud;
+    uint64_t line_free_ns = 0; // virtual time the line finishes the bytes taken so far
+    uint8_t chunk[64];
+
+    while (running)
+    {
+        size_t space;
+        {
+            std::lock_guard<std::mutex> guard(rx_lock);
+            space = options.rx_buffer - rx.size();
+        }
+
+        // A full buffer leaves data in the PTY, which pushes back on the host
+        pollfd pfd = {master, POLLIN, 0};
+        if (space == 0 || poll(&pfd, 1, 10) <= 0)
+        {
+            usleep(space == 0 ? 200 : 0);
+            continue;
+        }
+
+        ssize_t n = read(master, chunk, std::min(space, sizeof(chunk)));
+        if (n <= 0)
+        {
+            usleep(1000); // EIO until a host opens the PTY
+            continue;
+        }
+
+        uint64_t now = now_ns();
+        line_free_ns = (line_free_ns > now ? line_free_ns : now) + n * byte_ns;
+        sleep_until_ns(line_free_ns);
+
+        std::lock_guard<std::mutex> guard(rx_lock);
+        rx.insert(rx.end(), chunk, chunk + n);
+        rx_ready.notify_one();
+    }
+}
+
+// Reads exactly `length` bytes from the receive buffer
+bool SimDevice::receive(uint8_t *buffer, size_t length)
+{
+    std::unique_lock<std::mutex> guard(rx_lock);
+
+    for (size_t i = 0; i < length; i++)
+    {
+        while (rx.empty())
+        {
+            if (!running)
+            {
+                return false;
+            }
+            rx_ready.wait_for(guard, std::chrono::milliseconds(50));
+        }
+
+        buffer[i] = rx.front();
+        rx.pop_front();
+    }
+
+    return true;
+}
+
+void SimDevice::respond(const std::string &line)
+{
+    std::string out = line + "\r\n";
+    size_t written = 0;
+
+    while (written < out.size() && running)
+    {
+        ssize_t n = write(master, out.data() + written, out.size() - written);
+        if (n > 0)
+        {
+            written += n;
+        }
+        else
+        {
+            usleep(100);
+        }
+    }
+}
+
+void SimDevice::run()
+{
+    std::set<unsigned long> finished_ids;
+    static uint8_t payload[2048];
+    std::string line;
+
+    respond("INIT:0:Radio initialized successfully");
+
+    while (running)
+    {
+        uint8_t c;
+        if (!receive(&c, 1))
+        {
+            break;
+        }
+
+        if (c != '\n')
+        {
+            line += (char)c;
+            continue;
+        }
+
+        std::string command;
+        command.swap(line);
+        if (!command.empty() && command.back() == '\r')
+        {
+            command.pop_back();
+        }
+
+        sleep_until_ns(now_ns() + options.command_us * 1000ULL);
+
+        if (command.empty())
+        {
+            continue;
+        }
+
+        int length = 0;
+        unsigned long id = 0;
+        float value = 0;
+
+        if (command[0] == 'm' && sscanf(command.c_str() + 1, "%d %lu", &length, &id) >= 1 && length > 0)
+        {
+            if (id != 0 && finished_ids.count(id))
+            {
+                respond("CONSOLE:0:Duplicate of message " + std::to_string(id));
+                respond("TX:0:Message " + std::to_string(id) + " already transmitted");
+                continue;
+            }
+
+            if (length > 2048)
+            {
+                length = 2048;
+            }
+
+            respond("CONSOLE:0:Waiting for " + std::to_string(length) + " bytes");
+            if (!receive(payload, length))
+            {
+                break;
+            }
+            respond("CONSOLE:0:Accepted " + std::to_string(length) + " bytes");
+
+            // The console stays deaf while the packet is on air
+            if (options.bitrate_bps > 0)
+            {
+                sleep_until_ns(now_ns() + (uint64_t)((length + AIR_OVERHEAD_BYTES) * 8 * 1e9 / options.bitrate_bps));
+            }
+
+            if (id != 0)
+            {
+                finished_ids.insert(id);
+            }
+
+            respond("TX:0:Transmission finished successfully!");
+            respond("INIT:0:Radio set to standby mode.");
+        }
+        else if (command[0] == 'f' && sscanf(command.c_str() + 1, "%f", &value) == 1)
+        {
+            char reply[64];
+            snprintf(reply, sizeof(reply), "CONSOLE:0:Frequency set to %.4f", value);
+            respond(reply);
+        }
+        else if (command[0] == 'p' && sscanf(command.c_str() + 1, "%f", &value) == 1)
+        {
+            respond("CONSOLE:0:Transmit power set to " + std::to_string((int)value));
+        }
+        else
+        {
+            respond("CONSOLE:9:Unknown command");
+        }
+    }
+}
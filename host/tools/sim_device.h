@@ -0,0 +1,54 @@
+#pragma once
+
+#include <stdint.h>
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+
+// Simulated device on a PTY that answers the console protocol like the
+// firmware. A UART thread drains the PTY at the serial line rate into a
+// receive buffer of the firmware's size; the console does not read from it
+// while a transmission is on air, and replays results for repeated message IDs.
+struct SimOptions
+{
+    int baud = 115200;          // line rate the simulated UART drains at
+    double bitrate_bps = 0;     // on-air rate; 0 finishes transmissions immediately
+    int command_us = 50;        // console processing time per command
+    size_t rx_buffer = 8448;    // UART receive buffer (SERIAL_RX_BUFFER_SIZE)
+};
+
+class SimDevice
+{
+public:
+    explicit SimDevice(const SimOptions &options);
+    ~SimDevice();
+
+    // Creates the PTY and starts answering. Returns false with errno set on failure.
+    bool start();
+    void stop();
+
+    // Path host tools open as the device's serial port
+    const std::string &path() const { return slave_path; }
+
+private:
+    void run();
+    void run_uart();
+    bool receive(uint8_t *buffer, size_t length);
+    void respond(const std::string &line);
+
+    SimOptions options;
+    int master = -1;
+    int slave = -1;
+    std::string slave_path;
+    std::thread worker;
+    std::thread uart;
+    std::atomic<bool> running{false};
+
+    std::mutex rx_lock;
+    std::condition_variable rx_ready;
+    std::deque<uint8_t> rx;     // bytes received by the UART, not yet read by the console
+};
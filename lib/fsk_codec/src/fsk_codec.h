@@ -0,0 +1,176 @@
+#pragma once
+
+// Encoder kernels shared by the firmware and the host tools. Header-only and
+// free of platform dependencies so both build exactly the same code; host-only
+// vectorised variants of the bulk kernels live in fsk_codec_bulk.h.
+//
+// Bit order is MSB first throughout, as the SX127x shifts bytes out.
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Packet CRCs as computed by the SX127x packet engine: CCITT (poly 0x1021,
+// init 0x1D0F, result inverted) and IBM (poly 0x8005, init 0xFFFF)
+#define CODEC_CRC_CCITT_INIT 0x1D0F
+#define CODEC_CRC_IBM_INIT 0xFFFF
+
+// PN9 whitening (x^9 + x^5 + 1, seed 0x1FF) repeats every 511 bytes
+#define CODEC_PN9_PERIOD 511
+
+// BCH(31,21) generator x^10 + x^9 + x^8 + x^6 + x^5 + x^3 + 1, as used by POCSAG and FLEX
+#define CODEC_BCH_POLY 0x769
+
+static const uint16_t codec_crc_ccitt_nibbles[16] = {
+    0x0000, 0x1021, 0x2042, 0x3063, 0x4084, 0x50A5, 0x60C6, 0x70E7,
+    0x8108, 0x9129, 0xA14A, 0xB16B, 0xC18C, 0xD1AD, 0xE1CE, 0xF1EF};
+
+static const uint16_t codec_crc_ibm_nibbles[16] = {
+    0x0000, 0x8005, 0x800F, 0x000A, 0x801B, 0x001E, 0x0014, 0x8011,
+    0x8033, 0x0036, 0x003C, 0x8039, 0x0028, 0x802D, 0x8027, 0x0022};
+
+// Manchester code of one nibble: 0 becomes 10, 1 becomes 01 (IEEE 802.3)
+static const uint8_t codec_manchester_nibbles[16] = {
+    0xAA, 0xA9, 0xA6, 0xA5, 0x9A, 0x99, 0x96, 0x95,
+    0x6A, 0x69, 0x66, 0x65, 0x5A, 0x59, 0x56, 0x55};
+
+static inline uint16_t codec_crc16_init(bool ibm)
+{
+    return ibm ? CODEC_CRC_IBM_INIT : CODEC_CRC_CCITT_INIT;
+}
+
+// Feeds data into a running CRC; start from codec_crc16_init()
+static inline uint16_t codec_crc16_update(uint16_t crc, const uint8_t *data, size_t length, bool ibm)
+{
+    const uint16_t *table = ibm ? codec_crc_ibm_nibbles : codec_crc_ccitt_nibbles;
+
+    for (size_t i = 0; i < length; i++)
+    {
+        crc = (crc << 4) ^ table[(crc >> 12) ^ (data[i] >> 4)];
+        crc = (crc << 4) ^ table[(crc >> 12) ^ (data[i] & 0x0F)];
+    }
+
+    return crc;
+}
+
+static inline uint16_t codec_crc16_final(uint16_t crc, bool ibm)
+{
+    return ibm ? crc : crc ^ 0xFFFF;
+}
+
+static inline uint16_t codec_crc16(const uint8_t *data, size_t length, bool ibm)
+{
+    return codec_crc16_final(codec_crc16_update(codec_crc16_init(ibm), data, length, ibm), ibm);
+}
+
+// Writes `length` bytes of the PN9 sequence from its start
+static inline void codec_pn9_fill(uint8_t *out, size_t length)
+{
+    uint16_t lfsr = 0x1FF;
+
+    for (size_t i = 0; i < length; i++)
+    {
+        out[i] = lfsr & 0xFF;
+        for (int bit = 0; bit < 8; bit++)
+        {
+            lfsr = (lfsr >> 1) | (((lfsr >> 5) ^ lfsr) & 1) << 8;
+        }
+    }
+}
+
+// One period of the PN9 sequence, generated on first use by a thread-safe
+// static initialiser
+static inline const uint8_t *codec_pn9_table()
+{
+    struct pn9_period
+    {
+        uint8_t bytes[CODEC_PN9_PERIOD];
+    };
+
+    static const pn9_period table = [] {
+        pn9_period built;
+        codec_pn9_fill(built.bytes, CODEC_PN9_PERIOD);
+        return built;
+    }();
+
+    return table.bytes;
+}
+
+// Whitens (or de-whitens) data in place. `offset` is the position of data[0]
+// within the packet, so a packet can be processed in arbitrary pieces.
+static inline void codec_pn9_apply(uint8_t *data, size_t length, size_t offset)
+{
+    const uint8_t *table = codec_pn9_table();
+    size_t position = offset % CODEC_PN9_PERIOD;
+
+    for (size_t i = 0; i < length; i++)
+    {
+        data[i] ^= table[position];
+        if (++position == CODEC_PN9_PERIOD)
+        {
+            position = 0;
+        }
+    }
+}
+
+// Encodes 21 data bits into a 32-bit codeword: data, 10 check bits, even parity
+static inline uint32_t codec_bch3121_encode(uint32_t data)
+{
+    uint32_t word = (data & 0x1FFFFF) << 10;
+    uint32_t remainder = word;
+
+    for (int bit = 30; bit >= 10; bit--)
+    {
+        if (remainder & (1UL << bit))
+        {
+            remainder ^= (uint32_t)CODEC_BCH_POLY << (bit - 10);
+        }
+    }
+
+    word = (word | remainder) << 1;
+    return word | __builtin_parity(word);
+}
+
+// True if a 32-bit codeword has a zero syndrome and even parity
+static inline bool codec_bch3121_valid(uint32_t word)
+{
+    return codec_bch3121_encode(word >> 11) == word;
+}
+
+// Interleaves a block of 8 codewords bit by bit: the output carries bit 31 of
+// words 0..7, then bit 30 of words 0..7, and so on, 32 bytes in all
+static inline void codec_interleave8(const uint32_t words[8], uint8_t out[32])
+{
+    for (int k = 0; k < 32; k++)
+    {
+        uint8_t byte = 0;
+        for (int w = 0; w < 8; w++)
+        {
+            byte = (byte << 1) | ((words[w] >> (31 - k)) & 1);
+        }
+        out[k] = byte;
+    }
+}
+
+// Inverse of codec_interleave8()
+static inline void codec_deinterleave8(const uint8_t in[32], uint32_t words[8])
+{
+    for (int w = 0; w < 8; w++)
+    {
+        uint32_t word = 0;
+        for (int k = 0; k < 32; k++)
+        {
+            word = (word << 1) | ((in[k] >> (7 - w)) & 1);
+        }
+        words[w] = word;
+    }
+}
+
+// Manchester encodes `length` bytes into 2 * `length` bytes
+static inline void codec_manchester_encode(const uint8_t *in, size_t length, uint8_t *out)
+{
+    for (size_t i = 0; i < length; i++)
+    {
+        out[2 * i] = codec_manchester_nibbles[in[i] >> 4];
+        out[2 * i + 1] = codec_manchester_nibbles[in[i] & 0x0F];
+    }
+}
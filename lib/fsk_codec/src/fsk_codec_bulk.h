@@ -0,0 +1,176 @@
+#pragma once
+
+// Host-side bulk variants of the fsk_codec kernels. PN9 whitening, Manchester
+// coding and interleaving are vectorised with SSE2/SSSE3 on x86 and NEON on
+// ARM where the compiler enables them; the CRC is table-driven only, a byte
+// at a time instead of the nibble loop. Each produces exactly the output of
+// its scalar counterpart in fsk_codec.h, which it falls back to.
+
+#include <string.h>
+
+#include "fsk_codec.h"
+
+#if defined(__SSSE3__)
+#include <tmmintrin.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+#if defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
+// Byte-wide CRC tables, built on first use. The static initialiser is
+// thread-safe, as the Python binding calls in from several threads.
+static inline const uint16_t *codec_crc16_byte_table(bool ibm)
+{
+    struct crc_tables
+    {
+        uint16_t entries[2][256];
+    };
+
+    static const crc_tables tables = [] {
+        crc_tables built;
+        for (int t = 0; t < 2; t++)
+        {
+            for (int n = 0; n < 256; n++)
+            {
+                uint8_t byte = n;
+                built.entries[t][n] = codec_crc16_update(0, &byte, 1, t != 0);
+            }
+        }
+        return built;
+    }();
+
+    return tables.entries[ibm];
+}
+
+static inline uint16_t codec_crc16_update_bulk(uint16_t crc, const uint8_t *data, size_t length, bool ibm)
+{
+    const uint16_t *table = codec_crc16_byte_table(ibm);
+
+    for (size_t i = 0; i < length; i++)
+    {
+        crc = (crc << 8) ^ table[(crc >> 8) ^ data[i]];
+    }
+
+    return crc;
+}
+
+// PN9 sequence padded so that any 32 bytes starting within one period are contiguous
+static inline const uint8_t *codec_pn9_table_padded()
+{
+    struct pn9_padded
+    {
+        uint8_t bytes[CODEC_PN9_PERIOD + 32];
+    };
+
+    static const pn9_padded table = [] {
+        pn9_padded built;
+        memcpy(built.bytes, codec_pn9_table(), CODEC_PN9_PERIOD);
+        memcpy(built.bytes + CODEC_PN9_PERIOD, codec_pn9_table(), 32);
+        return built;
+    }();
+
+    return table.bytes;
+}
+
+static inline void codec_pn9_apply_bulk(uint8_t *data, size_t length, size_t offset)
+{
+    size_t position = offset % CODEC_PN9_PERIOD;
+    size_t i = 0;
+
+#if defined(__SSE2__) || defined(__ARM_NEON)
+    const uint8_t *table = codec_pn9_table_padded();
+
+    for (; i + 16 <= length; i += 16)
+    {
+#if defined(__SSE2__)
+        __m128i key = _mm_loadu_si128((const __m128i *)(table + position));
+        __m128i value = _mm_loadu_si128((const __m128i *)(data + i));
+        _mm_storeu_si128((__m128i *)(data + i), _mm_xor_si128(value, key));
+#else
+        vst1q_u8(data + i, veorq_u8(vld1q_u8(data + i), vld1q_u8(table + position)));
+#endif
+        position += 16;
+        if (position >= CODEC_PN9_PERIOD)
+        {
+            position -= CODEC_PN9_PERIOD;
+        }
+    }
+#endif
+
+    codec_pn9_apply(data + i, length - i, position);
+}
+
+static inline void codec_manchester_encode_bulk(const uint8_t *in, size_t length, uint8_t *out)
+{
+    size_t i = 0;
+
+#if defined(__SSSE3__)
+    const __m128i table = _mm_loadu_si128((const __m128i *)codec_manchester_nibbles);
+    const __m128i low_nibble = _mm_set1_epi8(0x0F);
+
+    for (; i + 16 <= length; i += 16)
+    {
+        __m128i value = _mm_loadu_si128((const __m128i *)(in + i));
+        __m128i high = _mm_shuffle_epi8(table, _mm_and_si128(_mm_srli_epi16(value, 4), low_nibble));
+        __m128i low = _mm_shuffle_epi8(table, _mm_and_si128(value, low_nibble));
+        _mm_storeu_si128((__m128i *)(out + 2 * i), _mm_unpacklo_epi8(high, low));
+        _mm_storeu_si128((__m128i *)(out + 2 * i + 16), _mm_unpackhi_epi8(high, low));
+    }
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+    const uint8x16_t table = vld1q_u8(codec_manchester_nibbles);
+
+    for (; i + 16 <= length; i += 16)
+    {
+        uint8x16_t value = vld1q_u8(in + i);
+        uint8x16x2_t pairs;
+        pairs.val[0] = vqtbl1q_u8(table, vshrq_n_u8(value, 4));
+        pairs.val[1] = vqtbl1q_u8(table, vandq_u8(value, vdupq_n_u8(0x0F)));
+        vst2q_u8(out + 2 * i, pairs);
+    }
+#endif
+
+    codec_manchester_encode(in + i, length - i, out + 2 * i);
+}
+
+// Interleaves `blocks` consecutive blocks of 8 codewords
+static inline void codec_interleave8_bulk(const uint32_t *words, size_t blocks, uint8_t *out)
+{
+#if defined(__SSSE3__)
+    // Lane i of the low half gathers byte j of word 7 - i, the high half byte j + 1,
+    // so each movemask yields one output byte for j and one for j + 1
+    const __m128i from_high_words[2] = {
+        _mm_setr_epi8(15, 11, 7, 3, -1, -1, -1, -1, 14, 10, 6, 2, -1, -1, -1, -1),
+        _mm_setr_epi8(13, 9, 5, 1, -1, -1, -1, -1, 12, 8, 4, 0, -1, -1, -1, -1)};
+    const __m128i from_low_words[2] = {
+        _mm_setr_epi8(-1, -1, -1, -1, 15, 11, 7, 3, -1, -1, -1, -1, 14, 10, 6, 2),
+        _mm_setr_epi8(-1, -1, -1, -1, 13, 9, 5, 1, -1, -1, -1, -1, 12, 8, 4, 0)};
+
+    for (size_t b = 0; b < blocks; b++)
+    {
+        __m128i low_words = _mm_loadu_si128((const __m128i *)(words + 8 * b));
+        __m128i high_words = _mm_loadu_si128((const __m128i *)(words + 8 * b + 4));
+        uint8_t *block = out + 32 * b;
+
+        for (int pair = 0; pair < 2; pair++)
+        {
+            __m128i bits = _mm_or_si128(_mm_shuffle_epi8(high_words, from_high_words[pair]),
+                                        _mm_shuffle_epi8(low_words, from_low_words[pair]));
+
+            for (int c = 0; c < 8; c++)
+            {
+                int mask = _mm_movemask_epi8(bits);
+                block[16 * pair + c] = mask & 0xFF;
+                block[16 * pair + 8 + c] = mask >> 8;
+                bits = _mm_add_epi8(bits, bits);
+            }
+        }
+    }
+#else
+    for (size_t b = 0; b < blocks; b++)
+    {
+        codec_interleave8(words + 8 * b, out + 32 * b);
+    }
+#endif
+}
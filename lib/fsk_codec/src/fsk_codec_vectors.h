@@ -0,0 +1,64 @@
+#pragma once
+
+// Golden vectors for the fsk_codec kernels. The CRC check values are the
+// catalogued CRC-16/AUG-CCITT (inverted) and CRC-16/CMS results, the PN9 bytes
+// are the published SX127x/CC1101 whitening sequence, and the BCH codewords are
+// the POCSAG sync and idle words. The remaining values come from an independent
+// bit-by-bit reference implementation.
+
+#include <string.h>
+
+#include "fsk_codec.h"
+
+static const uint8_t codec_vector_check[9] = {'1', '2', '3', '4', '5', '6', '7', '8', '9'};
+#define CODEC_VECTOR_CRC_CCITT 0x1A33
+#define CODEC_VECTOR_CRC_IBM 0xAEE7
+
+static const uint8_t codec_vector_pn9[16] = {
+    0xFF, 0xE1, 0x1D, 0x9A, 0xED, 0x85, 0x33, 0x24, 0xEA, 0x7A, 0xD2, 0x39, 0x70, 0x97, 0x57, 0x0A};
+
+#define CODEC_VECTOR_BCH_COUNT 5
+static const uint32_t codec_vector_bch_data[CODEC_VECTOR_BCH_COUNT] = {0x0F9A42, 0x0F5138, 0x000000, 0x1FFFFF, 0x012345};
+static const uint32_t codec_vector_bch_words[CODEC_VECTOR_BCH_COUNT] = {0x7CD215D8, 0x7A89C197, 0x00000000, 0xFFFFFFFF, 0x091A2C93};
+
+static const uint8_t codec_vector_manchester_in[4] = {0x00, 0xFF, 0xA5, 0x3C};
+static const uint8_t codec_vector_manchester_out[8] = {0xAA, 0xAA, 0x55, 0x55, 0x66, 0x99, 0xA5, 0x5A};
+
+static const uint32_t codec_vector_interleave_in[8] = {
+    0x7CD215D8, 0x7A89C197, 0x091A2C93, 0xFFFFFFFF, 0x00000000, 0x55E6F6DA, 0x00787949, 0x0AAAA9A9};
+static const uint8_t codec_vector_interleave_out[32] = {
+    0x10, 0xD4, 0xD0, 0xD4, 0xF1, 0x94, 0x51, 0x34, 0xD5, 0x96, 0x17, 0xB2, 0x73, 0x14, 0xB5, 0x50,
+    0x55, 0x56, 0x37, 0x96, 0x33, 0xB4, 0x14, 0xD3, 0xF5, 0x96, 0x11, 0xF4, 0x97, 0x50, 0x74, 0x73};
+
+// Checks the scalar kernels against the vectors. Returns the number of failures.
+static inline int codec_selftest()
+{
+    int failures = 0;
+
+    failures += codec_crc16(codec_vector_check, sizeof(codec_vector_check), false) != CODEC_VECTOR_CRC_CCITT;
+    failures += codec_crc16(codec_vector_check, sizeof(codec_vector_check), true) != CODEC_VECTOR_CRC_IBM;
+
+    uint8_t pn9[sizeof(codec_vector_pn9)] = {0};
+    codec_pn9_apply(pn9, sizeof(pn9), 0);
+    failures += memcmp(pn9, codec_vector_pn9, sizeof(pn9)) != 0;
+
+    for (int i = 0; i < CODEC_VECTOR_BCH_COUNT; i++)
+    {
+        failures += codec_bch3121_encode(codec_vector_bch_data[i]) != codec_vector_bch_words[i];
+        failures += !codec_bch3121_valid(codec_vector_bch_words[i]);
+    }
+    failures += codec_bch3121_valid(codec_vector_bch_words[0] ^ 0x100);
+
+    uint8_t manchester[sizeof(codec_vector_manchester_out)];
+    codec_manchester_encode(codec_vector_manchester_in, sizeof(codec_vector_manchester_in), manchester);
+    failures += memcmp(manchester, codec_vector_manchester_out, sizeof(manchester)) != 0;
+
+    uint8_t interleaved[32];
+    uint32_t words[8];
+    codec_interleave8(codec_vector_interleave_in, interleaved);
+    codec_deinterleave8(interleaved, words);
+    failures += memcmp(interleaved, codec_vector_interleave_out, sizeof(interleaved)) != 0;
+    failures += memcmp(words, codec_vector_interleave_in, sizeof(words)) != 0;
+
+    return failures;
+}
@@ -0,0 +1,283 @@
+#define RADIO_BOARD_AUTO
+
+#include <Arduino.h>
+#include <RadioLib.h>
+#include <RadioBoards.h>
+#include <fsk_codec_vectors.h>
+#include <string.h>
+
+#include "bench.h"
+#include "console_port.h"
+#include "defaults.h"
+#include "display.h"
+#include "heartbeat.h"
+#include "stats.h"
+#include "tx_feed.h"
+
+#define BENCH_FSK_MAX_BPS 300000 // Highest FSK bit rate of the SX127x
+
+extern Radio radio;
+
+extern volatile bool console_loop_enable;
+extern uint8_t tx_data_buffer[2048];
+
+extern void transmission_start();
+extern void transmission_service();
+
+// Bursts of FIFO writes with the radio in standby. Returns bytes per second
+// and stores the time of a single refill-sized burst in `refill_us`.
+static uint32_t bench_spi(uint32_t *refill_us)
+{
+    Module *mod = radio.getMod();
+    uint8_t chunk[RADIOLIB_SX127X_FIFO_THRESH - 1];
+    memset(chunk, 0x55, sizeof(chunk));
+
+    radio.standby();
+
+    uint32_t start = micros();
+    for (int i = 0; i < BENCH_SPI_BURSTS; i++)
+    {
+        mod->SPIwriteRegisterBurst(RADIOLIB_SX127X_REG_FIFO, chunk, sizeof(chunk));
+    }
+    uint32_t elapsed = micros() - start;
+
+    // Setting FifoOverrun clears the FIFO filled above
+    mod->SPIwriteRegister(RADIOLIB_SX127X_REG_IRQ_FLAGS_2, 0x10);
+
+    *refill_us = elapsed / BENCH_SPI_BURSTS;
+    return elapsed ? (uint32_t)((uint64_t)BENCH_SPI_BURSTS * sizeof(chunk) * 1000000 / elapsed) : 0;
+}
+
+static uint32_t bench_display()
+{
+    uint32_t start = micros();
+    for (int i = 0; i < BENCH_DISPLAY_ROUNDS; i++)
+    {
+        display_status();
+    }
+
+    return (micros() - start) / BENCH_DISPLAY_ROUNDS;
+}
+
+// Reads `length` bytes sent by the host and returns the rate in bytes per
+// second, timed from the first byte so host turnaround is excluded.
+static uint32_t bench_serial(int length)
+{
+    Console.print("CONSOLE:0:Waiting for ");
+    Console.print(length);
+    Console.println(" bytes");
+
+    while (Console.available() == 0)
+    {
+        heartbeat_receiving(length);
+    }
+
+    uint32_t start = micros();
+    int received = 0;
+#if defined(CONSOLE_UART_DRIVER) || defined(CONSOLE_DATA_PORT)
+    // Bulk reads, as the upload path uses with this console
+    Console.setTimeout(heartbeat_read_timeout_ms(1000));
+    while (received < length)
+    {
+        received += Console.readBytes(tx_data_buffer, min(length - received, (int)sizeof(tx_data_buffer)));
+        heartbeat_receiving(length - received);
+    }
+    Console.setTimeout(1000);
+#else
+    while (received < length)
+    {
+        if (Console.available())
+        {
+            Console.read();
+            received++;
+        }
+        else
+        {
+            heartbeat_receiving(length - received);
+        }
+    }
+#endif
+    uint32_t elapsed = micros() - start;
+
+    return elapsed ? (uint32_t)((uint64_t)length * 1000000 / elapsed) : 0;
+}
+
+// Throughput of the shared encoder kernels, in bytes (or BCH words) per second
+struct bench_codec_result
+{
+    int failures;
+    uint32_t crc_bps;
+    uint32_t pn9_bps;
+    uint32_t manchester_bps;
+    uint32_t interleave_bps;
+    uint32_t bch_wps;
+};
+
+static uint32_t bench_rate(uint32_t units, uint32_t elapsed_us)
+{
+    return elapsed_us ? (uint32_t)((uint64_t)units * 1000000 / elapsed_us) : 0;
+}
+
+// Checks the encoder kernels against their golden vectors, then times them
+static bench_codec_result bench_codec()
+{
+    static uint8_t encoded[2 * BENCH_CODEC_BYTES];
+    static uint32_t words[BENCH_CODEC_BYTES / 4];
+    const uint32_t bytes = BENCH_CODEC_BYTES * BENCH_CODEC_ROUNDS;
+    volatile uint16_t crc = 0;
+    bench_codec_result result;
+
+    result.failures = codec_selftest();
+
+    uint32_t start = micros();
+    for (int r = 0; r < BENCH_CODEC_ROUNDS; r++)
+    {
+        crc = codec_crc16(tx_data_buffer, BENCH_CODEC_BYTES, false);
+    }
+    result.crc_bps = bench_rate(bytes, micros() - start);
+
+    start = micros();
+    for (int r = 0; r < BENCH_CODEC_ROUNDS; r++)
+    {
+        codec_pn9_apply(encoded, BENCH_CODEC_BYTES, r);
+    }
+    result.pn9_bps = bench_rate(bytes, micros() - start);
+
+    start = micros();
+    for (int r = 0; r < BENCH_CODEC_ROUNDS; r++)
+    {
+        codec_manchester_encode(tx_data_buffer, BENCH_CODEC_BYTES, encoded);
+    }
+    result.manchester_bps = bench_rate(bytes, micros() - start);
+
+    start = micros();
+    for (int r = 0; r < BENCH_CODEC_ROUNDS; r++)
+    {
+        for (int i = 0; i < BENCH_CODEC_BYTES / 4; i++)
+        {
+            words[i] = codec_bch3121_encode(i + r + crc);
+        }
+    }
+    result.bch_wps = bench_rate(BENCH_CODEC_BYTES / 4 * BENCH_CODEC_ROUNDS, micros() - start);
+
+    start = micros();
+    for (int r = 0; r < BENCH_CODEC_ROUNDS; r++)
+    {
+        for (int b = 0; b < BENCH_CODEC_BYTES / 32; b++)
+        {
+            codec_interleave8(words + 8 * b, encoded + 32 * b);
+        }
+    }
+    result.interleave_bps = bench_rate(bytes, micros() - start);
+
+    return result;
+}
+
+// Sends a real packet so FIFO interrupt to refill latency can be sampled
+static void bench_on_air()
+{
+    stats_isr_refill = {0};
+    for (int i = 0; i < STATS_HIST_BUCKETS; i++)
+    {
+        stats_isr_refill_hist[i] = 0;
+    }
+
+    memset(tx_data_buffer, 0x55, BENCH_TX_BYTES);
+    tx_feed_single(tx_data_buffer, BENCH_TX_BYTES);
+
+    console_loop_enable = false;
+    transmission_start();
+
+    while (!console_loop_enable)
+    {
+        transmission_service();
+        heartbeat_loop();
+    }
+}
+
+// Runs the self-benchmark and prints every result on one BENCH line
+void bench_run(bool on_air, int serial_bytes)
+{
+    uint32_t refill_us;
+    uint32_t spi_bps = bench_spi(&refill_us);
+    uint32_t display_us = bench_display();
+    uint32_t serial_bps = serial_bytes > 0 ? bench_serial(serial_bytes) : 0;
+    bench_codec_result codec = bench_codec();
+    uint32_t underruns_before = stats_tx_underruns;
+
+    if (on_air)
+    {
+        bench_on_air();
+    }
+
+    // The FIFO interrupt fires on FifoEmpty, when only the byte in the shift
+    // register is left; it must last until the refill lands. Without a real
+    // transmission the worst main loop pass stands in for the interrupt latency.
+    uint32_t latency_us = on_air ? stats_isr_refill.max_us : stats_loop.max_us;
+    uint32_t budget_us = latency_us + (on_air ? stats_fifo_refill.max_us : refill_us);
+    uint32_t max_bps = budget_us ? min((uint32_t)(8 * 1000000 / budget_us), (uint32_t)BENCH_FSK_MAX_BPS) : BENCH_FSK_MAX_BPS;
+
+    Console.print("BENCH:0:loop_avg_us=");
+    Console.print(stats_loop.count ? stats_loop.total_us / stats_loop.count : 0);
+    Console.print(",loop_max_us=");
+    Console.print(stats_loop.max_us);
+    Console.print(",spi_fifo_Bps=");
+    Console.print(spi_bps);
+    Console.print(",refill_us=");
+    Console.print(refill_us);
+    Console.print(",display_us=");
+    Console.print(display_us);
+    Console.print(",serial_Bps=");
+    Console.print(serial_bps);
+#ifdef CONSOLE_UART_DRIVER
+    Console.print(",uart_driver=1,uart_overflows=");
+    Console.print(console_uart.overflows);
+#else
+    Console.print(",uart_driver=0");
+#endif
+#ifdef FIRMWARE_TASKS
+    Console.print(",tasks=1");
+#else
+    Console.print(",tasks=0");
+#endif
+#ifdef CONSOLE_DATA_PORT
+    // Which console ran the benchmark, so serial_Bps can be told apart
+    Console.print(console_active == &console_data ? ",data_port=1,data_overflows=" : ",data_port=0,data_overflows=");
+    Console.print(console_data.overflows);
+#endif
+
+    if (on_air)
+    {
+        Console.print(",isr_refill_avg_us=");
+        Console.print(stats_isr_refill.count ? stats_isr_refill.total_us / stats_isr_refill.count : 0);
+        Console.print(",isr_refill_max_us=");
+        Console.print(stats_isr_refill.max_us);
+        Console.print(",isr_refill_hist=");
+        for (int i = 0; i < STATS_HIST_BUCKETS; i++)
+        {
+            Console.print(stats_isr_refill_hist[i]);
+            if (i < STATS_HIST_BUCKETS - 1)
+            {
+                Console.print("/");
+            }
+        }
+        Console.print(",underruns=");
+        Console.print(stats_tx_underruns - underruns_before);
+    }
+
+    Console.print(",codec_ok=");
+    Console.print(codec.failures == 0 ? 1 : 0);
+    Console.print(",crc_Bps=");
+    Console.print(codec.crc_bps);
+    Console.print(",pn9_Bps=");
+    Console.print(codec.pn9_bps);
+    Console.print(",manchester_Bps=");
+    Console.print(codec.manchester_bps);
+    Console.print(",interleave_Bps=");
+    Console.print(codec.interleave_bps);
+    Console.print(",bch_wps=");
+    Console.print(codec.bch_wps);
+
+    Console.print(",max_bitrate_bps=");
+    Console.println(max_bps);
+}
@@ -0,0 +1,3 @@
+#pragma once
+
+void bench_run(bool on_air, int serial_bytes);
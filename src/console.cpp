@@ -1,10 +1,28 @@
 #define RADIO_BOARD_AUTO
 
-#include <HardwareSerial.h>
 #include <RadioLib.h>
 #include <RadioBoards.h>
+#include <esp_rom_crc.h>
 
+#include "bench.h"
+#include "console_port.h"
+#include "dedup.h"
+#include "defaults.h"
 #include "display.h"
+#include "flex.h"
+#include "framing.h"
+#include "heartbeat.h"
+#include "history.h"
+#include "idle.h"
+#include "lbt.h"
+#include "library.h"
+#include "profile.h"
+#include "provision.h"
+#include "slots.h"
+#include "stats.h"
+#include "taskstats.h"
+#include "tx_feed.h"
+#include "wallclock.h"
 
 extern Radio radio;
 
@@ -19,32 +37,470 @@ extern int16_t radio_start_transmit_status;
 extern float current_tx_frequency;
 extern float current_tx_power;
 
-String await_read_line()
+extern void transmission_queue();
+
+static char console_line[CONSOLE_LINE_MAX]; // Line collected so far from Serial
+static size_t console_line_length = 0;
+
+#ifdef CONSOLE_DATA_PORT
+Stream *console_active = &ConsoleUsb;
+#endif
+
+void console_set_baud(unsigned long baud)
+{
+#ifdef CONSOLE_DATA_PORT
+    if (console_active == &console_data)
+    {
+        console_data.updateBaudRate(baud);
+        return;
+    }
+#endif
+    ConsoleUsb.updateBaudRate(baud);
+}
+
+#ifndef CONSOLE_UART_DRIVER
+static volatile uint32_t console_usb_overflows = 0;
+
+void console_count_error(hardwareSerial_error_t error)
+{
+    if (error == UART_FIFO_OVF_ERROR || error == UART_BUFFER_FULL_ERROR)
+    {
+        console_usb_overflows++;
+    }
+}
+#endif
+
+uint32_t console_overflows()
+{
+#ifdef CONSOLE_DATA_PORT
+    if (console_active == &console_data)
+    {
+        return console_data.overflows;
+    }
+#endif
+#ifdef CONSOLE_UART_DRIVER
+    return console_uart.overflows;
+#else
+    return console_usb_overflows;
+#endif
+}
+
+unsigned long console_base_baud()
+{
+#ifdef CONSOLE_DATA_PORT
+    if (console_active == &console_data)
+    {
+        return DATA_PORT_BAUD;
+    }
+#endif
+    return TTGO_SERIAL_BAUD;
+}
+
+// Takes a complete line from the USB console, if one has arrived, into
+// `line`, a CONSOLE_LINE_MAX buffer
+static bool read_usb_line(char *line)
+{
+#ifdef CONSOLE_UART_DRIVER
+    return ConsoleUsb.readLine(line);
+#else
+    while (ConsoleUsb.available() > 0)
+    {
+        char c = ConsoleUsb.read();
+        if (c == '\n')
+        {
+            memcpy(line, console_line, console_line_length);
+            line[console_line_length] = '\0';
+            console_line_length = 0;
+            return true;
+        }
+        if (console_line_length < sizeof(console_line) - 1)
+        {
+            console_line[console_line_length++] = c;
+        }
+    }
+
+    return false;
+#endif
+}
+
+// Collects console input without blocking the main loop. Returns true and
+// fills `line` once a complete newline-terminated command has arrived.
+// With a data port, the port polled first alternates so that neither can
+// starve the other, and Console switches to the port the line came from.
+bool poll_read_line(char *line)
+{
+    bool input = ConsoleUsb.available() > 0;
+#ifdef CONSOLE_DATA_PORT
+    input = input || console_data.available() > 0;
+#endif
+    if (input)
+    {
+        idle_activity();
+    }
+
+    uint32_t start = micros();
+
+#ifdef CONSOLE_DATA_PORT
+    static bool data_first = false;
+    data_first = !data_first;
+
+    if (data_first && console_data.readLine(line))
+    {
+        console_active = &console_data;
+    }
+    else if (read_usb_line(line))
+    {
+        console_active = &ConsoleUsb;
+    }
+    else if (!data_first && console_data.readLine(line))
+    {
+        console_active = &console_data;
+    }
+    else
+    {
+        return false;
+    }
+#else
+    if (!read_usb_line(line))
+    {
+        return false;
+    }
+#endif
+
+    stats_record(stats_console_read, micros() - start);
+    return true;
+}
+
+// Blocks until `length` payload bytes have been read into `buffer`. Bulk
+// reads wait at most one heartbeat interval, so beats keep coming.
+void await_read_bytes(uint8_t *buffer, int length)
 {
-    String result = "";
-    while (true)
+    int received = 0;
+#if defined(CONSOLE_UART_DRIVER) || defined(CONSOLE_DATA_PORT)
+    Console.setTimeout(heartbeat_read_timeout_ms(1000));
+#endif
+    while (received < length)
     {
-        if (Serial.available() > 0)
+#if defined(CONSOLE_UART_DRIVER) || defined(CONSOLE_DATA_PORT)
+        received += Console.readBytes(buffer + received, length - received);
+#else
+        if (Console.available())
+        {
+            buffer[received++] = Console.read();
+            continue;
+        }
+#endif
+        heartbeat_receiving(length - received);
+    }
+#if defined(CONSOLE_UART_DRIVER) || defined(CONSOLE_DATA_PORT)
+    Console.setTimeout(1000);
+#endif
+}
+
+// Reads and drops `length` bytes, keeping the console in step with the host
+static void discard_bytes(int length)
+{
+    uint8_t scratch[64];
+
+    while (length > 0)
+    {
+        int count = min(length, (int)sizeof(scratch));
+        await_read_bytes(scratch, count);
+        length -= count;
+    }
+}
+
+// Patches tx_data_buffer with a delta of `delta_bytes`: records of a 16-bit
+// offset, a 16-bit length (both little-endian) and that many bytes, in
+// ascending order. Bytes past the base must all be covered. The whole delta
+// is read even when a record is invalid; the buffer is then left partly
+// patched, which the base CRC of the next delta catches.
+static bool apply_delta(int length, int base_length, int delta_bytes)
+{
+    int covered = base_length;  // the new payload is known up to here
+
+    while (delta_bytes > 0)
+    {
+        uint8_t header[4];
+
+        if (delta_bytes < (int)sizeof(header))
+        {
+            discard_bytes(delta_bytes);
+            return false;
+        }
+
+        await_read_bytes(header, sizeof(header));
+        delta_bytes -= sizeof(header);
+
+        int offset = header[0] | header[1] << 8;
+        int count = header[2] | header[3] << 8;
+
+        if (count > delta_bytes || offset + count > length)
+        {
+            discard_bytes(delta_bytes);
+            return false;
+        }
+
+        await_read_bytes(tx_data_buffer + offset, count);
+        delta_bytes -= count;
+
+        if (offset <= covered && offset + count > covered)
+        {
+            covered = offset + count;
+        }
+    }
+
+    return covered >= length;
+}
+
+// Answers a retried message ID with the result of the original attempt
+// instead of transmitting again. Returns false for new or absent IDs.
+bool replay_duplicate(uint32_t id)
+{
+    if (id == 0)
+    {
+        return false;
+    }
+
+    const dedup_entry *entry = dedup_find(id);
+    if (entry == nullptr)
+    {
+        return false;
+    }
+
+    Console.print("CONSOLE:0:Duplicate of message ");
+    Console.println(id);
+
+    if (entry->state == DEDUP_FINISHED)
+    {
+        Console.print("TX:");
+        Console.print(entry->result);
+        Console.print(":Message ");
+        Console.print(id);
+        Console.println(" already transmitted");
+    }
+    else
+    {
+        Console.print("TX:3:Message ");
+        Console.print(id);
+        Console.println(" was interrupted by a reset");
+    }
+
+    return true;
+}
+
+// Radio register profiles: `r m` reconfigures the modem through RadioLib,
+// `r c` captures the live registers under a name, `r a` applies a profile
+// in one burst, `r l` lists the profiles and `r e` erases one
+static void profile_command(const char *line)
+{
+    char op = line[2];
+    const char *args = line + 3;
+
+    if (op == 'm')
+    {
+        float bitrate = 0;
+        float deviation = 0;
+        float bandwidth = 0;
+        int preamble = -1;
+
+        if (sscanf(args, "%f %f %f %d", &bitrate, &deviation, &bandwidth, &preamble) != 4 || preamble < 0)
+        {
+            Console.println("CONSOLE:9:Invalid parameter");
+            return;
+        }
+
+        // The deviation is checked against the bit rate, so the bit rate goes first
+        uint32_t start = micros();
+        int16_t state = radio.setBitRate(bitrate);
+        if (state == RADIOLIB_ERR_NONE)
         {
-            char c = Serial.read();
-            if (c == '\n')
+            state = radio.setFrequencyDeviation(deviation);
+        }
+        if (state == RADIOLIB_ERR_NONE)
+        {
+            state = radio.setRxBandwidth(bandwidth);
+        }
+        if (state == RADIOLIB_ERR_NONE)
+        {
+            state = radio.setPreambleLength(preamble);
+        }
+        uint32_t elapsed = micros() - start;
+        stats_record(stats_reconfigure, elapsed);
+
+        if (state != RADIOLIB_ERR_NONE)
+        {
+            Console.println("CONSOLE:1:Failed to set modem");
+            return;
+        }
+
+        Console.print("CONSOLE:0:Modem set in ");
+        Console.print(elapsed);
+        Console.println(" us");
+        return;
+    }
+
+    if (op == 'l')
+    {
+        for (int slot = 0; slot < PROFILE_SLOTS; slot++)
+        {
+            if (profiles[slot].name[0] == '\0')
             {
-                return result;
+                continue;
             }
-            result += c;
+
+            Console.print("PROFILE:0:");
+            Console.print(profiles[slot].name);
+            Console.print(" slot=");
+            Console.print(slot);
+            Console.print(" freq=");
+            Console.print(profiles[slot].frequency, 4);
+            Console.print(" power=");
+            Console.println((int)profiles[slot].power);
+        }
+
+        Console.println("CONSOLE:0:Profiles listed");
+        return;
+    }
+
+    // One character more than a name may have, to catch names that are too long
+    char name[PROFILE_NAME_LENGTH + 2];
+    if (sscanf(args, " %16s", name) != 1 || strlen(name) > PROFILE_NAME_LENGTH)
+    {
+        Console.println("CONSOLE:9:Invalid parameter");
+        return;
+    }
+
+    int slot = profile_find(name);
+
+    switch (op)
+    {
+    case 'c':
+        slot = profile_capture(name, current_tx_frequency, current_tx_power);
+        if (slot < 0)
+        {
+            Console.println("CONSOLE:1:No free profile slot");
+            return;
+        }
+
+        if (!profile_save(slot))
+        {
+            Console.println("CONSOLE:1:Profile captured but not saved to NVS");
+            return;
+        }
+
+        Console.print("CONSOLE:0:Profile ");
+        Console.print(name);
+        Console.print(" saved in slot ");
+        Console.println(slot);
+        return;
+
+    case 'a':
+    {
+        if (slot < 0)
+        {
+            Console.println("CONSOLE:1:Unknown profile");
+            return;
+        }
+
+        uint32_t elapsed = profile_apply(slot);
+        current_tx_frequency = profiles[slot].frequency;
+        current_tx_power = profiles[slot].power;
+        display_status();
+
+        Console.print("CONSOLE:0:Profile ");
+        Console.print(name);
+        Console.print(" applied in ");
+        Console.print(elapsed);
+        Console.println(" us");
+        return;
+    }
+
+    case 'e':
+        if (slot < 0)
+        {
+            Console.println("CONSOLE:1:Unknown profile");
+            return;
+        }
+
+        if (!profile_erase(slot))
+        {
+            Console.println("CONSOLE:1:Failed to erase profile");
+            return;
         }
+
+        Console.print("CONSOLE:0:Profile ");
+        Console.print(name);
+        Console.println(" erased");
+        return;
+
+    default:
+        Console.println("CONSOLE:9:Invalid parameter");
     }
 }
 
-void console_loop()
+// Lists `count` history records from sequence number `from` as one compact
+// line each; a negative `from` counts back from the newest. Records already
+// overwritten are skipped, and the closing line gives the number to continue
+// from, so a host pages through the ring without missing or repeating any.
+static void history_list(int from, int count)
+{
+    uint32_t next = history_next();
+    uint32_t seq = from < 0 ? (uint32_t)max((int64_t)next + from, (int64_t)0) : (uint32_t)from;
+
+    if (next > HISTORY_ENTRIES && seq < next - HISTORY_ENTRIES)
+    {
+        seq = next - HISTORY_ENTRIES;
+    }
+
+    int listed = 0;
+    char text[160];
+
+    for (; seq < next && listed < count; seq++, listed++)
+    {
+        const history_record *r = history_get(seq);
+
+        snprintf(text, sizeof(text), "HIST:0:%lu,%lu,%lu,%lu,%lu,%d,%lu,%lu,%u,%lu,%u,%u",
+                 (unsigned long)seq, (unsigned long)r->time_ms, (unsigned long)r->id, (unsigned long)r->length,
+                 (unsigned long)r->frequency_khz, (int)r->power, (unsigned long)r->upload_us,
+                 (unsigned long)r->queue_us, (unsigned)r->first_bit_us, (unsigned long)r->airtime_ms,
+                 (unsigned)r->underruns, (unsigned)r->result);
+        Console.println(text);
+    }
+
+    Console.print("CONSOLE:0:Listed ");
+    Console.print(listed);
+    Console.print(" records, next ");
+    Console.print(seq);
+    Console.print(", uptime_ms ");
+    Console.println(millis());
+}
+
+// Runs at most one console command. Returns true if a command was handled.
+bool console_loop()
 {
     int state = RADIOLIB_ERR_NONE;
-    String line = await_read_line();
+    char line[CONSOLE_LINE_MAX];
 
-    if (line.length() < 3 || line[1] != ' ')
+    if (!poll_read_line(line))
     {
-        Serial.println("CONSOLE:9:Unknown command");
-        return;
+        return false;
+    }
+
+    history_command();
+
+    // Blank lines are used to wake the device from light sleep
+    if (line[0] == '\0')
+    {
+        return false;
+    }
+
+    idle_command();
+
+    if (strlen(line) < 3 || line[1] != ' ')
+    {
+        Console.println("CONSOLE:9:Unknown command");
+        return true;
     }
 
     char cmd = line[0];
@@ -53,17 +509,19 @@ void console_loop()
     {
     case 'f':
     {
-        float freq = line.substring(2).toFloat();
+        float freq = atof(line + 2);
+        uint32_t start = micros();
         state = radio.setFrequency(freq);
+        stats_record(stats_reconfigure, micros() - start);
 
         if (state != RADIOLIB_ERR_NONE)
         {
-            Serial.println("CONSOLE:1:Failed to set frequency");
-            return;
+            Console.println("CONSOLE:1:Failed to set frequency");
+            return true;
         }
 
-        Serial.print("CONSOLE:0:Frequency set to ");
-        Serial.println(freq, 4);
+        Console.print("CONSOLE:0:Frequency set to ");
+        Console.println(freq, 4);
 
         current_tx_frequency = freq;
         display_status();
@@ -73,17 +531,19 @@ void console_loop()
 
     case 'p':
     {
-        int power = line.substring(2).toInt();
+        int power = atoi(line + 2);
+        uint32_t start = micros();
         state = radio.setOutputPower(power);
+        stats_record(stats_reconfigure, micros() - start);
 
         if (state != RADIOLIB_ERR_NONE)
         {
-            Serial.println("CONSOLE:1:Failed to set transmit power");
-            return;
+            Console.println("CONSOLE:1:Failed to set transmit power");
+            return true;
         }
 
-        Serial.print("CONSOLE:0:Transmit power set to ");
-        Serial.println(power);
+        Console.print("CONSOLE:0:Transmit power set to ");
+        Console.println(power);
 
         current_tx_power = power;
         display_status();
@@ -93,45 +553,503 @@ void console_loop()
 
     case 'm':
     {
-        int bytes_to_read = line.substring(2).toInt();
+        int bytes_to_read = 0;
+        unsigned long id = 0;
 
-        if (bytes_to_read < 1)
+        if (sscanf(line + 2, "%d %lu", &bytes_to_read, &id) < 1 || bytes_to_read < 1)
+        {
+            Console.println("CONSOLE:9:Invalid parameter");
+            break;
+        }
+
+        if (replay_duplicate(id))
         {
-            Serial.println("CONSOLE:9:Invalid parameter");
             break;
         }
 
         if (bytes_to_read > 2048)
             bytes_to_read = 2048;
 
-        Serial.print("CONSOLE:0:Waiting for ");
-        Serial.print(bytes_to_read);
-        Serial.println(" bytes");
+        // Start sensing the channel now so RSSI settles while the payload uploads
+        if (lbt_enabled)
+        {
+            lbt_begin();
+        }
+
+        Console.print("CONSOLE:0:Waiting for ");
+        Console.print(bytes_to_read);
+        Console.println(" bytes");
+
+        await_read_bytes(tx_data_buffer, bytes_to_read);
+        current_tx_total_length = bytes_to_read;
+        tx_feed_single(tx_data_buffer, bytes_to_read);
+
+        Console.print("CONSOLE:0:Accepted ");
+        Console.print(current_tx_total_length);
+        Console.println(" bytes");
+
+        dedup_arm(id);
+        history_arm(id);
+        transmission_queue();
+        display_status();
+
+        break;
+    }
+
+    case 'd':
+    {
+        // Only the changed ranges of a payload; the rest is kept from the
+        // previous upload still in tx_data_buffer, checked by its CRC-32
+        int length = 0;
+        int base_length = 0;
+        unsigned long base_crc = 0;
+        int delta_bytes = 0;
+        unsigned long id = 0;
+
+        if (sscanf(line + 2, "%d %d %lx %d %lu", &length, &base_length, &base_crc, &delta_bytes, &id) < 4 ||
+            length < 1 || length > 2048 || base_length < 1 || base_length > 2048 || delta_bytes < 0)
+        {
+            Console.println("CONSOLE:9:Invalid parameter");
+            break;
+        }
+
+        if (replay_duplicate(id))
+        {
+            break;
+        }
+
+        if (esp_rom_crc32_le(0, tx_data_buffer, base_length) != base_crc)
+        {
+            Console.println("CONSOLE:1:Delta base mismatch");
+            break;
+        }
+
+        // Start sensing the channel now so RSSI settles while the delta uploads
+        if (lbt_enabled)
+        {
+            lbt_begin();
+        }
+
+        Console.print("CONSOLE:0:Waiting for ");
+        Console.print(delta_bytes);
+        Console.println(" bytes");
 
-        current_tx_total_length = 0;
-        while (current_tx_total_length < bytes_to_read)
+        if (!apply_delta(length, base_length, delta_bytes))
         {
-            if (Serial.available())
+            if (lbt_enabled)
             {
-                tx_data_buffer[current_tx_total_length++] = Serial.read();
+                radio.standby(); // Nothing to send after all, so stop the receiver
             }
+            Console.println("CONSOLE:1:Invalid delta");
+            break;
         }
 
-        Serial.print("CONSOLE:0:Accepted ");
-        Serial.print(current_tx_total_length);
-        Serial.println(" bytes");
+        current_tx_total_length = length;
+        tx_feed_single(tx_data_buffer, length);
 
-        fifo_empty = true;
-        console_loop_enable = false;
-        current_tx_remaining_length = current_tx_total_length;
-        radio_start_transmit_status = radio.startTransmit(tx_data_buffer, current_tx_total_length);
+        Console.print("CONSOLE:0:Accepted ");
+        Console.print(current_tx_total_length);
+        Console.println(" bytes");
 
+        dedup_arm(id);
+        history_arm(id);
+        transmission_queue();
         display_status();
 
         break;
     }
 
+    case 'w':
+    {
+        int slot = -1;
+        int bytes_to_read = 0;
+
+        if (sscanf(line + 2, "%d %d", &slot, &bytes_to_read) != 2 ||
+            slot < 0 || slot >= SLOT_COUNT || bytes_to_read < 0 || bytes_to_read > SLOT_SIZE)
+        {
+            Console.println("CONSOLE:9:Invalid parameter");
+            break;
+        }
+
+        Console.print("CONSOLE:0:Waiting for ");
+        Console.print(bytes_to_read);
+        Console.println(" bytes");
+
+        await_read_bytes(slot_data[slot], bytes_to_read);
+        slot_length[slot] = bytes_to_read;
+
+        Console.print("CONSOLE:0:Stored ");
+        Console.print(bytes_to_read);
+        Console.print(" bytes in slot ");
+        Console.println(slot);
+
+        break;
+    }
+
+    case 'g':
+    {
+        // Segment list such as "s0,i12,l3": sN is stored slot N, lN is payload
+        // library entry N, iN is N inline bytes uploaded after the command.
+        // Inline bytes land in tx_data_buffer back to back; slots and library
+        // entries are transmitted in place.
+        int inline_length = 0;
+        bool first = true;
+        bool valid = true;
+        const char *cursor = line + 2;
+
+        while (*cursor != '\0' && *cursor != ' ' && valid)
+        {
+            char kind = *cursor++;
+            int value = strtol(cursor, (char **)&cursor, 10);
+            const uint8_t *entry_data;
+            int entry_length;
+
+            if (kind == 'l' && library_get(value, &entry_data, &entry_length))
+            {
+                if (first)
+                    tx_feed_single(entry_data, entry_length);
+                else
+                    valid = tx_feed_append(entry_data, entry_length);
+            }
+            else if (kind == 's' && value >= 0 && value < SLOT_COUNT && slot_length[value] > 0)
+            {
+                if (first)
+                    tx_feed_single(slot_data[value], slot_length[value]);
+                else
+                    valid = tx_feed_append(slot_data[value], slot_length[value]);
+            }
+            else if (kind == 'i' && value > 0 && inline_length + value <= 2048)
+            {
+                if (first)
+                    tx_feed_single(tx_data_buffer + inline_length, value);
+                else
+                    valid = tx_feed_append(tx_data_buffer + inline_length, value);
+
+                inline_length += value;
+            }
+            else
+            {
+                valid = false;
+            }
+
+            first = false;
+
+            if (*cursor == ',')
+                cursor++;
+        }
+
+        if (!valid || first)
+        {
+            Console.println("CONSOLE:9:Invalid parameter");
+            break;
+        }
+
+        unsigned long id = strtoul(cursor, nullptr, 10);
+        if (replay_duplicate(id))
+        {
+            break;
+        }
+
+        if (lbt_enabled)
+        {
+            lbt_begin();
+        }
+
+        Console.print("CONSOLE:0:Waiting for ");
+        Console.print(inline_length);
+        Console.println(" bytes");
+
+        await_read_bytes(tx_data_buffer, inline_length);
+
+        Console.print("CONSOLE:0:Accepted ");
+        Console.print(inline_length);
+        Console.println(" bytes");
+
+        dedup_arm(id);
+        history_arm(id);
+        transmission_queue();
+        display_status();
+
+        break;
+    }
+
+    case 'x':
+    {
+        int index = -1;
+        unsigned long id = 0;
+        const uint8_t *entry_data;
+        int entry_length;
+
+        sscanf(line + 2, "%d %lu", &index, &id);
+
+        if (!library_get(index, &entry_data, &entry_length))
+        {
+            Console.println("CONSOLE:1:No such library entry");
+            break;
+        }
+
+        if (replay_duplicate(id))
+        {
+            break;
+        }
+
+        if (lbt_enabled)
+        {
+            lbt_begin();
+        }
+
+        // Streamed to the FIFO directly from the memory-mapped partition
+        tx_feed_single(entry_data, entry_length);
+
+        Console.print("CONSOLE:0:Transmitting library entry ");
+        Console.print(index);
+        Console.print(", ");
+        Console.print(entry_length);
+        Console.println(" bytes");
+
+        dedup_arm(id);
+        history_arm(id);
+        transmission_queue();
+        display_status();
+
+        break;
+    }
+
+    case 'u':
+    {
+        unsigned long baud = 0;
+        unsigned long offset = 0;
+        unsigned long size = 0;
+
+        if (sscanf(line + 2, "%lu %lu %lu", &baud, &offset, &size) != 3)
+        {
+            Console.println("CONSOLE:9:Invalid parameter");
+            break;
+        }
+
+        provision_run(baud, offset, size);
+
+        break;
+    }
+
+    case 't':
+    {
+        uint64_t epoch_ms = strtoull(line + 2, nullptr, 10);
+
+        if (epoch_ms == 0)
+        {
+            Console.println("CONSOLE:9:Invalid parameter");
+            break;
+        }
+
+        wallclock_set_ms(epoch_ms);
+        Console.println("CONSOLE:0:Clock synchronized");
+
+        break;
+    }
+
+    case 'q':
+    {
+        unsigned long capcode = 0;
+        int bytes_to_read = 0;
+
+        if (sscanf(line + 2, "%lu %d", &capcode, &bytes_to_read) != 2 || bytes_to_read < 1)
+        {
+            Console.println("CONSOLE:9:Invalid parameter");
+            break;
+        }
+
+        if (!wallclock_synced())
+        {
+            Console.println("CONSOLE:1:Clock not synchronized");
+            break;
+        }
+
+        uint8_t *page = flex_reserve(bytes_to_read);
+        if (page == nullptr)
+        {
+            Console.println("CONSOLE:1:FLEX queue full");
+            break;
+        }
+
+        Console.print("CONSOLE:0:Waiting for ");
+        Console.print(bytes_to_read);
+        Console.println(" bytes");
+
+        await_read_bytes(page, bytes_to_read);
+        int frame = flex_commit(capcode, bytes_to_read);
+
+        Console.print("CONSOLE:0:Queued ");
+        Console.print(bytes_to_read);
+        Console.print(" bytes for frame ");
+        Console.println(frame);
+
+        break;
+    }
+
+    case 'h':
+    {
+        int crc = -1;
+        int whitening = 0;
+
+        if (sscanf(line + 2, "%d %d", &crc, &whitening) < 1 || crc < FRAMING_CRC_OFF || crc > FRAMING_CRC_IBM)
+        {
+            Console.println("CONSOLE:9:Invalid parameter");
+            break;
+        }
+
+        state = framing_configure((framing_crc_mode)crc, whitening != 0);
+
+        if (state != RADIOLIB_ERR_NONE)
+        {
+            Console.println("CONSOLE:1:Failed to set hardware framing");
+            return true;
+        }
+
+        Console.print("CONSOLE:0:Hardware framing set to CRC ");
+        Console.print(crc == FRAMING_CRC_CCITT ? "CCITT" : crc == FRAMING_CRC_IBM ? "IBM" : "off");
+        Console.print(", whitening ");
+        Console.println(whitening ? "on" : "off");
+
+        break;
+    }
+
+    case 'i':
+    {
+        int mode = atoi(line + 2);
+
+        if (mode < IDLE_FULL_SPEED || mode > IDLE_LIGHT_SLEEP)
+        {
+            Console.println("CONSOLE:9:Invalid parameter");
+            break;
+        }
+
+        idle_policy = (idle_mode)mode;
+
+        Console.print("CONSOLE:0:Idle mode set to ");
+        Console.println(mode);
+
+        break;
+    }
+
+    case 'l':
+    {
+        float threshold = atof(line + 2);
+
+        // 0 dBm is never a sensible busy threshold, so it switches LBT off
+        if (threshold == 0)
+        {
+            lbt_enabled = false;
+            Console.println("CONSOLE:0:Listen-before-talk disabled");
+            break;
+        }
+
+        lbt_enabled = true;
+        lbt_threshold = threshold;
+
+        Console.print("CONSOLE:0:Listen-before-talk threshold set to ");
+        Console.println(threshold, 1);
+
+        break;
+    }
+
+    case 'r':
+    {
+        profile_command(line);
+        break;
+    }
+
+    case 'o':
+    {
+        int from = 0;
+        int count = 0;
+
+        if (sscanf(line + 2, "%d %d", &from, &count) != 2 || count < 1)
+        {
+            Console.println("CONSOLE:9:Invalid parameter");
+            break;
+        }
+
+        history_list(from, min(count, HISTORY_PAGE_MAX));
+        break;
+    }
+
+    case 'k':
+    {
+        int interval = atoi(line + 2);
+
+        if (interval != 0 && (interval < HEARTBEAT_MIN_MS || interval > HEARTBEAT_MAX_MS))
+        {
+            Console.println("CONSOLE:9:Invalid parameter");
+            break;
+        }
+
+        heartbeat_set(interval);
+
+        if (interval == 0)
+        {
+            Console.println("CONSOLE:0:Heartbeat off");
+            break;
+        }
+
+        Console.print("CONSOLE:0:Heartbeat every ");
+        Console.print(interval);
+        Console.println(" ms");
+
+        break;
+    }
+
+    case 'b':
+    {
+        int on_air = 0;
+        int serial_bytes = 0;
+
+        if (sscanf(line + 2, "%d %d", &on_air, &serial_bytes) < 1 || serial_bytes < 0)
+        {
+            Console.println("CONSOLE:9:Invalid parameter");
+            break;
+        }
+
+        bench_run(on_air != 0, serial_bytes);
+        Console.println("CONSOLE:0:Benchmark complete");
+
+        break;
+    }
+
+    case 'c':
+    {
+        int refresh = atoi(line + 2);
+
+        if (refresh)
+        {
+            taskstats_snapshot();
+        }
+
+        taskstats_report();
+        Console.println("CONSOLE:0:Tasks reported");
+
+        break;
+    }
+
+    case 's':
+    {
+        int reset = atoi(line + 2);
+
+        stats_report();
+
+        if (reset)
+        {
+            stats_reset();
+        }
+
+        Console.println("CONSOLE:0:Stats reported");
+
+        break;
+    }
+
     default:
-        Serial.println("CONSOLE:9:Unknown command");
+        Console.println("CONSOLE:9:Unknown command");
     }
-}
\ No newline at end of file
+
+    return true;
+}
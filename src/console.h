@@ -1 +1 @@
-void console_loop();
\ No newline at end of file
+bool console_loop();
\ No newline at end of file
@@ -0,0 +1,37 @@
+#pragma once
+
+// The serial port the console talks through. The default build uses the
+// Arduino HardwareSerial; builds with CONSOLE_UART_DRIVER (the
+// ttgo-lora32-v21-uart env) drive UART0 through the ESP-IDF UART driver
+// directly, see console_uart.h.
+#ifdef CONSOLE_UART_DRIVER
+#include "console_uart.h"
+#define ConsoleUsb console_uart
+#else
+#include <HardwareSerial.h>
+#define ConsoleUsb Serial
+
+// Receive error callback for Serial, counts FIFO and buffer overflows
+void console_count_error(hardwareSerial_error_t error);
+#endif
+
+// Builds with CONSOLE_DATA_PORT (the ttgo-lora32-v21-data env) also take
+// commands on a second UART, console_data. Console is then the port the
+// command being handled came from, so its replies, including the TX result,
+// go back there; output before the first command goes to USB.
+#ifdef CONSOLE_DATA_PORT
+#include <Stream.h>
+#include "console_uart.h"
+extern Stream *console_active;
+#define Console (*console_active)
+#else
+#define Console ConsoleUsb
+#endif
+
+// Baud rate of the port Console refers to: changes it, and returns the rate
+// it runs at outside of provisioning
+void console_set_baud(unsigned long baud);
+unsigned long console_base_baud();
+
+// Receive FIFO or buffer overflows counted so far on the port Console refers to
+uint32_t console_overflows();
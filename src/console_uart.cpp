@@ -0,0 +1,252 @@
+#if defined(CONSOLE_UART_DRIVER) || defined(CONSOLE_DATA_PORT)
+
+#include <Arduino.h>
+#include <driver/uart.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/queue.h>
+#include <freertos/task.h>
+
+#include "console_uart.h"
+#include "defaults.h"
+
+#ifdef CONSOLE_UART_DRIVER
+ConsoleUart console_uart(UART_NUM_0, "console_uart");
+#endif
+#ifdef CONSOLE_DATA_PORT
+ConsoleUart console_data((uart_port_t)DATA_PORT_UART, "data_uart");
+#endif
+
+ConsoleUart::ConsoleUart(uart_port_t port, const char *task_name) : port(port), task_name(task_name)
+{
+}
+
+// Drains the driver's event queue. Data and newline events wake the task
+// given to notify(), if any, which then polls readLine(); overflows are
+// counted for `s`.
+void ConsoleUart::event_task(void *arg)
+{
+    ConsoleUart *uart = (ConsoleUart *)arg;
+    uart_event_t event;
+
+    while (true)
+    {
+        if (xQueueReceive(uart->events, &event, portMAX_DELAY) != pdTRUE)
+        {
+            continue;
+        }
+
+        if (event.type == UART_FIFO_OVF || event.type == UART_BUFFER_FULL)
+        {
+            uart->overflows++;
+        }
+        else if ((event.type == UART_DATA || event.type == UART_PATTERN_DET) && uart->notify_task != nullptr)
+        {
+            xTaskNotifyGive(uart->notify_task);
+        }
+    }
+}
+
+// Wakes `task` with a task notification whenever input arrives
+void ConsoleUart::notify(TaskHandle_t task)
+{
+    notify_task = task;
+}
+
+void ConsoleUart::setRxBufferSize(size_t size)
+{
+    rx_buffer_size = size;
+}
+
+// Pins default to the port's current ones; an RTS pin enables hardware flow
+// control, which holds off the sender before the ring buffer overflows
+void ConsoleUart::begin(unsigned long baud, int rx_pin, int tx_pin, int rts_pin)
+{
+    uart_config_t config = {};
+    config.baud_rate = baud;
+    config.data_bits = UART_DATA_8_BITS;
+    config.parity = UART_PARITY_DISABLE;
+    config.stop_bits = UART_STOP_BITS_1;
+    config.flow_ctrl = rts_pin >= 0 ? UART_HW_FLOWCTRL_RTS : UART_HW_FLOWCTRL_DISABLE;
+    config.rx_flow_ctrl_thresh = CONSOLE_UART_RTS_THRESHOLD;
+    config.source_clk = UART_SCLK_APB;
+
+    // No transmit ring buffer: writes return once the bytes are in the FIFO, so
+    // flush() before a baud change or light sleep covers everything printed
+    uart_driver_install(port, rx_buffer_size, 0, CONSOLE_UART_EVENT_QUEUE, &events, 0);
+    uart_param_config(port, &config);
+    uart_set_pin(port, tx_pin, rx_pin, rts_pin, UART_PIN_NO_CHANGE);
+
+    // Hand bytes to the driver after a short gap instead of the default 10
+    // symbols, and leave the interrupt more of the FIFO as headroom at high
+    // baud rates
+    uart_set_rx_timeout(port, CONSOLE_UART_RX_TIMEOUT);
+    uart_set_rx_full_threshold(port, CONSOLE_UART_RX_FULL_THRESHOLD);
+
+    uart_enable_pattern_det_baud_intr(port, '\n', 1, 9, 0, 0);
+    uart_pattern_queue_reset(port, CONSOLE_UART_PATTERN_QUEUE);
+
+    xTaskCreatePinnedToCore(event_task, task_name, 2048, this, CONSOLE_UART_TASK_PRIORITY, nullptr, 0);
+}
+
+void ConsoleUart::updateBaudRate(unsigned long baud)
+{
+    uart_set_baudrate(port, baud);
+}
+
+// Adds to the line collected so far, dropping what does not fit
+void ConsoleUart::append(const char *data, size_t length)
+{
+    size_t count = min(length, sizeof(partial) - 1 - partial_length);
+    memcpy(partial + partial_length, data, count);
+    partial_length += count;
+}
+
+// Hands the collected line to `line`, a CONSOLE_LINE_MAX buffer, and starts the next
+void ConsoleUart::take_line(char *line)
+{
+    memcpy(line, partial, partial_length);
+    line[partial_length] = '\0';
+    partial_length = 0;
+}
+
+// Takes one newline-terminated line, without the newline, in a single read
+// at the position the pattern detection recorded. Binary payloads contain
+// newlines too, but their positions drop out of the queue as the payload is
+// read. Should the position queue still overflow, input that has waited
+// CONSOLE_UART_LINE_FALLBACK_MS without a detected newline is scanned byte
+// by byte instead.
+bool ConsoleUart::readLine(char *line)
+{
+    char chunk[64];
+
+    // A byte taken by peek() is no longer in the driver or its position queue
+    if (peeked >= 0)
+    {
+        int c = peeked;
+        peeked = -1;
+        if (c == '\n')
+        {
+            take_line(line);
+            return true;
+        }
+        char byte = c;
+        append(&byte, 1);
+    }
+
+    int position = uart_pattern_pop_pos(port);
+    if (position < 0)
+    {
+        if (available() == 0)
+        {
+            waiting_ms = 0;
+            return false;
+        }
+
+        if (waiting_ms == 0)
+        {
+            waiting_ms = millis() | 1;
+        }
+
+        if (millis() - waiting_ms < CONSOLE_UART_LINE_FALLBACK_MS)
+        {
+            return false;
+        }
+
+        while (available() > 0)
+        {
+            int c = read();
+            if (c == '\n')
+            {
+                take_line(line);
+                waiting_ms = 0;
+                return true;
+            }
+            char byte = c;
+            append(&byte, 1);
+        }
+
+        return false;
+    }
+
+    waiting_ms = 0;
+
+    // The position is counted from the driver's read pointer; the newline itself is read and dropped
+    int remaining = position + 1;
+    while (remaining > 0)
+    {
+        int count = uart_read_bytes(port, (uint8_t *)chunk, min(remaining, (int)sizeof(chunk)), portMAX_DELAY);
+        if (count <= 0)
+        {
+            break;
+        }
+        remaining -= count;
+        append(chunk, remaining > 0 ? count : count - 1);
+    }
+
+    take_line(line);
+    return true;
+}
+
+int ConsoleUart::available()
+{
+    size_t length = 0;
+    uart_get_buffered_data_len(port, &length);
+    return length + (peeked >= 0 ? 1 : 0);
+}
+
+int ConsoleUart::read()
+{
+    if (peeked >= 0)
+    {
+        int c = peeked;
+        peeked = -1;
+        return c;
+    }
+
+    uint8_t c;
+    return uart_read_bytes(port, &c, 1, 0) == 1 ? c : -1;
+}
+
+int ConsoleUart::peek()
+{
+    if (peeked < 0)
+    {
+        peeked = read();
+    }
+    return peeked;
+}
+
+void ConsoleUart::flush()
+{
+    uart_wait_tx_done(port, portMAX_DELAY);
+}
+
+// Blocks for up to the stream timeout, like Stream::readBytes, but hands the
+// whole request to the driver instead of polling byte by byte
+size_t ConsoleUart::readBytes(char *buffer, size_t length)
+{
+    size_t received = 0;
+
+    if (peeked >= 0 && length > 0)
+    {
+        buffer[received++] = (char)peeked;
+        peeked = -1;
+    }
+
+    int count = uart_read_bytes(port, (uint8_t *)buffer + received, length - received,
+                                pdMS_TO_TICKS(getTimeout()));
+    return received + (count > 0 ? count : 0);
+}
+
+size_t ConsoleUart::write(uint8_t c)
+{
+    return write(&c, 1);
+}
+
+size_t ConsoleUart::write(const uint8_t *buffer, size_t size)
+{
+    int written = uart_write_bytes(port, (const char *)buffer, size);
+    return written > 0 ? written : 0;
+}
+
+#endif
@@ -0,0 +1,62 @@
+#pragma once
+
+#include <Arduino.h>
+#include <Stream.h>
+#include <driver/uart.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+
+#include "defaults.h"
+
+// Console on the ESP-IDF UART driver instead of HardwareSerial. The UART's
+// pattern detection marks every newline, so a command line is taken from
+// the driver in one read instead of byte by byte, and payloads are read in
+// bulk. An event task drains the driver's event queue and counts overflows.
+// UART0 carries the USB console in CONSOLE_UART_DRIVER builds; UART1 is the
+// data port of CONSOLE_DATA_PORT builds.
+class ConsoleUart : public Stream
+{
+public:
+    ConsoleUart(uart_port_t port, const char *task_name);
+
+    void setRxBufferSize(size_t size);
+    void begin(unsigned long baud, int rx_pin = UART_PIN_NO_CHANGE, int tx_pin = UART_PIN_NO_CHANGE,
+               int rts_pin = UART_PIN_NO_CHANGE);
+    void updateBaudRate(unsigned long baud);
+    bool readLine(char *line);
+    void notify(TaskHandle_t task);
+
+    int available() override;
+    int read() override;
+    int peek() override;
+    void flush() override;
+    size_t readBytes(char *buffer, size_t length) override;
+    size_t readBytes(uint8_t *buffer, size_t length) { return readBytes((char *)buffer, length); }
+    size_t write(uint8_t c) override;
+    size_t write(const uint8_t *buffer, size_t size) override;
+    using Print::write;
+
+    volatile uint32_t overflows = 0;  // receive FIFO or ring buffer overflows
+
+private:
+    static void event_task(void *arg);
+    void append(const char *data, size_t length);
+    void take_line(char *line);
+
+    uart_port_t port;
+    const char *task_name;
+    QueueHandle_t events = nullptr;
+    TaskHandle_t notify_task = nullptr; // woken when input arrives
+    size_t rx_buffer_size = 256;
+    int peeked = -1;         // byte taken from the driver by peek(), or -1
+    char partial[CONSOLE_LINE_MAX];  // line collected so far
+    size_t partial_length = 0;
+    uint32_t waiting_ms = 0; // when buffered input without a detected newline was first seen
+};
+
+#ifdef CONSOLE_UART_DRIVER
+extern ConsoleUart console_uart;
+#endif
+#ifdef CONSOLE_DATA_PORT
+extern ConsoleUart console_data;
+#endif
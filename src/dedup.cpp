@@ -0,0 +1,141 @@
+#include <Arduino.h>
+#include <Preferences.h>
+#include <esp_attr.h>
+#include <string.h>
+
+#include "dedup.h"
+#include "defaults.h"
+
+#define DEDUP_MAGIC 0x44445550 // "DDUP"
+
+// Kept in RTC memory that startup code leaves alone, so the table survives
+// software, panic and watchdog resets. The host's reset after a timeout
+// pulls EN, a chip reset that the ESP32 reports as a power-on reset; RTC
+// memory is not guaranteed to survive it. So every finished result is also
+// saved in NVS, which restores the table when the RTC copy is lost. Only a
+// transmission cut short by that reset is then forgotten; NVS is not
+// written while a packet is on air, because a flash write stalls the FIFO
+// refill interrupt.
+struct dedup_table
+{
+    uint32_t magic;
+    uint32_t next;  // Slot that the next new ID overwrites
+    dedup_entry entries[DEDUP_ENTRIES];
+    uint32_t checksum;
+};
+
+RTC_NOINIT_ATTR static dedup_table dedup;
+
+static Preferences dedup_store;
+
+static uint32_t dedup_armed_id = 0;     // ID of the transmission being prepared, 0 for none
+static dedup_entry *dedup_current = nullptr;
+
+static uint32_t dedup_checksum()
+{
+    const uint8_t *bytes = (const uint8_t *)&dedup;
+    uint32_t sum = 0;
+
+    for (size_t i = 0; i < offsetof(dedup_table, checksum); i++)
+    {
+        sum = sum * 31 + bytes[i];
+    }
+
+    return sum;
+}
+
+static void dedup_seal()
+{
+    dedup.checksum = dedup_checksum();
+}
+
+static bool dedup_valid()
+{
+    return dedup.magic == DEDUP_MAGIC && dedup.next < DEDUP_ENTRIES && dedup.checksum == dedup_checksum();
+}
+
+// Keeps the table if it survived a reset intact, otherwise restores the copy
+// saved in NVS, otherwise clears it
+dedup_source dedup_begin()
+{
+    bool stored = dedup_store.begin(DEDUP_NVS_NAMESPACE, false);
+
+    if (dedup_valid())
+    {
+        return DEDUP_FROM_RTC;
+    }
+
+    if (stored && dedup_store.getBytesLength("table") == sizeof(dedup) &&
+        dedup_store.getBytes("table", &dedup, sizeof(dedup)) == sizeof(dedup) && dedup_valid())
+    {
+        return DEDUP_FROM_NVS;
+    }
+
+    memset(&dedup, 0, sizeof(dedup));
+    dedup.magic = DEDUP_MAGIC;
+    dedup_seal();
+    return DEDUP_CLEARED;
+}
+
+const dedup_entry *dedup_find(uint32_t id)
+{
+    for (int i = 0; i < DEDUP_ENTRIES; i++)
+    {
+        if (dedup.entries[i].state != DEDUP_EMPTY && dedup.entries[i].id == id)
+        {
+            return &dedup.entries[i];
+        }
+    }
+
+    return nullptr;
+}
+
+// Tags the next transmission with a message ID (0 leaves it untagged)
+void dedup_arm(uint32_t id)
+{
+    dedup_armed_id = id;
+}
+
+// Drops the tag of a transmission that never went on air, so it can be retried
+void dedup_disarm()
+{
+    dedup_armed_id = 0;
+}
+
+// Records the armed ID once the radio has started transmitting
+void dedup_start()
+{
+    dedup_current = nullptr;
+
+    if (dedup_armed_id == 0)
+    {
+        return;
+    }
+
+    dedup_current = &dedup.entries[dedup.next];
+    dedup.next = (dedup.next + 1) % DEDUP_ENTRIES;
+
+    dedup_current->id = dedup_armed_id;
+    dedup_current->result = 0;
+    dedup_current->state = DEDUP_STARTED;
+    dedup_armed_id = 0;
+
+    dedup_seal();
+}
+
+void dedup_finish(int16_t result)
+{
+    if (dedup_current == nullptr)
+    {
+        return;
+    }
+
+    dedup_current->result = result;
+    dedup_current->state = DEDUP_FINISHED;
+    dedup_current = nullptr;
+
+    dedup_seal();
+
+    // The packet has left the radio, so the flash write stalls nothing
+    dedup_store.putBytes("table", &dedup, sizeof(dedup));
+}
@@ -0,0 +1,32 @@
+#pragma once
+
+#include <stdint.h>
+
+enum dedup_state : uint8_t
+{
+    DEDUP_EMPTY = 0,
+    DEDUP_STARTED,  // Went on air, no result recorded (e.g. reset mid-transmission)
+    DEDUP_FINISHED
+};
+
+struct dedup_entry
+{
+    uint32_t id;
+    int16_t result;  // TX result code of the original attempt
+    dedup_state state;
+};
+
+// Where dedup_begin found the table
+enum dedup_source : uint8_t
+{
+    DEDUP_FROM_RTC = 0,  // RTC memory kept it through the reset
+    DEDUP_FROM_NVS,      // RTC memory was lost; results saved in NVS restored
+    DEDUP_CLEARED        // nothing valid, starting empty
+};
+
+dedup_source dedup_begin();
+const dedup_entry *dedup_find(uint32_t id);
+void dedup_arm(uint32_t id);
+void dedup_disarm();
+void dedup_start();
+void dedup_finish(int16_t result);
@@ -5,4 +5,158 @@
 #define TX_DEVIATION 5
 #define TX_POWER_DEFAULT 2
 #define RX_BANDWIDTH 10.4
-#define PREAMBLE_LENGTH 0
\ No newline at end of file
+#define PREAMBLE_LENGTH 0
+
+// SX127x wiring on the TTGO LoRa32 v2.1 (VSPI pins, DIO1 drives FIFO refills)
+#define RADIO_PIN_SCK 5
+#define RADIO_PIN_MISO 19
+#define RADIO_PIN_MOSI 27
+#define RADIO_PIN_CS 18
+#define RADIO_PIN_RST 23
+#define RADIO_PIN_DIO0 26
+#define RADIO_PIN_DIO1 33
+
+// SPI clock for radio register traffic; the SX127x tops out at 10 MHz
+#define RADIO_SPI_CLOCK_HZ 8000000
+#define RADIO_SPI_CLOCK_MAX_HZ 10000000
+
+// Transfers up to this many bytes use polling, longer ones are queued as DMA
+// transactions of at most RADIO_SPI_DMA_CHUNK bytes each
+#define RADIO_SPI_POLLING_MAX 4
+#define RADIO_SPI_DMA_CHUNK 64
+#define RADIO_SPI_QUEUE_DEPTH 4
+
+// Listen-before-talk: RSSI above the threshold means the channel is busy.
+// Busy channels are retried after a random backoff whose window doubles on
+// every attempt, up to LBT_MAX_ATTEMPTS samples in total.
+#define LBT_THRESHOLD_DEFAULT -90.0
+#define LBT_SETTLE_US 1500
+#define LBT_SAMPLES 8
+#define LBT_BACKOFF_MIN_MS 10
+#define LBT_BACKOFF_MAX_MS 640
+#define LBT_MAX_ATTEMPTS 8
+
+
+// FLEX timing: 128 frames of 1.875 s make up a 4-minute cycle, aligned to the
+// top of the hour. Pages are queued at least FLEX_LEAD_MS ahead of their frame
+// and the main loop spins for the last FLEX_SPIN_US before a boundary.
+#define FLEX_FRAME_US 1875000LL
+#define FLEX_FRAMES_PER_CYCLE 128
+#define FLEX_LEAD_MS 20
+#define FLEX_SPIN_US 2000
+#define FLEX_LATE_US 5000
+#define FLEX_MAX_PAGES 32
+#define FLEX_POOL_SIZE 2048
+
+
+// RAM payload slots for reusable packet parts, and the most segments one
+// gathered transmission may reference
+#define SLOT_COUNT 16
+#define SLOT_SIZE 512
+#define TX_MAX_SEGMENTS 8
+
+
+// Raw flash partition holding the prebuilt payload library (see partitions.csv)
+#define LIBRARY_PARTITION_LABEL "payloads"
+#define LIBRARY_PARTITION_SUBTYPE 0x40
+
+
+// Payload library provisioning: blocks of PROV_BLOCK_SIZE bytes, each followed
+// by its CRC-32, with up to PROV_WINDOW blocks in flight. Flash is erased in
+// PROV_ERASE_SIZE steps while the sender's window is closed. After an abort,
+// input is discarded until the line has been quiet for PROV_DRAIN_MS.
+#define PROV_BLOCK_SIZE 4096
+#define PROV_WINDOW 2
+#define PROV_ERASE_SIZE 65536
+#define PROV_BAUD_MAX 2000000
+#define PROV_TIMEOUT_MS 2000
+#define PROV_DRAIN_MS 50
+
+// Longest command line kept, including the terminator; the rest of a longer
+// line is dropped
+#define CONSOLE_LINE_MAX 256
+
+// Console receive buffer, sized to hold a full provisioning window
+#define SERIAL_RX_BUFFER_SIZE ((PROV_BLOCK_SIZE + 4) * PROV_WINDOW + 256)
+
+// Console on the ESP-IDF UART driver (CONSOLE_UART_DRIVER builds): receive
+// timeout in symbols before bytes reach the driver, depth of the newline
+// position queue, and how long input without a detected newline waits
+// before it is scanned byte by byte
+#define CONSOLE_UART_RX_TIMEOUT 2
+#define CONSOLE_UART_PATTERN_QUEUE 128
+#define CONSOLE_UART_LINE_FALLBACK_MS 20
+#define CONSOLE_UART_EVENT_QUEUE 32
+#define CONSOLE_UART_TASK_PRIORITY 5
+
+// Tasks of the ESP-IDF build (FIRMWARE_TASKS, ttgo-lora32-v21-idf), both on
+// core 1. The console task also wakes this often without input, for task
+// statistics and idle handling.
+#define TASKS_TX_PRIORITY 6
+#define TASKS_TX_STACK 4096
+#define TASKS_CONSOLE_PRIORITY 2
+#define TASKS_CONSOLE_STACK 8192
+#define TASKS_CONSOLE_POLL_MS 10
+
+// FIFO fill level (of 128 bytes) that hands received bytes to the ring
+// buffer, leaving room for interrupt latency at multi-megabaud rates, and the
+// level at which RTS holds off the sender when flow control is wired
+#define CONSOLE_UART_RX_FULL_THRESHOLD 64
+#define CONSOLE_UART_RTS_THRESHOLD 100
+
+// Data port (CONSOLE_DATA_PORT builds): the console protocol on UART1 at
+// free header pins, alongside the USB console. UART1 can wake the chip from
+// light sleep like UART0. Set DATA_PORT_RTS_PIN to a GPIO to enable RTS.
+#define DATA_PORT_UART 1
+#define DATA_PORT_BAUD 3000000
+#define DATA_PORT_RX_PIN 34
+#define DATA_PORT_TX_PIN 4
+#define DATA_PORT_RTS_PIN -1
+
+// Radio register profiles: slots kept in RAM and NVS, name length, and the
+// number of registers from 0x02 to 0x41 written in one burst
+#define PROFILE_SLOTS 8
+#define PROFILE_NAME_LENGTH 15
+#define PROFILE_BURST_LENGTH 64
+#define PROFILE_NVS_NAMESPACE "profiles"
+
+// Per-transmission history: records kept (32 bytes each) and the most
+// listed by one `o` command
+#define HISTORY_ENTRIES 256
+#define HISTORY_PAGE_MAX 64
+
+// Recently seen transmit message IDs remembered for duplicate suppression
+#define DEDUP_ENTRIES 32
+#define DEDUP_NVS_NAMESPACE "dedup"
+
+
+// Hardware framing needs a fixed packet length, which the SX127x holds in 11 bits
+#define FRAMING_MAX_LENGTH 2047
+
+
+// Idle power policy: 0 keeps full speed, 1 lowers the CPU clock, 2 also enters
+// light sleep with UART wake-up. Applies after IDLE_AFTER_MS without activity.
+#define IDLE_MODE_DEFAULT 0
+#define IDLE_AFTER_MS 500
+#define IDLE_CPU_MHZ_FULL 240
+#define IDLE_CPU_MHZ_LOW 80
+#define IDLE_UART_WAKE_THRESHOLD 3
+#define IDLE_WAKE_MARGIN_US 10000
+
+// Heartbeat line on the console, so the host can tell a wedged device from a
+// long transmission. Off (0) until the host sets an interval with `k`.
+#define HEARTBEAT_INTERVAL_MS 0
+#define HEARTBEAT_MIN_MS 10
+#define HEARTBEAT_MAX_MS 60000
+
+
+// Self-benchmark sizes
+#define BENCH_SPI_BURSTS 64
+#define BENCH_DISPLAY_ROUNDS 5
+#define BENCH_TX_BYTES 512
+#define BENCH_CODEC_BYTES 512
+#define BENCH_CODEC_ROUNDS 8
+
+// Task statistics: snapshot period and the most tasks a snapshot can hold
+#define TASKSTATS_INTERVAL_MS 10000
+#define TASKSTATS_MAX_TASKS 24
@@ -0,0 +1,216 @@
+#include <Arduino.h>
+#include <esp_timer.h>
+#include <string.h>
+
+#include "console_port.h"
+#include "defaults.h"
+#include "display.h"
+#include "flex.h"
+#include "history.h"
+#include "stats.h"
+#include "tx_feed.h"
+#include "wallclock.h"
+
+extern volatile bool console_loop_enable;
+extern volatile bool transmission_start_pending;
+
+extern uint8_t tx_data_buffer[2048];
+extern int current_tx_total_length;
+
+extern void transmission_start();
+
+// A pre-encoded page waiting in the pool for its frame
+struct flex_page
+{
+    int64_t frame;    // Absolute frame index, counted in 1.875 s steps from the Unix epoch
+    uint16_t offset;  // Start of the page in flex_pool
+    uint16_t length;
+};
+
+static uint8_t flex_pool[FLEX_POOL_SIZE];
+static int flex_pool_used = 0;
+
+static flex_page flex_pages[FLEX_MAX_PAGES];
+static int flex_page_count = 0;
+
+// Returns space for a page of the given length at the end of the pool, or
+// nullptr if it does not fit. The page only counts once flex_commit() is called.
+uint8_t *flex_reserve(int length)
+{
+    if (flex_page_count >= FLEX_MAX_PAGES || flex_pool_used + length > FLEX_POOL_SIZE)
+    {
+        return nullptr;
+    }
+
+    return flex_pool + flex_pool_used;
+}
+
+// Next absolute index of the given cycle frame that is still far enough ahead
+static int64_t flex_next_frame(int cycle_frame)
+{
+    int64_t earliest = (wallclock_now_us() + FLEX_LEAD_MS * 1000LL + FLEX_FRAME_US - 1) / FLEX_FRAME_US;
+    int64_t frame = earliest - (earliest % FLEX_FRAMES_PER_CYCLE) + cycle_frame;
+
+    if (frame < earliest)
+    {
+        frame += FLEX_FRAMES_PER_CYCLE;
+    }
+
+    return frame;
+}
+
+// Schedules the page written through flex_reserve() into the frame assigned
+// to the capcode. Returns the frame number within the cycle.
+int flex_commit(uint32_t capcode, int length)
+{
+    int cycle_frame = capcode % FLEX_FRAMES_PER_CYCLE;
+
+    flex_page &page = flex_pages[flex_page_count++];
+    page.frame = flex_next_frame(cycle_frame);
+    page.offset = flex_pool_used;
+    page.length = length;
+
+    flex_pool_used += length;
+
+    return cycle_frame;
+}
+
+int flex_pending()
+{
+    return flex_page_count;
+}
+
+// Drops the page at the given index and closes the gap it leaves in the pool
+static void flex_remove(int index)
+{
+    flex_page removed = flex_pages[index];
+
+    memmove(flex_pool + removed.offset,
+            flex_pool + removed.offset + removed.length,
+            flex_pool_used - removed.offset - removed.length);
+    flex_pool_used -= removed.length;
+
+    for (int i = index; i < flex_page_count - 1; i++)
+    {
+        flex_pages[i] = flex_pages[i + 1];
+    }
+    flex_page_count--;
+
+    for (int i = 0; i < flex_page_count; i++)
+    {
+        if (flex_pages[i].offset > removed.offset)
+        {
+            flex_pages[i].offset -= removed.length;
+        }
+    }
+}
+
+static int64_t flex_due_frame()
+{
+    int64_t due = flex_pages[0].frame;
+    for (int i = 1; i < flex_page_count; i++)
+    {
+        if (flex_pages[i].frame < due)
+        {
+            due = flex_pages[i].frame;
+        }
+    }
+
+    return due;
+}
+
+// esp_timer time by which the main loop must be running again to catch the
+// next frame, `margin_us` ahead of the spin window; -1 if nothing is queued.
+int64_t flex_next_deadline_us(int64_t margin_us)
+{
+    if (flex_page_count == 0 || !wallclock_synced())
+    {
+        return -1;
+    }
+
+    int64_t until_boundary_us = flex_due_frame() * FLEX_FRAME_US - wallclock_now_us();
+    return esp_timer_get_time() + until_boundary_us - FLEX_SPIN_US - margin_us;
+}
+
+// Emits the earliest due frame as a single transmission holding every page
+// queued for it, started as close to the frame boundary as the loop allows.
+void flex_loop()
+{
+    if (flex_page_count == 0 || !wallclock_synced())
+    {
+        return;
+    }
+
+    int64_t due = flex_due_frame();
+    int64_t boundary_us = due * FLEX_FRAME_US;
+    int64_t now_us = wallclock_now_us();
+
+    if (boundary_us - now_us > FLEX_SPIN_US)
+    {
+        return;
+    }
+
+    // Radio still busy, or the boundary has passed: hold the pages for the same
+    // frame in the next cycle rather than sending them late.
+    if (now_us - boundary_us > FLEX_LATE_US)
+    {
+        for (int i = 0; i < flex_page_count; i++)
+        {
+            if (flex_pages[i].frame == due)
+            {
+                flex_pages[i].frame += FLEX_FRAMES_PER_CYCLE;
+            }
+        }
+
+        stats_flex_missed++;
+        return;
+    }
+
+    if (!console_loop_enable || transmission_start_pending)
+    {
+        return;
+    }
+
+    int pages = 0;
+    current_tx_total_length = 0;
+
+    for (int i = 0; i < flex_page_count;)
+    {
+        if (flex_pages[i].frame != due)
+        {
+            i++;
+            continue;
+        }
+
+        memcpy(tx_data_buffer + current_tx_total_length, flex_pool + flex_pages[i].offset, flex_pages[i].length);
+        current_tx_total_length += flex_pages[i].length;
+        pages++;
+
+        flex_remove(i);
+    }
+
+    // A frame has no upload, and its queue time is the wait for the boundary
+    history_command();
+    history_arm(0);
+
+    while (wallclock_now_us() < boundary_us)
+    {
+    }
+
+    // Started directly, bypassing listen-before-talk: a frame must go out on
+    // its boundary, and a backoff would push it past FLEX_LATE_US
+    console_loop_enable = false;
+    tx_feed_single(tx_data_buffer, current_tx_total_length);
+    transmission_start();
+
+    stats_flex_frames++;
+    stats_flex_pages += pages;
+
+    Console.print("FLEX:0:Frame ");
+    Console.print((int)(due % FLEX_FRAMES_PER_CYCLE));
+    Console.print(" started with ");
+    Console.print(pages);
+    Console.println(" pages");
+
+    display_status();
+}
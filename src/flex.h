@@ -0,0 +1,9 @@
+#pragma once
+
+#include <stdint.h>
+
+uint8_t *flex_reserve(int length);
+int flex_commit(uint32_t capcode, int length);
+int flex_pending();
+int64_t flex_next_deadline_us(int64_t margin_us);
+void flex_loop();
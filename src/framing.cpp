@@ -0,0 +1,149 @@
+#define RADIO_BOARD_AUTO
+
+#include <RadioLib.h>
+#include <RadioBoards.h>
+
+#include "defaults.h"
+#include "framing.h"
+#include "tx_feed.h"
+
+extern Radio radio;
+
+static framing_crc_mode framing_crc = FRAMING_CRC_OFF;
+static bool framing_whitening = false;
+static bool framing_software = false;  // the current packet is framed by tx_feed, not the packet engine
+static uint8_t framing_crc_bytes[2];   // software CRC, appended as the last tx_feed segment
+
+// Switches the packet engine's CRC and whitening on or off for the following
+// transmissions, so the host no longer has to compute and upload them.
+int16_t framing_configure(framing_crc_mode crc, bool whitening)
+{
+    int16_t state = radio.setCRC(crc != FRAMING_CRC_OFF, crc == FRAMING_CRC_IBM);
+    if (state != RADIOLIB_ERR_NONE)
+    {
+        return state;
+    }
+
+    state = radio.setEncoding(whitening ? RADIOLIB_ENCODING_WHITENING : RADIOLIB_ENCODING_NRZ);
+    if (state != RADIOLIB_ERR_NONE)
+    {
+        return state;
+    }
+
+    framing_crc = crc;
+    framing_whitening = whitening;
+
+    return framing_prepare(0);
+}
+
+bool framing_enabled()
+{
+    return framing_crc != FRAMING_CRC_OFF || framing_whitening;
+}
+
+bool framing_in_software()
+{
+    return framing_software;
+}
+
+// Builds the same on-air bytes as the packet engine for a packet it cannot
+// take: the CRC goes on the end of the tx_feed segment list and tx_feed
+// whitens while filling the FIFO. The packet is then streamed unframed.
+static int16_t framing_prepare_software()
+{
+    if (framing_crc != FRAMING_CRC_OFF)
+    {
+        uint16_t crc = tx_feed_crc16(framing_crc == FRAMING_CRC_IBM);
+        framing_crc_bytes[0] = crc >> 8;
+        framing_crc_bytes[1] = crc & 0xFF;
+
+        if (!tx_feed_append(framing_crc_bytes, sizeof(framing_crc_bytes)))
+        {
+            return RADIOLIB_ERR_PACKET_TOO_LONG;
+        }
+    }
+
+    tx_feed_whiten(framing_whitening);
+    framing_software = true;
+
+    return RADIOLIB_ERR_NONE;
+}
+
+// The packet engine only appends the CRC when it knows where the packet ends,
+// so framed transmissions use fixed length mode with the exact payload length.
+// Length 0 selects unlimited length mode for unframed streaming. Packets over
+// the 11-bit length limit are framed in software instead, which may add CRC
+// bytes to the tx_feed segment list.
+int16_t framing_prepare(int length)
+{
+    Module *mod = radio.getMod();
+    framing_software = false;
+
+    if (!framing_enabled())
+    {
+        length = 0;
+    }
+    else
+    {
+        if (length > FRAMING_MAX_LENGTH)
+        {
+            int16_t state = framing_prepare_software();
+            if (state != RADIOLIB_ERR_NONE)
+            {
+                return state;
+            }
+            length = 0;
+        }
+
+        // CrcOn and DcFree follow the mode; the packet engine stays out of software framed packets
+        uint8_t engine = 0;
+        if (!framing_software)
+        {
+            engine = (framing_crc != FRAMING_CRC_OFF ? RADIOLIB_SX127X_CRC_ON : 0) |
+                     (framing_whitening ? RADIOLIB_SX127X_DC_FREE_WHITENING : 0);
+        }
+
+        int16_t state = mod->SPIsetRegValue(RADIOLIB_SX127X_REG_PACKET_CONFIG_1, engine, 6, 4);
+        if (state != RADIOLIB_ERR_NONE)
+        {
+            return state;
+        }
+    }
+
+    int16_t state = mod->SPIsetRegValue(RADIOLIB_SX127X_REG_PACKET_CONFIG_2, length >> 8, 2, 0);
+    if (state != RADIOLIB_ERR_NONE)
+    {
+        return state;
+    }
+
+    return mod->SPIsetRegValue(RADIOLIB_SX127X_REG_PAYLOAD_LENGTH_FSK, length & 0xFF);
+}
+
+// PacketConfig1 with the CRC and whitening bits framing_configure() set, for
+// register images written to the radio directly (see profile.cpp)
+uint8_t framing_packet_config(uint8_t value)
+{
+    value &= ~(RADIOLIB_SX127X_DC_FREE_WHITENING | RADIOLIB_SX127X_CRC_ON | RADIOLIB_SX127X_CRC_WHITENING_TYPE_IBM);
+
+    if (framing_crc != FRAMING_CRC_OFF)
+    {
+        value |= RADIOLIB_SX127X_CRC_ON;
+    }
+    if (framing_crc == FRAMING_CRC_IBM)
+    {
+        value |= RADIOLIB_SX127X_CRC_WHITENING_TYPE_IBM;
+    }
+    if (framing_whitening)
+    {
+        value |= RADIOLIB_SX127X_DC_FREE_WHITENING;
+    }
+
+    return value;
+}
+
+// With framing on, the radio keeps sending the FIFO tail and CRC after the last
+// byte is queued; PacketSent marks the real end of the packet.
+bool framing_packet_sent()
+{
+    return radio.getMod()->SPIgetRegValue(RADIOLIB_SX127X_REG_IRQ_FLAGS_2, 3, 3) != 0;
+}
@@ -0,0 +1,17 @@
+#pragma once
+
+#include <stdint.h>
+
+enum framing_crc_mode
+{
+    FRAMING_CRC_OFF = 0,
+    FRAMING_CRC_CCITT,
+    FRAMING_CRC_IBM
+};
+
+int16_t framing_configure(framing_crc_mode crc, bool whitening);
+bool framing_enabled();
+bool framing_in_software();
+int16_t framing_prepare(int length);
+uint8_t framing_packet_config(uint8_t value);
+bool framing_packet_sent();
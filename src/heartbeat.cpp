@@ -0,0 +1,101 @@
+#include <Arduino.h>
+#include <esp_timer.h>
+
+#include "console_port.h"
+#include "defaults.h"
+#include "heartbeat.h"
+
+extern volatile bool console_loop_enable;
+extern volatile bool transmission_start_pending;
+extern int current_tx_remaining_length;
+
+static uint32_t heartbeat_interval_ms = HEARTBEAT_INTERVAL_MS;
+static uint32_t heartbeat_count = 0;
+static int64_t heartbeat_due_us = 0;  // esp_timer time of the next beat
+
+#ifdef CONSOLE_DATA_PORT
+// The port that sent `k`. Console follows the last command, so beats sent
+// there would move to the other port as soon as it issued a command.
+static Stream *heartbeat_port = &ConsoleUsb;
+#define HeartbeatPort (*heartbeat_port)
+#else
+#define HeartbeatPort Console
+#endif
+
+// Beats start one interval after the change
+void heartbeat_set(uint32_t interval_ms)
+{
+    heartbeat_interval_ms = interval_ms;
+#ifdef CONSOLE_DATA_PORT
+    heartbeat_port = console_active;
+#endif
+    heartbeat_due_us = esp_timer_get_time() + (int64_t)interval_ms * 1000;
+}
+
+// Prints HB:0:<count>,<state>,<bytes> once the interval has passed. The
+// state is I (idle), L (waiting for a clear channel), T (transmitting, with
+// the bytes still to be loaded into the FIFO) or U (receiving a payload,
+// with the bytes still to come).
+static void heartbeat_beat(char state, int remaining)
+{
+    if (heartbeat_interval_ms == 0)
+    {
+        return;
+    }
+
+    int64_t now = esp_timer_get_time();
+    if (now < heartbeat_due_us)
+    {
+        return;
+    }
+
+    // After a stall, beat once and resume the period rather than catch up
+    heartbeat_due_us += (int64_t)heartbeat_interval_ms * 1000;
+    if (heartbeat_due_us <= now)
+    {
+        heartbeat_due_us = now + (int64_t)heartbeat_interval_ms * 1000;
+    }
+
+    HeartbeatPort.print("HB:0:");
+    HeartbeatPort.print(heartbeat_count++);
+    HeartbeatPort.print(',');
+    HeartbeatPort.print(state);
+    HeartbeatPort.print(',');
+    HeartbeatPort.println(remaining);
+}
+
+// Called from the main loop, which keeps running while a packet is on air
+void heartbeat_loop()
+{
+    if (transmission_start_pending)
+    {
+        heartbeat_beat('L', 0);
+    }
+    else if (!console_loop_enable)
+    {
+        heartbeat_beat('T', current_tx_remaining_length);
+    }
+    else
+    {
+        heartbeat_beat('I', 0);
+    }
+}
+
+// Called while the console blocks for payload bytes
+void heartbeat_receiving(int remaining)
+{
+    heartbeat_beat('U', remaining);
+}
+
+// Longest a blocking read may wait, at most `limit_ms`, so that a beat is
+// never held back by more than one interval
+uint32_t heartbeat_read_timeout_ms(uint32_t limit_ms)
+{
+    return heartbeat_interval_ms ? min(heartbeat_interval_ms, limit_ms) : limit_ms;
+}
+
+// esp_timer time of the next beat, or -1 if the heartbeat is off
+int64_t heartbeat_next_deadline_us()
+{
+    return heartbeat_interval_ms ? heartbeat_due_us : -1;
+}
@@ -0,0 +1,9 @@
+#pragma once
+
+#include <stdint.h>
+
+void heartbeat_set(uint32_t interval_ms);
+void heartbeat_loop();
+void heartbeat_receiving(int remaining);
+int64_t heartbeat_next_deadline_us();
+uint32_t heartbeat_read_timeout_ms(uint32_t limit_ms);
@@ -0,0 +1,113 @@
+#include <Arduino.h>
+#include <math.h>
+#include <string.h>
+
+#include "history.h"
+#include "stats.h"
+
+extern float current_tx_frequency;
+extern float current_tx_power;
+
+static history_record history[HISTORY_ENTRIES];
+static uint32_t history_count = 0;  // records written since boot, and the sequence number of the next
+
+static history_record history_current;   // the transmission being prepared or on air
+static uint32_t history_command_us = 0;  // micros() when the current command line arrived
+static uint32_t history_queued_us = 0;   // micros() when its payload was accepted
+static uint32_t history_start_ms = 0;
+static uint32_t history_underruns = 0;   // stats_tx_underruns at the start
+static bool history_armed = false;
+static bool history_started = false;
+
+static void history_radio()
+{
+    history_current.time_ms = millis();
+    history_current.frequency_khz = lroundf(current_tx_frequency * 1000);
+    history_current.power = (int)current_tx_power;
+}
+
+// Upload time is measured from the arrival of the command line
+void history_command()
+{
+    history_command_us = micros();
+}
+
+// The console accepted a payload for transmission
+void history_arm(uint32_t id)
+{
+    uint32_t now = micros();
+
+    memset(&history_current, 0, sizeof(history_current));
+    history_current.id = id;
+    history_current.upload_us = now - history_command_us;
+    history_queued_us = now;
+    history_armed = true;
+}
+
+// Called once the radio has been told to transmit; `start_us` is when the
+// transmission was started
+void history_start(uint32_t start_us, uint32_t length)
+{
+    if (history_armed)
+    {
+        history_current.queue_us = start_us - history_queued_us;
+    }
+    else
+    {
+        memset(&history_current, 0, sizeof(history_current));
+    }
+
+    history_radio();
+    history_current.length = length;
+    history_current.first_bit_us = min(micros() - start_us, (uint32_t)UINT16_MAX);
+
+    history_start_ms = millis();
+    history_underruns = stats_tx_underruns;
+    history_armed = false;
+    history_started = true;
+}
+
+// Completes the record with the TX result and adds it to the ring. A
+// transmission abandoned by listen-before-talk never started, and spent
+// all its time queued.
+void history_finish(int16_t result)
+{
+    if (history_started)
+    {
+        history_current.airtime_ms = millis() - history_start_ms;
+        history_current.underruns = min(stats_tx_underruns - history_underruns, (uint32_t)UINT16_MAX);
+    }
+    else if (history_armed)
+    {
+        history_current.queue_us = micros() - history_queued_us;
+        history_radio();
+    }
+    else
+    {
+        return;
+    }
+
+    history_current.result = result;
+    history[history_count % HISTORY_ENTRIES] = history_current;
+    history_count++;
+
+    history_armed = false;
+    history_started = false;
+}
+
+uint32_t history_next()
+{
+    return history_count;
+}
+
+// The record with that sequence number, or nullptr if it has not been
+// written or was overwritten
+const history_record *history_get(uint32_t seq)
+{
+    if (seq >= history_count || history_count - seq > HISTORY_ENTRIES)
+    {
+        return nullptr;
+    }
+
+    return &history[seq % HISTORY_ENTRIES];
+}
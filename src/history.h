@@ -0,0 +1,35 @@
+#pragma once
+
+#include <stdint.h>
+
+#include "defaults.h"
+
+// One transmission, packed into 32 bytes. Times are measured from:
+//   upload     command line received to payload accepted
+//   queue      payload accepted to transmission start (listen-before-talk)
+//   first_bit  transmission start to the radio entering TX
+//   airtime    transmission start to the TX result
+// FLEX frames and the benchmark packet have no command, so upload and queue are 0.
+struct __attribute__((packed)) history_record
+{
+    uint32_t time_ms;             // millis() at the start, or when LBT gave up
+    uint32_t id;                  // message ID, 0 for none
+    uint32_t length;              // bytes sent, including a software CRC
+    uint32_t upload_us;
+    uint32_t queue_us;
+    uint32_t airtime_ms;
+    uint16_t first_bit_us;
+    uint16_t underruns;           // saturates at 65535
+    uint32_t frequency_khz : 20;
+    int32_t power : 7;            // dBm
+    uint32_t result : 5;          // TX result code
+};
+
+static_assert(sizeof(history_record) == 32, "history records are 32 bytes");
+
+void history_command();
+void history_arm(uint32_t id);
+void history_start(uint32_t start_us, uint32_t length);
+void history_finish(int16_t result);
+uint32_t history_next();
+const history_record *history_get(uint32_t seq);
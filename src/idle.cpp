@@ -0,0 +1,125 @@
+#include <Arduino.h>
+#include <driver/uart.h>
+#include <esp_sleep.h>
+#include <esp_timer.h>
+
+#include "console_port.h"
+#include "defaults.h"
+#include "idle.h"
+#include "stats.h"
+
+idle_mode idle_policy = (idle_mode)IDLE_MODE_DEFAULT;
+
+static uint32_t idle_last_activity_ms = 0;
+static uint32_t idle_entered_ms = 0;
+static bool idle_low = false;  // CPU clock currently reduced
+static bool idle_uart_woken = false;  // woken from light sleep by the UART, no command handled yet
+static uint32_t idle_uart_wake_us = 0; // micros() when light sleep returned after that wake-up
+
+// Restores full speed as soon as there is work: console input, a queued
+// transmission or a due FLEX frame. The time taken counts as wake latency.
+void idle_activity()
+{
+    idle_last_activity_ms = millis();
+
+    if (!idle_low)
+    {
+        return;
+    }
+
+    uint32_t start = micros();
+    setCpuFrequencyMhz(IDLE_CPU_MHZ_FULL);
+    stats_record(stats_idle_wake, micros() - start);
+
+    stats_idle_ms += millis() - idle_entered_ms;
+    idle_low = false;
+}
+
+// Light sleep until UART activity or the next deadline. The characters that
+// trigger the UART wake-up are lost, so hosts send a newline first.
+static void idle_sleep(int64_t next_deadline_us)
+{
+    // A wake-up that brought no command is not counted
+    idle_uart_woken = false;
+
+    ConsoleUsb.flush();
+
+    esp_sleep_disable_wakeup_source(ESP_SLEEP_WAKEUP_ALL);
+    uart_set_wakeup_threshold(UART_NUM_0, IDLE_UART_WAKE_THRESHOLD);
+    esp_sleep_enable_uart_wakeup(UART_NUM_0);
+
+#ifdef CONSOLE_DATA_PORT
+    console_data.flush();
+    uart_set_wakeup_threshold(DATA_PORT_UART, IDLE_UART_WAKE_THRESHOLD);
+    esp_sleep_enable_uart_wakeup(DATA_PORT_UART);
+#endif
+
+    if (next_deadline_us >= 0)
+    {
+        int64_t sleep_us = next_deadline_us - esp_timer_get_time();
+        if (sleep_us <= 0)
+        {
+            return;
+        }
+        esp_sleep_enable_timer_wakeup(sleep_us);
+    }
+
+    esp_light_sleep_start();
+
+    if (esp_sleep_get_wakeup_cause() == ESP_SLEEP_WAKEUP_UART)
+    {
+        idle_uart_wake_us = micros();
+        idle_uart_woken = true;
+    }
+
+    uint32_t start = micros();
+    setCpuFrequencyMhz(IDLE_CPU_MHZ_FULL);
+    stats_record(stats_idle_wake, micros() - start);
+
+    stats_idle_ms += millis() - idle_entered_ms;
+    idle_low = false;
+    idle_last_activity_ms = millis();
+}
+
+// Called for each command the console handles. The first one after a UART
+// wake-up completes the wake-to-command time: the clock switch, the host's
+// pause after its wake newline, the command line itself and the main loop
+// passes until it is read. The light sleep exit before micros() resumes is
+// not included.
+void idle_command()
+{
+    if (idle_uart_woken)
+    {
+        stats_record(stats_idle_command, micros() - idle_uart_wake_us);
+        idle_uart_woken = false;
+    }
+}
+
+// Applies the idle policy once the console has been quiet for IDLE_AFTER_MS
+// and nothing is being transmitted. next_deadline_us is the esp_timer time of
+// the next scheduled job, or -1 if none.
+void idle_loop(bool busy, int64_t next_deadline_us)
+{
+    if (busy)
+    {
+        idle_activity();
+        return;
+    }
+
+    if (idle_policy == IDLE_FULL_SPEED || millis() - idle_last_activity_ms < IDLE_AFTER_MS)
+    {
+        return;
+    }
+
+    if (!idle_low)
+    {
+        setCpuFrequencyMhz(IDLE_CPU_MHZ_LOW);
+        idle_entered_ms = millis();
+        idle_low = true;
+    }
+
+    if (idle_policy == IDLE_LIGHT_SLEEP)
+    {
+        idle_sleep(next_deadline_us);
+    }
+}
@@ -0,0 +1,16 @@
+#pragma once
+
+#include <stdint.h>
+
+enum idle_mode
+{
+    IDLE_FULL_SPEED = 0,
+    IDLE_LOW_CLOCK,
+    IDLE_LIGHT_SLEEP
+};
+
+extern idle_mode idle_policy;
+
+void idle_activity();
+void idle_command();
+void idle_loop(bool busy, int64_t next_deadline_us);
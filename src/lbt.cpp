@@ -0,0 +1,97 @@
+#define RADIO_BOARD_AUTO
+
+#include <Arduino.h>
+#include <RadioLib.h>
+#include <RadioBoards.h>
+
+#include "defaults.h"
+#include "lbt.h"
+#include "stats.h"
+
+extern Radio radio;
+
+bool lbt_enabled = false;
+float lbt_threshold = LBT_THRESHOLD_DEFAULT;
+
+static uint32_t lbt_next_sample_us = 0;  // Earliest time the next RSSI sample may be taken
+static uint32_t lbt_busy_since_ms = 0;   // When the channel was first found busy, 0 if not yet
+static int lbt_attempts = 0;
+
+// Puts the radio in receive mode on the current frequency so RSSI has settled
+// by the time the payload upload finishes.
+void lbt_begin()
+{
+    lbt_attempts = 0;
+    lbt_busy_since_ms = 0;
+    lbt_next_sample_us = micros() + LBT_SETTLE_US;
+
+    radio.startReceive();
+}
+
+// Reads the RSSI of the receiver started by lbt_begin. With the default
+// arguments RadioLib would restart the receiver for each reading and put the
+// radio in standby afterwards, so every value would be unsettled.
+static float lbt_sample()
+{
+    float peak = -200.0;
+
+    for (int i = 0; i < LBT_SAMPLES; i++)
+    {
+        float rssi = radio.getRSSI(false, true);
+        if (rssi > peak)
+        {
+            peak = rssi;
+        }
+    }
+
+    return peak;
+}
+
+static void lbt_account_busy_time()
+{
+    if (lbt_busy_since_ms != 0)
+    {
+        stats_lbt_busy_ms += millis() - lbt_busy_since_ms;
+        lbt_busy_since_ms = 0;
+    }
+}
+
+lbt_result lbt_poll()
+{
+    if ((int32_t)(micros() - lbt_next_sample_us) < 0)
+    {
+        return LBT_WAIT;
+    }
+
+    if (lbt_sample() < lbt_threshold)
+    {
+        lbt_account_busy_time();
+        radio.standby();
+        return LBT_CLEAR;
+    }
+
+    if (lbt_busy_since_ms == 0)
+    {
+        lbt_busy_since_ms = millis();
+    }
+
+    if (++lbt_attempts >= LBT_MAX_ATTEMPTS)
+    {
+        lbt_account_busy_time();
+        stats_lbt_failures++;
+        radio.standby();
+        return LBT_BUSY;
+    }
+
+    // The receiver keeps running through the backoff, so the next sample is settled too
+    uint32_t window = LBT_BACKOFF_MIN_MS << (lbt_attempts - 1);
+    if (window > LBT_BACKOFF_MAX_MS)
+    {
+        window = LBT_BACKOFF_MAX_MS;
+    }
+
+    stats_lbt_deferrals++;
+    lbt_next_sample_us = micros() + random(LBT_BACKOFF_MIN_MS, window + 1) * 1000;
+
+    return LBT_WAIT;
+}
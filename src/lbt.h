@@ -0,0 +1,14 @@
+#pragma once
+
+enum lbt_result
+{
+    LBT_WAIT,   // Still settling or backing off, poll again
+    LBT_CLEAR,  // Channel is free, transmit now
+    LBT_BUSY    // Channel stayed busy for every attempt, give up
+};
+
+extern bool lbt_enabled;
+extern float lbt_threshold;
+
+void lbt_begin();
+lbt_result lbt_poll();
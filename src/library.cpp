@@ -0,0 +1,88 @@
+#include <esp_idf_version.h>
+#include <esp_partition.h>
+
+#include "defaults.h"
+#include "library.h"
+
+static const uint8_t *library_base = nullptr;  // Partition contents through the flash cache
+static uint32_t library_size = 0;
+static spi_flash_mmap_handle_t library_handle;
+
+// Maps the payload partition into the data address space and checks the
+// header. Payloads are then read straight from flash, with no copy in RAM.
+bool library_begin()
+{
+    const esp_partition_t *partition = esp_partition_find_first(ESP_PARTITION_TYPE_DATA,
+                                                                (esp_partition_subtype_t)LIBRARY_PARTITION_SUBTYPE,
+                                                                LIBRARY_PARTITION_LABEL);
+    if (partition == nullptr)
+    {
+        return false;
+    }
+
+    const void *mapped = nullptr;
+#if ESP_IDF_VERSION_MAJOR >= 5
+    esp_err_t err = esp_partition_mmap(partition, 0, partition->size, ESP_PARTITION_MMAP_DATA, &mapped, &library_handle);
+#else
+    esp_err_t err = esp_partition_mmap(partition, 0, partition->size, SPI_FLASH_MMAP_DATA, &mapped, &library_handle);
+#endif
+    if (err != ESP_OK)
+    {
+        return false;
+    }
+
+    library_base = (const uint8_t *)mapped;
+    library_size = partition->size;
+
+    const library_header *header = (const library_header *)library_base;
+    if (header->magic != LIBRARY_MAGIC || header->version != LIBRARY_VERSION ||
+        sizeof(library_header) + header->count * sizeof(library_entry) > library_size)
+    {
+        spi_flash_munmap(library_handle);
+        library_base = nullptr;
+        return false;
+    }
+
+    return true;
+}
+
+// Releases the mapping, e.g. before the partition is rewritten
+void library_end()
+{
+    if (library_base != nullptr)
+    {
+        spi_flash_munmap(library_handle);
+        library_base = nullptr;
+    }
+}
+
+int library_count()
+{
+    if (library_base == nullptr)
+    {
+        return 0;
+    }
+
+    return ((const library_header *)library_base)->count;
+}
+
+// Points `data` at the payload of the given entry inside the mapped partition
+bool library_get(int index, const uint8_t **data, int *length)
+{
+    if (index < 0 || index >= library_count())
+    {
+        return false;
+    }
+
+    const library_entry *entries = (const library_entry *)(library_base + sizeof(library_header));
+    const library_entry &entry = entries[index];
+
+    if (entry.length == 0 || entry.offset > library_size || entry.length > library_size - entry.offset)
+    {
+        return false;
+    }
+
+    *data = library_base + entry.offset;
+    *length = entry.length;
+    return true;
+}
@@ -0,0 +1,27 @@
+#pragma once
+
+#include <stdint.h>
+
+// Payload library image layout, little-endian, at the start of the partition:
+//   library_header, then `count` library_entry records, then payload data.
+// Entry offsets are relative to the start of the partition.
+#define LIBRARY_MAGIC 0x4C4B5346 // "FSKL"
+#define LIBRARY_VERSION 1
+
+struct library_header
+{
+    uint32_t magic;
+    uint16_t version;
+    uint16_t count;
+};
+
+struct library_entry
+{
+    uint32_t offset;
+    uint32_t length;
+};
+
+bool library_begin();
+void library_end();
+int library_count();
+bool library_get(int index, const uint8_t **data, int *length);
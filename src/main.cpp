@@ -2,17 +2,39 @@
 
 #include <RadioLib.h>
 #include <RadioBoards.h>
+#include <esp_system.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/semphr.h>
+#include <freertos/task.h>
 
 #include "console.h"
+#include "console_port.h"
+#include "dedup.h"
 #include "defaults.h"
 #include "display.h"
+#include "flex.h"
+#include "framing.h"
+#include "heartbeat.h"
+#include "history.h"
+#include "idle.h"
+#include "lbt.h"
+#include "library.h"
+#include "profile.h"
+#include "radio_hal.h"
+#include "stats.h"
+#include "taskstats.h"
+#include "tx_feed.h"
 
-Radio radio = new RadioModule();
+// Radio SPI goes through the ESP-IDF master driver rather than Arduino SPI
+EspSpiHal radio_hal(RADIO_PIN_SCK, RADIO_PIN_MISO, RADIO_PIN_MOSI, RADIO_SPI_CLOCK_HZ);
+Radio radio = new Module(&radio_hal, RADIO_PIN_CS, RADIO_PIN_DIO0, RADIO_PIN_RST, RADIO_PIN_DIO1);
 
 // Global variables for transmission state
 volatile bool console_loop_enable = true;                // Flag to enable/disable console input loop
 volatile bool fifo_empty = false;                        // Flag set by ISR when FIFO has space for more data
 volatile bool transmission_processing_complete = false;  // Flag set by fifoAdd when all data of the current transmission is sent
+volatile bool transmission_start_pending = false;        // Flag set while listen-before-talk holds back a queued transmission
+volatile uint32_t fifo_interrupt_us = 0;                 // micros() at the last FIFO interrupt, for refill latency
 
 // Transmission data buffer and state variables
 uint8_t tx_data_buffer[2048] = {0};                      // Buffer to hold the entire message data
@@ -24,17 +46,141 @@ int16_t radio_start_transmit_status = RADIOLIB_ERR_NONE; // Stores the result of
 float current_tx_frequency = TX_FREQ_DEFAULT;            // Current transmission frequency
 float current_tx_power = TX_POWER_DEFAULT;               // Current transmission power
 
+#ifdef FIRMWARE_TASKS
+static SemaphoreHandle_t firmware_lock = nullptr;  // Held by the tx and console tasks for each pass
+static TaskHandle_t tx_task_handle = nullptr;      // Woken by the FIFO interrupt and by transmission_start()
+#endif
+
 // Panic function: halts system and displays error
 void panic()
 {
   display_panic();
-  Serial.println("INIT:1:System halted");
+  Console.println("INIT:1:System halted");
   while (true)
   {
     delay(100000);
   }
 }
 
+// Starts transmitting the packet described by the tx_feed segment list
+void transmission_start()
+{
+  uint32_t start_us = micros();
+
+  fifo_interrupt_us = micros();
+  fifo_empty = true;
+#ifdef FIRMWARE_TASKS
+  xTaskNotifyGive(tx_task_handle);
+#endif
+
+  // Software framing may append CRC bytes, so the length is taken afterwards
+  radio_start_transmit_status = framing_prepare(tx_feed_total());
+  current_tx_total_length = tx_feed_total();
+  current_tx_remaining_length = current_tx_total_length;
+
+  if (radio_start_transmit_status == RADIOLIB_ERR_NONE)
+  {
+    tx_feed_read_bitrate();
+    radio_start_transmit_status = radio.startTransmit(tx_feed_head(current_tx_total_length), current_tx_total_length);
+  }
+
+  // Only a message that went on air is remembered; after a failed start a retry may transmit it
+  if (radio_start_transmit_status == RADIOLIB_ERR_NONE)
+  {
+    dedup_start();
+  }
+  else
+  {
+    dedup_disarm();
+  }
+
+  history_start(start_us, current_tx_total_length);
+}
+
+// True once the radio has nothing left to send for the current transmission
+bool transmission_drained()
+{
+  if (!framing_enabled() || framing_in_software() || radio_start_transmit_status != RADIOLIB_ERR_NONE)
+  {
+    return true;
+  }
+
+  return framing_packet_sent();
+}
+
+// Starts the buffered message now, or hands it to listen-before-talk when enabled
+void transmission_queue()
+{
+  console_loop_enable = false;
+
+  if (lbt_enabled)
+  {
+    transmission_start_pending = true;
+  }
+  else
+  {
+    transmission_start();
+  }
+}
+
+// Ends a transmission with the given TX result code: idles the radio and gives control back to the console
+void transmission_finish(int16_t result)
+{
+  dedup_finish(result);
+  history_finish(result);
+
+  // Put the radio in standby mode to stop transmitting/idling.
+  // Important for FSK mode on SX127x as it might not turn off the transmitter automatically.
+  radio.standby();
+  Console.println("INIT:0:Radio set to standby mode.");
+
+  // Re-enable console for the next command and update the display.
+  console_loop_enable = true;
+  display_status(); // Update display (e.g., to show idle state, last status).
+}
+
+// Keeps the radio FIFO topped up and reports the transmission once it has been sent
+void transmission_service()
+{
+  // Check if ISR indicated FIFO has space AND there's data remaining for the current transmission
+  if (fifo_empty && current_tx_remaining_length > 0)
+  {
+    fifo_empty = false; // Reset ISR flag
+
+    // tx_feed_refill works like radio.fifoAdd, but reads from the segment list:
+    // 1. current_tx_total_length: The total original length of the packet.
+    // 2. &current_tx_remaining_length: Pointer to the variable holding the remaining length.
+    //    The next chunk is taken from the segments at the offset given by total and remaining length,
+    //    and current_tx_remaining_length is updated with the new remaining length.
+    // Returns true if the entire packet (all current_tx_total_length bytes) has been successfully loaded into the FIFO.
+    uint32_t refill_start = micros();
+    uint32_t latency_us = refill_start - fifo_interrupt_us;
+    stats_record_isr_refill(latency_us);
+    transmission_processing_complete = tx_feed_refill(current_tx_total_length, &current_tx_remaining_length, latency_us);
+    stats_record(stats_fifo_refill, micros() - refill_start);
+  }
+
+  // With hardware framing, wait for the packet engine to send the FIFO tail and CRC
+  if (transmission_processing_complete && transmission_drained())
+  {
+    transmission_processing_complete = false; // Reset flag for the next transmission cycle
+
+    // radio_start_transmit_status holds the result from the initial radio.startTransmit() call.
+    if (radio_start_transmit_status == RADIOLIB_ERR_NONE)
+    {
+      Console.println("TX:0:Transmission finished successfully!");
+      transmission_finish(0);
+    }
+    else
+    {
+      // This means radio.startTransmit() itself failed.
+      Console.print("TX:1:Transmission failed to start, error code: ");
+      Console.println(radio_start_transmit_status);
+      transmission_finish(1);
+    }
+  }
+}
+
 // Interrupt Service Routine (ISR) called when radio's transmit FIFO has space.
 // This function MUST be of 'void' type and MUST NOT take any arguments.
 #if defined(ESP8266) || defined(ESP32)
@@ -42,18 +188,51 @@ void panic()
 #endif
 void on_interrupt_fifo_has_space()
 {
+  fifo_interrupt_us = micros();
   fifo_empty = true;
+  stats_fifo_isr++;
+
+#ifdef FIRMWARE_TASKS
+  BaseType_t woken = pdFALSE;
+  vTaskNotifyGiveFromISR(tx_task_handle, &woken);
+  if (woken)
+  {
+    portYIELD_FROM_ISR();
+  }
+#endif
 }
 
 // System setup function, runs once on boot
 void setup()
 {
-  Serial.begin(TTGO_SERIAL_BAUD);
+  ConsoleUsb.setRxBufferSize(SERIAL_RX_BUFFER_SIZE); // Must precede begin(); sized for a provisioning window
+  ConsoleUsb.begin(TTGO_SERIAL_BAUD);
+#ifndef CONSOLE_UART_DRIVER
+  ConsoleUsb.onReceiveError(console_count_error); // Overruns reported by provisioning
+#endif
+
+#ifdef CONSOLE_DATA_PORT
+  // Second console for a data feeder; USB stays available for monitoring
+  console_data.setRxBufferSize(SERIAL_RX_BUFFER_SIZE);
+  console_data.begin(DATA_PORT_BAUD, DATA_PORT_RX_PIN, DATA_PORT_TX_PIN, DATA_PORT_RTS_PIN);
+#endif
+
+  // Keep message IDs recorded before a host-triggered reset. Whether RTC
+  // memory survived, and the reset reason, are reported so this can be
+  // checked on a board.
+  dedup_source dedup_from = dedup_begin();
+  Console.print(dedup_from == DEDUP_FROM_RTC ? "INIT:0:Message IDs kept in RTC memory" :
+                dedup_from == DEDUP_FROM_NVS ? "INIT:0:Message IDs restored from NVS" :
+                                               "INIT:0:Message IDs cleared");
+  Console.print(", reset reason ");
+  Console.println((int)esp_reset_reason());
+
+  taskstats_begin();  // CPU shares for `c`
 
   display_setup();    // Initialize display
   display_status();   // Show initial status on display
 
-  Serial.println("INIT:0:Display initialized");
+  Console.println("INIT:0:Display initialized");
 
   // Initialize radio module in FSK mode with specified parameters
   int radio_init_state = radio.beginFSK(current_tx_frequency,
@@ -66,8 +245,8 @@ void setup()
 
   if (radio_init_state != RADIOLIB_ERR_NONE)
   {
-    Serial.print("INIT:1:Radio initialization failed with code ");
-    Serial.println(radio_init_state);
+    Console.print("INIT:1:Radio initialization failed with code ");
+    Console.println(radio_init_state);
     panic();
   }
 
@@ -77,61 +256,155 @@ void setup()
   // Configure packet mode: 0 for variable length (required for streaming)
   int packet_mode_state = radio.fixedPacketLengthMode(0);
   if (packet_mode_state != RADIOLIB_ERR_NONE) {
-    Serial.print("INIT:1:Failed to set variable packet length mode, code ");
-    Serial.println(packet_mode_state);
+    Console.print("INIT:1:Failed to set variable packet length mode, code ");
+    Console.println(packet_mode_state);
     panic();
   }
 
-  Serial.println("INIT:0:Radio initialized successfully");
-}
+  Console.println("INIT:0:Radio initialized successfully");
 
-// Main loop, runs repeatedly
-void loop()
-{
-  // Check if ISR indicated FIFO has space AND there's data remaining for the current transmission
-  if (fifo_empty && current_tx_remaining_length > 0)
-  {
-    fifo_empty = false; // Reset ISR flag
+  // Register profiles saved by `r c` come back from NVS
+  profile_begin();
+  Console.print("INIT:0:");
+  Console.print(profile_count());
+  Console.println(" radio profiles loaded");
 
-    // radio.fifoAdd parameters:
-    // 1. tx_data_buffer: Pointer to the start of the complete data buffer.
-    // 2. current_tx_total_length: The total original length of the packet.
-    // 3. &current_tx_remaining_length: Pointer to the variable holding the remaining length.
-    //    RadioLib will read from tx_data_buffer at an offset calculated from total and remaining length.
-    //    It updates current_tx_remaining_length with the new remaining length.
-    // Returns true if the entire packet (all current_tx_total_length bytes) has been successfully loaded into the FIFO.
-    transmission_processing_complete = radio.fifoAdd(tx_data_buffer, current_tx_total_length, &current_tx_remaining_length);
+#ifdef CONSOLE_DATA_PORT
+  Console.print("INIT:0:Data port on UART");
+  Console.print(DATA_PORT_UART);
+  Console.print(" at ");
+  Console.print(DATA_PORT_BAUD);
+  Console.println(" baud");
+#endif
+
+  // The payload library is optional: without it only flash-backed commands are unavailable
+  if (library_begin())
+  {
+    Console.print("INIT:0:Payload library mapped with ");
+    Console.print(library_count());
+    Console.println(" entries");
   }
+  else
+  {
+    Console.println("INIT:0:No payload library found");
+  }
+}
 
-  if (transmission_processing_complete)
+// Radio side of a loop pass: listen-before-talk, FIFO refills, FLEX frames and heartbeats
+static void radio_loop()
+{
+  // Listen-before-talk: wait for a clear channel before starting a queued transmission
+  if (transmission_start_pending)
   {
-    transmission_processing_complete = false; // Reset flag for the next transmission cycle
+    lbt_result lbt = lbt_poll();
 
-    // radio_start_transmit_status holds the result from the initial radio.startTransmit() call.
-    if (radio_start_transmit_status == RADIOLIB_ERR_NONE)
+    if (lbt == LBT_CLEAR)
     {
-      Serial.println("TX:0:Transmission finished successfully!");
+      transmission_start_pending = false;
+      transmission_start();
     }
-    else
+    else if (lbt == LBT_BUSY)
     {
-      // This means radio.startTransmit() itself failed.
-      Serial.print("TX:1:Transmission failed to start, error code: ");
-      Serial.println(radio_start_transmit_status);
+      transmission_start_pending = false;
+      Console.println("TX:2:Channel busy, transmission abandoned");
+      dedup_disarm(); // Never went on air, so a retry may transmit it
+      transmission_finish(2);
     }
+  }
+
+  transmission_service();
+
+  // Emit the next FLEX frame once its boundary comes up
+  flex_loop();
+
+  // Tell the host we are alive, also while a packet is on air
+  heartbeat_loop();
+}
+
+// Lower the clock or sleep while nothing is happening, waking in time for
+// the next FLEX frame or heartbeat
+static void idle_until_deadline()
+{
+  int64_t deadline_us = flex_next_deadline_us(IDLE_WAKE_MARGIN_US);
+  int64_t heartbeat_us = heartbeat_next_deadline_us();
+  if (heartbeat_us >= 0 && (deadline_us < 0 || heartbeat_us < deadline_us))
+  {
+    deadline_us = heartbeat_us;
+  }
+  idle_loop(!console_loop_enable || transmission_start_pending, deadline_us);
+}
+
+#ifdef FIRMWARE_TASKS
+// ESP-IDF build (ttgo-lora32-v21-idf): Arduino is an ESP-IDF component and
+// app_main() replaces its loopTask. The tx task wakes on the FIFO interrupt
+// instead of waiting for a loop pass; the console task wakes on UART input.
+// Both work on the same transmission state, so each pass holds
+// firmware_lock.
+static void tx_task(void *)
+{
+  while (true)
+  {
+    ulTaskNotifyTake(pdTRUE, 1); // FIFO interrupt, a queued transmission, or the next tick
+
+    xSemaphoreTake(firmware_lock, portMAX_DELAY);
+    uint32_t start = micros();
+    radio_loop();
+    stats_record(stats_loop, micros() - start);
+    xSemaphoreGive(firmware_lock);
+  }
+}
+
+static void console_task(void *)
+{
+  console_uart.notify(xTaskGetCurrentTaskHandle());
 
-    // After transmission, put the radio in standby mode to stop transmitting/idling.
-    // Important for FSK mode on SX127x as it might not turn off the transmitter automatically.
-    radio.standby();
-    Serial.println("INIT:0:Radio set to standby mode.");
+  while (true)
+  {
+    ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(TASKS_CONSOLE_POLL_MS));
 
-    // Re-enable console for the next command and update the display.
-    console_loop_enable = true;
-    display_status(); // Update display (e.g., to show idle state, last status).
+    xSemaphoreTake(firmware_lock, portMAX_DELAY);
+    while (console_loop_enable && console_loop())
+    {
+    }
+    taskstats_loop();
+    idle_until_deadline();
+    xSemaphoreGive(firmware_lock);
   }
+}
+
+extern "C" void app_main()
+{
+  initArduino();
+  firmware_lock = xSemaphoreCreateMutex();
+  setup();
+
+  xTaskCreatePinnedToCore(tx_task, "tx", TASKS_TX_STACK, nullptr, TASKS_TX_PRIORITY, &tx_task_handle, 1);
+  xTaskCreatePinnedToCore(console_task, "console", TASKS_CONSOLE_STACK, nullptr, TASKS_CONSOLE_PRIORITY, nullptr, 1);
+}
+#else
+// Main loop, runs repeatedly
+void loop()
+{
+  uint32_t loop_start = micros();
+
+  radio_loop();
 
   // If console input is enabled, run the console loop to process commands.
+  bool command_processed = false;
   if (console_loop_enable)
   {
-    console_loop();
+    command_processed = console_loop();
+  }
+
+  // Command handling (uploads, provisioning) would swamp the loop timing
+  if (!command_processed)
+  {
+    stats_record(stats_loop, micros() - loop_start);
   }
-}
\ No newline at end of file
+
+  // Refresh per-task CPU and stack figures
+  taskstats_loop();
+
+  idle_until_deadline();
+}
+#endif
@@ -0,0 +1,184 @@
+#define RADIO_BOARD_AUTO
+
+#include <Preferences.h>
+#include <RadioLib.h>
+#include <RadioBoards.h>
+#include <string.h>
+
+#include "framing.h"
+#include "profile.h"
+#include "stats.h"
+
+// SX1276/77/78 FSK register map
+#define PROFILE_REG_FIRST 0x02        // BitrateMsb; OpMode (0x01) is left alone
+#define PROFILE_REG_FDEV_MSB 0x04
+#define PROFILE_REG_RX_CONFIG 0x0D    // bits 6:5 restart the receiver when set
+#define PROFILE_REG_PACKET_CONFIG_1 0x30
+#define PROFILE_REG_SEQ_CONFIG_1 0x36 // bits 7:6 start and stop the sequencer
+#define PROFILE_REG_IMAGE_CAL 0x3B    // bit 6 starts an image calibration
+#define PROFILE_REG_IRQ_FLAGS_1 0x3E  // IRQ flags, cleared by writing 1
+#define PROFILE_REG_IRQ_FLAGS_2 0x3F
+#define PROFILE_REG_PA_DAC 0x4D
+#define PROFILE_REG_BIT_RATE_FRAC 0x5D
+
+extern Radio radio;
+
+radio_profile profiles[PROFILE_SLOTS];
+
+static Preferences profile_store;
+
+static void profile_key(int slot, char *key)
+{
+    key[0] = 'p';
+    key[1] = '0' + slot;
+    key[2] = '\0';
+}
+
+// Loads the profiles saved in NVS; blobs of another layout are ignored
+void profile_begin()
+{
+    memset(profiles, 0, sizeof(profiles));
+
+    if (!profile_store.begin(PROFILE_NVS_NAMESPACE, false))
+    {
+        return;
+    }
+
+    for (int slot = 0; slot < PROFILE_SLOTS; slot++)
+    {
+        char key[3];
+        profile_key(slot, key);
+
+        radio_profile &profile = profiles[slot];
+        if (profile_store.getBytesLength(key) != sizeof(profile) ||
+            profile_store.getBytes(key, &profile, sizeof(profile)) != sizeof(profile) ||
+            profile.name[PROFILE_NAME_LENGTH] != '\0')
+        {
+            memset(&profile, 0, sizeof(profile));
+        }
+    }
+}
+
+int profile_count()
+{
+    int count = 0;
+    for (int slot = 0; slot < PROFILE_SLOTS; slot++)
+    {
+        count += profiles[slot].name[0] != '\0';
+    }
+    return count;
+}
+
+int profile_find(const char *name)
+{
+    for (int slot = 0; slot < PROFILE_SLOTS; slot++)
+    {
+        if (profiles[slot].name[0] != '\0' && strcmp(profiles[slot].name, name) == 0)
+        {
+            return slot;
+        }
+    }
+    return -1;
+}
+
+// Reads the live configuration into the profile of that name, or into a free
+// slot. Returns the slot, or -1 if all are taken.
+int profile_capture(const char *name, float frequency, float power)
+{
+    int slot = profile_find(name);
+    for (int i = 0; i < PROFILE_SLOTS && slot < 0; i++)
+    {
+        if (profiles[i].name[0] == '\0')
+        {
+            slot = i;
+        }
+    }
+
+    if (slot < 0)
+    {
+        return -1;
+    }
+
+    radio_profile &profile = profiles[slot];
+    Module *mod = radio.getMod();
+
+    mod->SPIreadRegisterBurst(PROFILE_REG_FIRST, PROFILE_BURST_LENGTH, profile.registers);
+    profile.pa_dac = mod->SPIreadRegister(PROFILE_REG_PA_DAC);
+    profile.bit_rate_frac = mod->SPIreadRegister(PROFILE_REG_BIT_RATE_FRAC);
+
+    // Trigger bits read back as 0 once done, but a capture mid-calibration must not replay them
+    profile.registers[PROFILE_REG_RX_CONFIG - PROFILE_REG_FIRST] &= ~0x60;
+    profile.registers[PROFILE_REG_SEQ_CONFIG_1 - PROFILE_REG_FIRST] &= ~0xC0;
+    profile.registers[PROFILE_REG_IMAGE_CAL - PROFILE_REG_FIRST] &= ~0x40;
+
+    // Writing 0 leaves the IRQ flags as they are
+    profile.registers[PROFILE_REG_IRQ_FLAGS_1 - PROFILE_REG_FIRST] = 0;
+    profile.registers[PROFILE_REG_IRQ_FLAGS_2 - PROFILE_REG_FIRST] = 0;
+
+    strncpy(profile.name, name, PROFILE_NAME_LENGTH);
+    profile.name[PROFILE_NAME_LENGTH] = '\0';
+    profile.frequency = frequency;
+    profile.power = power;
+
+    return slot;
+}
+
+bool profile_save(int slot)
+{
+    char key[3];
+    profile_key(slot, key);
+    return profile_store.putBytes(key, &profiles[slot], sizeof(profiles[slot])) == sizeof(profiles[slot]);
+}
+
+bool profile_erase(int slot)
+{
+    char key[3];
+    profile_key(slot, key);
+
+    memset(&profiles[slot], 0, sizeof(profiles[slot]));
+    return profile_store.remove(key);
+}
+
+// RadioLib keeps the frequency, bit rate and deviation it last set, for its
+// range checks and time-on-air. Passing the profile's values through its
+// setters keeps that state in line; the burst then overwrites anything they
+// rounded differently.
+static void profile_sync_radiolib(const radio_profile &profile)
+{
+    const uint8_t *bit_rate = profile.registers;  // BitrateMsb, BitrateLsb
+    const uint8_t *fdev_reg = &profile.registers[PROFILE_REG_FDEV_MSB - PROFILE_REG_FIRST];
+    float divider = (bit_rate[0] << 8 | bit_rate[1]) + (profile.bit_rate_frac & 0x0F) / 16.0f;
+    uint32_t fdev = (fdev_reg[0] & 0x3F) << 8 | fdev_reg[1];
+
+    // The bit rate goes first, as the deviation is checked against it
+    radio.setFrequency(profile.frequency);
+    radio.setBitRate(32000.0f / divider);
+    radio.setFrequencyDeviation(fdev * 32000.0f / (1 << 19));
+}
+
+// Writes the profile to the radio, which must be idle between packets, and
+// returns the time taken by the burst. Registers the chip treats as
+// read-only ignore the burst; the frequency takes effect as its last byte
+// (0x08) is written. Hardware framing (`h`) is a console setting rather than
+// part of the profile, so its bits are kept.
+uint32_t profile_apply(int slot)
+{
+    const radio_profile &profile = profiles[slot];
+    Module *mod = radio.getMod();
+
+    profile_sync_radiolib(profile);
+
+    uint32_t start = micros();
+    uint8_t image[PROFILE_BURST_LENGTH];
+    memcpy(image, profile.registers, sizeof(image));
+    image[PROFILE_REG_PACKET_CONFIG_1 - PROFILE_REG_FIRST] =
+        framing_packet_config(image[PROFILE_REG_PACKET_CONFIG_1 - PROFILE_REG_FIRST]);
+
+    mod->SPIwriteRegisterBurst(PROFILE_REG_FIRST, image, PROFILE_BURST_LENGTH);
+    mod->SPIwriteRegister(PROFILE_REG_PA_DAC, profile.pa_dac);
+    mod->SPIwriteRegister(PROFILE_REG_BIT_RATE_FRAC, profile.bit_rate_frac);
+    uint32_t elapsed = micros() - start;
+
+    stats_record(stats_profile_switch, elapsed);
+    return elapsed;
+}
@@ -0,0 +1,29 @@
+#pragma once
+
+#include <stdint.h>
+
+#include "defaults.h"
+
+// Complete SX127x FSK configuration captured from the chip: the registers
+// from BitrateMsb (0x02) to DioMapping2 (0x41), applied again in one burst,
+// plus the two settings outside that range. Frequency and power are kept for
+// the console and the display.
+struct radio_profile
+{
+    char name[PROFILE_NAME_LENGTH + 1];  // empty when the slot is free
+    float frequency;
+    float power;
+    uint8_t registers[PROFILE_BURST_LENGTH];
+    uint8_t pa_dac;
+    uint8_t bit_rate_frac;
+};
+
+extern radio_profile profiles[PROFILE_SLOTS];
+
+void profile_begin();
+int profile_count();
+int profile_find(const char *name);
+int profile_capture(const char *name, float frequency, float power);
+bool profile_save(int slot);
+bool profile_erase(int slot);
+uint32_t profile_apply(int slot);
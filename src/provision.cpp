@@ -0,0 +1,286 @@
+#include <Arduino.h>
+#include <esp_partition.h>
+#include <esp_rom_crc.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/queue.h>
+#include <freertos/semphr.h>
+#include <freertos/task.h>
+
+#include "console_port.h"
+#include "defaults.h"
+#include "heartbeat.h"
+#include "library.h"
+#include "provision.h"
+
+// Double buffer: one block is received while the writer task programs the other
+static uint8_t prov_buffer[2][PROV_BLOCK_SIZE];
+static uint32_t prov_buffer_length[2];
+static uint32_t prov_buffer_crc[2];
+
+static const esp_partition_t *prov_partition = nullptr;
+static uint32_t prov_offset = 0;
+static QueueHandle_t prov_queue = nullptr;           // Block numbers handed to the writer, -1 to stop
+static SemaphoreHandle_t prov_free_buffers = nullptr;
+static SemaphoreHandle_t prov_writer_done = nullptr;
+static volatile int prov_failed_block = -1;         // First block whose read-back did not match its CRC
+static volatile uint32_t prov_committed = 0;        // Partition offset up to which blocks are written and verified
+static const char *prov_error = nullptr;            // Why the transfer stopped early
+static int prov_error_block = 0;
+
+// Programs blocks and verifies them by reading them back while the next block
+// is still arriving. A page program stalls the flash cache for about 0.7 ms
+// typically and a few ms at worst, while at PROV_BAUD_MAX the 128-byte UART
+// FIFO fills in 0.64 ms, so bytes can be lost at high rates. A lost byte
+// fails the block CRC and the host resumes; provision_run reports the
+// overrun count so the rate can be picked from measurement.
+static void provision_writer(void *)
+{
+    int block;
+    uint8_t readback[256];
+
+    while (xQueueReceive(prov_queue, &block, portMAX_DELAY) == pdTRUE && block >= 0)
+    {
+        int slot = block % 2;
+        uint32_t address = prov_offset + block * PROV_BLOCK_SIZE;
+
+        esp_partition_write(prov_partition, address, prov_buffer[slot], prov_buffer_length[slot]);
+
+        uint32_t crc = 0;
+        for (uint32_t done = 0; done < prov_buffer_length[slot]; done += sizeof(readback))
+        {
+            uint32_t count = min((uint32_t)sizeof(readback), prov_buffer_length[slot] - done);
+            esp_partition_read(prov_partition, address + done, readback, count);
+            crc = esp_rom_crc32_le(crc, readback, count);
+        }
+
+        if (crc != prov_buffer_crc[slot] && prov_failed_block < 0)
+        {
+            prov_failed_block = block;
+        }
+
+        // Blocks arrive in order, so everything up to here is contiguous
+        if (prov_failed_block < 0)
+        {
+            prov_committed = address + prov_buffer_length[slot];
+        }
+
+        xSemaphoreGive(prov_free_buffers);
+    }
+
+    xSemaphoreGive(prov_writer_done);
+    vTaskDelete(nullptr);
+}
+
+// Reads `length` bytes, giving up after PROV_TIMEOUT_MS without progress.
+// Each read waits at most one heartbeat interval, so beats report the
+// `remaining` bytes of the image while the host is slow.
+static bool provision_read(uint8_t *buffer, size_t length, uint32_t remaining)
+{
+    size_t received = 0;
+    uint32_t last_ms = millis();
+
+    while (received < length)
+    {
+        size_t count = Console.readBytes(buffer + received, length - received);
+        received += count;
+
+        if (count > 0)
+        {
+            last_ms = millis();
+        }
+        else if (millis() - last_ms >= PROV_TIMEOUT_MS)
+        {
+            return false;
+        }
+
+        heartbeat_receiving(remaining > received ? remaining - received : 0);
+    }
+
+    return true;
+}
+
+static void provision_ack(int verified, int limit)
+{
+    Console.print("PROV:0:");
+    Console.print(verified);
+    Console.print(" ");
+    Console.print(limit);
+    Console.print(" ");
+    Console.println(prov_committed);
+}
+
+// Receives `size` bytes at `baud` and writes them to the payload partition
+// starting at `offset`. The host may keep PROV_WINDOW blocks in flight; each
+// "PROV:0:<verified> <limit> <committed>" line acknowledges blocks below
+// <verified>, allows sending blocks below <limit>, and reports the partition
+// offset up to which flash has been written and verified, where an
+// interrupted transfer can resume. Erasing stalls the UART interrupt, so
+// the window is drained and closed before each PROV_ERASE_SIZE erase.
+static int provision_receive(uint32_t size)
+{
+    int blocks = (size + PROV_BLOCK_SIZE - 1) / PROV_BLOCK_SIZE;
+    int received = 0;
+    int limit = 0;
+    uint32_t erased_until = prov_offset;
+
+    while (received < blocks)
+    {
+        // Every granted block has arrived: safe to erase ahead and open the window
+        if (received == limit)
+        {
+            uint32_t needed = prov_offset + min(received + PROV_WINDOW, blocks) * PROV_BLOCK_SIZE;
+
+            while (erased_until < needed)
+            {
+                uint32_t length = min((uint32_t)PROV_ERASE_SIZE - erased_until % PROV_ERASE_SIZE,
+                                      prov_partition->size - erased_until);
+                esp_partition_erase_range(prov_partition, erased_until, length);
+                erased_until += length;
+            }
+
+            int erased_blocks = (erased_until - prov_offset) / PROV_BLOCK_SIZE;
+            limit = min(min(received + PROV_WINDOW, blocks), erased_blocks);
+            provision_ack(received, limit);
+        }
+
+        int slot = received % 2;
+        uint32_t length = min((uint32_t)PROV_BLOCK_SIZE, size - received * PROV_BLOCK_SIZE);
+        uint32_t crc;
+
+        xSemaphoreTake(prov_free_buffers, portMAX_DELAY);
+
+        uint32_t remaining = size - received * PROV_BLOCK_SIZE;
+        if (!provision_read(prov_buffer[slot], length, remaining) ||
+            !provision_read((uint8_t *)&crc, sizeof(crc), remaining - length))
+        {
+            prov_error = "Timeout";
+            prov_error_block = received;
+            return received;
+        }
+
+        if (esp_rom_crc32_le(0, prov_buffer[slot], length) != crc)
+        {
+            prov_error = "CRC mismatch";
+            prov_error_block = received;
+            return received;
+        }
+
+        prov_buffer_length[slot] = length;
+        prov_buffer_crc[slot] = crc;
+        xQueueSend(prov_queue, &received, portMAX_DELAY);
+        received++;
+
+        // Grant the next block right away if it lies in already erased flash
+        uint32_t next_end = prov_offset + min(received + PROV_WINDOW, blocks) * PROV_BLOCK_SIZE;
+        if (received < blocks && limit < blocks && next_end <= erased_until)
+        {
+            limit = min(received + PROV_WINDOW, blocks);
+            provision_ack(received, limit);
+        }
+    }
+
+    return received;
+}
+
+void provision_run(uint32_t baud, uint32_t offset, uint32_t size)
+{
+    prov_partition = esp_partition_find_first(ESP_PARTITION_TYPE_DATA,
+                                              (esp_partition_subtype_t)LIBRARY_PARTITION_SUBTYPE,
+                                              LIBRARY_PARTITION_LABEL);
+
+    if (prov_partition == nullptr || baud == 0 || baud > PROV_BAUD_MAX || size == 0 ||
+        offset % PROV_BLOCK_SIZE != 0 || offset > prov_partition->size || size > prov_partition->size - offset)
+    {
+        Console.println("CONSOLE:9:Invalid parameter");
+        return;
+    }
+
+    Console.print("CONSOLE:0:Provisioning ");
+    Console.print(size);
+    Console.print(" bytes at ");
+    Console.print(baud);
+    Console.println(" baud");
+    Console.flush();
+
+    library_end();
+
+    prov_offset = offset;
+    prov_failed_block = -1;
+    prov_committed = offset;
+    prov_error = nullptr;
+    prov_queue = xQueueCreate(PROV_WINDOW, sizeof(int));
+    prov_free_buffers = xSemaphoreCreateCounting(2, 2);
+    prov_writer_done = xSemaphoreCreateBinary();
+    xTaskCreatePinnedToCore(provision_writer, "prov_writer", 4096, nullptr, 5, nullptr, 0);
+
+    console_set_baud(baud);
+    Console.setTimeout(heartbeat_read_timeout_ms(PROV_TIMEOUT_MS));
+    uint32_t overflows = console_overflows();
+
+    uint32_t start = millis();
+    int blocks = (size + PROV_BLOCK_SIZE - 1) / PROV_BLOCK_SIZE;
+    int received = provision_receive(size);
+
+    int stop = -1;
+    xQueueSend(prov_queue, &stop, portMAX_DELAY);
+    xSemaphoreTake(prov_writer_done, portMAX_DELAY);
+    uint32_t elapsed = millis() - start;
+    overflows = console_overflows() - overflows;
+
+    vQueueDelete(prov_queue);
+    vSemaphoreDelete(prov_free_buffers);
+    vSemaphoreDelete(prov_writer_done);
+
+    // Reported once the writer has stopped, so the resume offset is final
+    if (prov_failed_block >= 0)
+    {
+        prov_error = "Verify failed";
+        prov_error_block = prov_failed_block;
+    }
+
+    if (prov_error != nullptr)
+    {
+        // Discard the rest of the window so it does not reach the console as a command
+        Console.setTimeout(PROV_DRAIN_MS);
+        while (Console.readBytes(prov_buffer[0], PROV_BLOCK_SIZE) > 0)
+        {
+        }
+
+        Console.print("PROV:1:");
+        Console.print(prov_error);
+        Console.print(" at block ");
+        Console.print(prov_error_block);
+        Console.print(", ");
+        Console.print(overflows);
+        Console.print(" overruns, committed ");
+        Console.println(prov_committed);
+    }
+    else if (received == blocks)
+    {
+        Console.print("PROV:0:Wrote ");
+        Console.print(size);
+        Console.print(" bytes in ");
+        Console.print(elapsed);
+        Console.print(" ms, ");
+        Console.print(elapsed ? (uint32_t)((uint64_t)size * 1000 / elapsed) : 0);
+        Console.print(" bytes/s, ");
+        Console.print(overflows);
+        Console.println(" overruns");
+    }
+
+    Console.flush();
+    Console.setTimeout(1000);
+    console_set_baud(console_base_baud());
+    delay(50);
+
+    if (library_begin())
+    {
+        Console.print("CONSOLE:0:Provisioning complete, ");
+        Console.print(library_count());
+        Console.println(" library entries");
+    }
+    else
+    {
+        Console.println("CONSOLE:1:Provisioning ended without a valid library");
+    }
+}
@@ -0,0 +1,5 @@
+#pragma once
+
+#include <stdint.h>
+
+void provision_run(uint32_t baud, uint32_t offset, uint32_t size);
@@ -0,0 +1,105 @@
+#include <Arduino.h>
+
+#include "radio_hal.h"
+#include "stats.h"
+
+#define RADIO_SPI_HOST SPI3_HOST
+
+EspSpiHal::EspSpiHal(int sck, int miso, int mosi, uint32_t clock_hz)
+    : ArduinoHal(), pin_sck(sck), pin_miso(miso), pin_mosi(mosi), clock_hz(clock_hz)
+{
+}
+
+void EspSpiHal::spiBegin()
+{
+    spi_bus_config_t bus = {};
+    bus.sclk_io_num = pin_sck;
+    bus.miso_io_num = pin_miso;
+    bus.mosi_io_num = pin_mosi;
+    bus.quadwp_io_num = -1;
+    bus.quadhd_io_num = -1;
+    bus.max_transfer_sz = RADIO_SPI_DMA_CHUNK;
+
+    spi_device_interface_config_t dev = {};
+    dev.mode = 0;
+    dev.clock_speed_hz = clock_hz;
+    dev.spics_io_num = -1; // RadioLib drives NSS itself
+    dev.queue_size = RADIO_SPI_QUEUE_DEPTH;
+
+    ESP_ERROR_CHECK(spi_bus_initialize(RADIO_SPI_HOST, &bus, SPI_DMA_CH_AUTO));
+    ESP_ERROR_CHECK(spi_bus_add_device(RADIO_SPI_HOST, &dev, &device));
+}
+
+void EspSpiHal::spiBeginTransaction()
+{
+    // Holding the bus for the whole NSS-low window skips per-transfer arbitration
+    spi_device_acquire_bus(device, portMAX_DELAY);
+}
+
+void EspSpiHal::spiTransfer(uint8_t *out, size_t len, uint8_t *in)
+{
+    uint32_t start = micros();
+
+    if (len <= RADIO_SPI_POLLING_MAX)
+    {
+        spi_transaction_t t = {};
+        t.length = len * 8;
+        t.tx_buffer = out;
+        t.rx_buffer = in;
+        spi_device_polling_transmit(device, &t);
+    }
+    else
+    {
+        size_t queued = 0;
+        size_t offset = 0;
+
+        while (offset < len)
+        {
+            size_t chunk = len - offset;
+            if (chunk > RADIO_SPI_DMA_CHUNK)
+                chunk = RADIO_SPI_DMA_CHUNK;
+
+            spi_transaction_t &t = transactions[queued++];
+            t = {};
+            t.length = chunk * 8;
+            t.tx_buffer = out + offset;
+            t.rx_buffer = in ? in + offset : nullptr;
+            spi_device_queue_trans(device, &t, portMAX_DELAY);
+
+            offset += chunk;
+
+            if (queued == RADIO_SPI_QUEUE_DEPTH)
+            {
+                drain(queued);
+                queued = 0;
+            }
+        }
+
+        drain(queued);
+    }
+
+    stats_spi_bytes += len;
+    stats_record(stats_spi_transfer, micros() - start);
+}
+
+void EspSpiHal::drain(size_t queued)
+{
+    spi_transaction_t *done;
+
+    while (queued--)
+    {
+        spi_device_get_trans_result(device, &done, portMAX_DELAY);
+    }
+}
+
+void EspSpiHal::spiEndTransaction()
+{
+    spi_device_release_bus(device);
+}
+
+void EspSpiHal::spiEnd()
+{
+    spi_bus_remove_device(device);
+    spi_bus_free(RADIO_SPI_HOST);
+    device = nullptr;
+}
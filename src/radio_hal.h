@@ -0,0 +1,37 @@
+#pragma once
+
+#include <RadioLib.h>
+#include <driver/spi_master.h>
+
+#include "defaults.h"
+
+#if RADIO_SPI_CLOCK_HZ > RADIO_SPI_CLOCK_MAX_HZ
+#error "RADIO_SPI_CLOCK_HZ exceeds the SX127x SPI clock limit"
+#endif
+
+// RadioLib HAL for the SX127x that keeps Arduino GPIO and timing, but sends all
+// SPI traffic through the ESP-IDF SPI master driver. Short register accesses
+// are polled, bursts (FIFO refills, multi-register writes) are queued as DMA
+// transactions. Chip select stays under RadioLib's control via GPIO.
+class EspSpiHal : public ArduinoHal
+{
+public:
+    EspSpiHal(int sck, int miso, int mosi, uint32_t clock_hz);
+
+    void spiBegin() override;
+    void spiBeginTransaction() override;
+    void spiTransfer(uint8_t *out, size_t len, uint8_t *in) override;
+    void spiEndTransaction() override;
+    void spiEnd() override;
+
+private:
+    void drain(size_t queued);
+
+    int pin_sck;
+    int pin_miso;
+    int pin_mosi;
+    uint32_t clock_hz;
+
+    spi_device_handle_t device = nullptr;
+    spi_transaction_t transactions[RADIO_SPI_QUEUE_DEPTH];
+};
@@ -0,0 +1,4 @@
+#include "slots.h"
+
+uint8_t slot_data[SLOT_COUNT][SLOT_SIZE] = {{0}};  // Stored packet parts, referenced by gathered transmissions
+int slot_length[SLOT_COUNT] = {0};                  // Valid bytes per slot, 0 when empty
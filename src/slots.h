@@ -0,0 +1,8 @@
+#pragma once
+
+#include <stdint.h>
+
+#include "defaults.h"
+
+extern uint8_t slot_data[SLOT_COUNT][SLOT_SIZE];
+extern int slot_length[SLOT_COUNT];
@@ -0,0 +1,160 @@
+#include <Arduino.h>
+#include <freertos/FreeRTOS.h>
+
+#include "console_port.h"
+#include "stats.h"
+
+const uint32_t stats_hist_bounds_us[STATS_HIST_BUCKETS - 1] = {25, 50, 100, 200, 500, 1000, 2000};
+
+op_timing stats_fifo_refill = {0};
+op_timing stats_isr_refill = {0};
+op_timing stats_loop = {0};
+op_timing stats_reconfigure = {0};
+op_timing stats_spi_transfer = {0};
+op_timing stats_idle_wake = {0};
+op_timing stats_idle_command = {0};
+op_timing stats_console_read = {0};
+op_timing stats_profile_switch = {0};
+uint32_t stats_isr_refill_hist[STATS_HIST_BUCKETS] = {0};
+uint32_t stats_tx_underruns = 0;
+uint32_t stats_spi_bytes = 0;
+uint32_t stats_lbt_deferrals = 0;
+uint32_t stats_lbt_failures = 0;
+uint32_t stats_lbt_busy_ms = 0;
+uint32_t stats_flex_frames = 0;
+uint32_t stats_flex_pages = 0;
+uint32_t stats_flex_missed = 0;
+uint32_t stats_idle_ms = 0;
+volatile uint32_t stats_fifo_isr = 0;
+uint8_t stats_cpu_idle_pct = 0;
+uint8_t stats_cpu_loop_pct = 0;
+uint32_t stats_stack_min_free = 0;
+
+void stats_record(op_timing &timing, uint32_t elapsed_us)
+{
+    timing.count++;
+    timing.total_us += elapsed_us;
+
+    if (elapsed_us > timing.max_us)
+    {
+        timing.max_us = elapsed_us;
+    }
+}
+
+void stats_record_isr_refill(uint32_t latency_us)
+{
+    stats_record(stats_isr_refill, latency_us);
+
+    int bucket = 0;
+    while (bucket < STATS_HIST_BUCKETS - 1 && latency_us >= stats_hist_bounds_us[bucket])
+    {
+        bucket++;
+    }
+
+    stats_isr_refill_hist[bucket]++;
+}
+
+static void stats_print_timing(const char *name, const op_timing &timing)
+{
+    Console.print("STATS:0:");
+    Console.print(name);
+    Console.print(" count=");
+    Console.print(timing.count);
+    Console.print(" avg_us=");
+    Console.print(timing.count ? timing.total_us / timing.count : 0);
+    Console.print(" max_us=");
+    Console.println(timing.max_us);
+}
+
+void stats_report()
+{
+    stats_print_timing("loop", stats_loop);
+    stats_print_timing("fifo_refill", stats_fifo_refill);
+    stats_print_timing("isr_refill", stats_isr_refill);
+    stats_print_timing("reconfigure", stats_reconfigure);
+    stats_print_timing("spi_transfer", stats_spi_transfer);
+    stats_print_timing("idle_wake", stats_idle_wake);
+    stats_print_timing("idle_command", stats_idle_command);
+    stats_print_timing("console_read", stats_console_read);
+    stats_print_timing("profile_switch", stats_profile_switch);
+
+    Console.print("STATS:0:isr_refill_hist=");
+    for (int i = 0; i < STATS_HIST_BUCKETS; i++)
+    {
+        Console.print(stats_isr_refill_hist[i]);
+        Console.print(i < STATS_HIST_BUCKETS - 1 ? "/" : "\n");
+    }
+
+    Console.print("STATS:0:tx_underruns=");
+    Console.println(stats_tx_underruns);
+
+    Console.print("STATS:0:spi_bytes=");
+    Console.println(stats_spi_bytes);
+
+    Console.print("STATS:0:lbt deferrals=");
+    Console.print(stats_lbt_deferrals);
+    Console.print(" failures=");
+    Console.print(stats_lbt_failures);
+    Console.print(" busy_ms=");
+    Console.println(stats_lbt_busy_ms);
+
+    Console.print("STATS:0:flex frames=");
+    Console.print(stats_flex_frames);
+    Console.print(" pages=");
+    Console.print(stats_flex_pages);
+    Console.print(" missed=");
+    Console.println(stats_flex_missed);
+
+    Console.print("STATS:0:idle_ms=");
+    Console.println(stats_idle_ms);
+
+    Console.print("STATS:0:fifo_isr=");
+    Console.println(stats_fifo_isr);
+
+#ifdef CONSOLE_UART_DRIVER
+    Console.print("STATS:0:uart_overflows=");
+    Console.println(console_uart.overflows);
+#endif
+#ifdef CONSOLE_DATA_PORT
+    Console.print("STATS:0:data_overflows=");
+    Console.println(console_data.overflows);
+#endif
+
+    // Snapshot values from the last task statistics pass, not cleared by a reset
+    Console.print("STATS:0:tasks");
+#if configUSE_TRACE_FACILITY
+    Console.print(" idle_pct=");
+    Console.print(stats_cpu_idle_pct);
+    Console.print(" loop_pct=");
+    Console.print(stats_cpu_loop_pct);
+#endif
+    Console.print(" stack_min_free=");
+    Console.println(stats_stack_min_free);
+}
+
+void stats_reset()
+{
+    stats_fifo_refill = {0};
+    stats_isr_refill = {0};
+    stats_loop = {0};
+    for (int i = 0; i < STATS_HIST_BUCKETS; i++)
+    {
+        stats_isr_refill_hist[i] = 0;
+    }
+    stats_tx_underruns = 0;
+    stats_reconfigure = {0};
+    stats_spi_transfer = {0};
+    stats_idle_wake = {0};
+    stats_idle_command = {0};
+    stats_console_read = {0};
+    stats_profile_switch = {0};
+    stats_spi_bytes = 0;
+    stats_lbt_deferrals = 0;
+    stats_lbt_failures = 0;
+    stats_lbt_busy_ms = 0;
+    stats_flex_frames = 0;
+    stats_flex_pages = 0;
+    stats_flex_missed = 0;
+    stats_idle_ms = 0;
+    stats_fifo_isr = 0;
+}
@@ -0,0 +1,44 @@
+#pragma once
+
+#include <stdint.h>
+
+// Running timing for one kind of operation, in microseconds
+struct op_timing
+{
+    uint32_t count;
+    uint32_t total_us;
+    uint32_t max_us;
+};
+
+// Upper bounds of the ISR-to-refill latency histogram buckets; the last bucket is open-ended
+#define STATS_HIST_BUCKETS 8
+extern const uint32_t stats_hist_bounds_us[STATS_HIST_BUCKETS - 1];
+
+extern op_timing stats_fifo_refill;   // FIFO refills from the main loop
+extern op_timing stats_isr_refill;    // FIFO interrupt to start of the matching refill
+extern op_timing stats_loop;          // one pass of the main loop, or of the tx task in the ESP-IDF build
+extern op_timing stats_reconfigure;   // frequency / power changes from the console
+extern op_timing stats_spi_transfer;  // every SPI transaction issued by the radio HAL
+extern op_timing stats_idle_wake;     // restoring full speed after an idle period
+extern op_timing stats_idle_command;  // light sleep UART wake-up to the first command handled
+extern op_timing stats_console_read;  // console polls that returned a complete command line
+extern op_timing stats_profile_switch; // register profiles written to the radio
+extern uint32_t stats_isr_refill_hist[STATS_HIST_BUCKETS];
+extern uint32_t stats_tx_underruns;   // refills later after their FIFO interrupt than one byte on air
+extern uint32_t stats_spi_bytes;      // bytes clocked through the radio HAL
+extern uint32_t stats_lbt_deferrals;  // transmissions pushed back because the channel was busy
+extern uint32_t stats_lbt_failures;   // transmissions dropped after exhausting LBT attempts
+extern uint32_t stats_lbt_busy_ms;    // time spent waiting for a busy channel to clear
+extern uint32_t stats_flex_frames;    // FLEX frames transmitted
+extern uint32_t stats_flex_pages;     // FLEX pages carried by those frames
+extern uint32_t stats_flex_missed;    // FLEX frames pushed to the next cycle because the radio was busy
+extern uint32_t stats_idle_ms;        // time spent at reduced clock or in light sleep
+extern volatile uint32_t stats_fifo_isr; // FIFO interrupts taken
+extern uint8_t stats_cpu_idle_pct;    // share of both cores spent idle over the last task snapshot window
+extern uint8_t stats_cpu_loop_pct;    // share of one core used by the main loop task (tx and console tasks in the ESP-IDF build) over that window
+extern uint32_t stats_stack_min_free; // smallest stack high-water mark of any task at that snapshot, in bytes
+
+void stats_record(op_timing &timing, uint32_t elapsed_us);
+void stats_record_isr_refill(uint32_t latency_us);
+void stats_report();
+void stats_reset();
@@ -0,0 +1,278 @@
+#include <Arduino.h>
+#include <esp_freertos_hooks.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+
+#include "console_port.h"
+#include "defaults.h"
+#include "stats.h"
+#include "taskstats.h"
+
+// One task as seen by the last snapshot. Names are copied because tasks
+// such as the provisioning writer may be deleted before the next report.
+struct task_sample
+{
+    char name[configMAX_TASK_NAME_LEN];
+    UBaseType_t number;
+    UBaseType_t priority;
+    uint32_t stack_free;
+    uint32_t runtime;
+    uint8_t cpu_pct;
+};
+
+static task_sample task_samples[TASKSTATS_MAX_TASKS];
+static int task_sample_count = 0;
+static uint32_t snapshot_total_runtime = 0;
+static uint32_t snapshot_window_ms = 0;
+static uint32_t snapshot_fifo_isr = 0;
+static uint32_t snapshot_fifo_isr_per_s = 0;
+static uint32_t snapshot_ms = 0;
+
+#if configUSE_TRACE_FACILITY
+static TaskStatus_t task_status[TASKSTATS_MAX_TASKS];
+#endif
+
+#if configGENERATE_RUN_TIME_STATS && configUSE_TRACE_FACILITY
+// Run time of the task with the given number in the previous snapshot, or 0 if it is new
+static uint32_t previous_runtime(UBaseType_t number)
+{
+    for (int i = 0; i < task_sample_count; i++)
+    {
+        if (task_samples[i].number == number)
+        {
+            return task_samples[i].runtime;
+        }
+    }
+
+    return 0;
+}
+#elif configUSE_TRACE_FACILITY
+// The stock Arduino-ESP32 framework has no run-time counters, so CPU shares
+// are sampled instead: on every tick, each core counts the task it
+// interrupted. A task that wakes on the tick and blocks again before the
+// next one is undercounted.
+struct tick_count
+{
+    TaskHandle_t task;
+    uint32_t ticks;
+};
+
+static tick_count tick_counts[TASKSTATS_MAX_TASKS];
+static tick_count tick_window[TASKSTATS_MAX_TASKS]; // Counts taken by the last snapshot
+static int tick_count_used = 0;
+static int tick_window_used = 0;
+static uint32_t tick_total = 0;                     // Ticks sampled, summed over both cores
+static portMUX_TYPE tick_lock = portMUX_INITIALIZER_UNLOCKED;
+
+static void IRAM_ATTR taskstats_tick()
+{
+    TaskHandle_t task = xTaskGetCurrentTaskHandle();
+
+    portENTER_CRITICAL_ISR(&tick_lock);
+    tick_total++;
+
+    int i = 0;
+    while (i < tick_count_used && tick_counts[i].task != task)
+    {
+        i++;
+    }
+
+    if (i == tick_count_used && tick_count_used < TASKSTATS_MAX_TASKS)
+    {
+        tick_counts[i].task = task;
+        tick_counts[i].ticks = 0;
+        tick_count_used++;
+    }
+
+    if (i < tick_count_used)
+    {
+        tick_counts[i].ticks++;
+    }
+    portEXIT_CRITICAL_ISR(&tick_lock);
+}
+
+// Moves the counts since the previous snapshot into tick_window and returns
+// the ticks one core saw in that time
+static uint32_t take_ticks()
+{
+    portENTER_CRITICAL(&tick_lock);
+    memcpy(tick_window, tick_counts, tick_count_used * sizeof(tick_count));
+    tick_window_used = tick_count_used;
+    uint32_t total = tick_total;
+    tick_count_used = 0;
+    tick_total = 0;
+    portEXIT_CRITICAL(&tick_lock);
+
+    return total / portNUM_PROCESSORS;
+}
+
+// Ticks the given task was sampled running in the last window
+static uint32_t window_ticks(TaskHandle_t task)
+{
+    for (int i = 0; i < tick_window_used; i++)
+    {
+        if (tick_window[i].task == task)
+        {
+            return tick_window[i].ticks;
+        }
+    }
+
+    return 0;
+}
+#endif
+
+// Starts sampling CPU shares when the framework has no run-time counters
+void taskstats_begin()
+{
+#if !configGENERATE_RUN_TIME_STATS && configUSE_TRACE_FACILITY
+    for (int cpu = 0; cpu < portNUM_PROCESSORS; cpu++)
+    {
+        esp_register_freertos_tick_hook_for_cpu(taskstats_tick, cpu);
+    }
+#endif
+}
+
+#if configUSE_TRACE_FACILITY
+// The tasks that stand in for the Arduino main loop
+static bool main_task(const char *name)
+{
+#ifdef FIRMWARE_TASKS
+    return strcmp(name, "tx") == 0 || strcmp(name, "console") == 0;
+#else
+    return strcmp(name, "loopTask") == 0;
+#endif
+}
+#endif
+
+// Takes a snapshot now; CPU shares cover the window since the previous one
+void taskstats_snapshot()
+{
+    uint32_t now_ms = millis();
+    uint32_t fifo_isr = stats_fifo_isr;
+    uint32_t fifo_isr_window = fifo_isr >= snapshot_fifo_isr ? fifo_isr - snapshot_fifo_isr : fifo_isr; // counters reset by 's 1'
+
+    snapshot_window_ms = now_ms - snapshot_ms;
+    snapshot_fifo_isr_per_s = snapshot_window_ms ? (uint64_t)fifo_isr_window * 1000 / snapshot_window_ms : 0;
+    snapshot_fifo_isr = fifo_isr;
+    snapshot_ms = now_ms;
+
+#if configUSE_TRACE_FACILITY
+    uint32_t total_runtime = 0;
+    int count = uxTaskGetSystemState(task_status, TASKSTATS_MAX_TASKS, &total_runtime);
+#if configGENERATE_RUN_TIME_STATS
+    uint32_t window = total_runtime - snapshot_total_runtime;
+#else
+    uint32_t window = take_ticks();
+#endif
+    uint32_t idle_runtime = 0;
+    uint32_t min_stack_free = UINT32_MAX;
+    uint8_t cpu_pct[TASKSTATS_MAX_TASKS];
+    uint32_t loop_pct = 0;
+
+    // Compute shares against the previous samples before overwriting them
+    for (int i = 0; i < count; i++)
+    {
+        TaskStatus_t &status = task_status[i];
+#if configGENERATE_RUN_TIME_STATS
+        uint32_t runtime = status.ulRunTimeCounter - previous_runtime(status.xTaskNumber);
+#else
+        uint32_t runtime = window_ticks(status.xHandle);
+#endif
+
+        if (strncmp(status.pcTaskName, "IDLE", 4) == 0)
+        {
+            idle_runtime += runtime;
+        }
+
+        if (status.usStackHighWaterMark < min_stack_free)
+        {
+            min_stack_free = status.usStackHighWaterMark;
+        }
+
+        cpu_pct[i] = window ? (uint64_t)runtime * 100 / window : 0;
+    }
+
+    for (int i = 0; i < count; i++)
+    {
+        TaskStatus_t &status = task_status[i];
+        task_sample &sample = task_samples[i];
+
+        strncpy(sample.name, status.pcTaskName, sizeof(sample.name) - 1);
+        sample.name[sizeof(sample.name) - 1] = '\0';
+        sample.number = status.xTaskNumber;
+        sample.priority = status.uxCurrentPriority;
+        sample.stack_free = status.usStackHighWaterMark;
+        sample.runtime = status.ulRunTimeCounter;
+        sample.cpu_pct = cpu_pct[i];
+
+        if (main_task(sample.name))
+        {
+            loop_pct += sample.cpu_pct;
+        }
+    }
+
+    stats_cpu_loop_pct = loop_pct;
+
+    task_sample_count = count;
+    snapshot_total_runtime = total_runtime;
+    stats_cpu_idle_pct = window ? (uint64_t)idle_runtime * 100 / ((uint64_t)window * portNUM_PROCESSORS) : 0;
+    stats_stack_min_free = min_stack_free;
+#else
+    // Without the trace facility only the main loop task can be inspected
+    task_sample &sample = task_samples[0];
+
+    strcpy(sample.name, "loopTask");
+    sample.number = 0;
+    sample.priority = uxTaskPriorityGet(NULL);
+    sample.stack_free = uxTaskGetStackHighWaterMark(NULL);
+    sample.runtime = 0;
+    sample.cpu_pct = 0;
+
+    task_sample_count = 1;
+    stats_stack_min_free = sample.stack_free;
+#endif
+}
+
+// Refreshes the snapshot every TASKSTATS_INTERVAL_MS
+void taskstats_loop()
+{
+    if (millis() - snapshot_ms >= TASKSTATS_INTERVAL_MS)
+    {
+        taskstats_snapshot();
+    }
+}
+
+void taskstats_report()
+{
+    for (int i = 0; i < task_sample_count; i++)
+    {
+        task_sample &sample = task_samples[i];
+
+        Console.print("TASKS:0:");
+        Console.print(sample.name);
+        Console.print(" prio=");
+        Console.print(sample.priority);
+#if configUSE_TRACE_FACILITY
+        Console.print(" cpu_pct=");
+        Console.print(sample.cpu_pct);
+#endif
+        Console.print(" stack_free=");
+        Console.println(sample.stack_free);
+    }
+
+    Console.print("TASKS:0:window_ms=");
+    Console.print(snapshot_window_ms);
+#if configGENERATE_RUN_TIME_STATS
+    Console.print(" cpu=counters");
+#elif configUSE_TRACE_FACILITY
+    Console.print(" cpu=ticks");
+#endif
+#if configUSE_TRACE_FACILITY
+    Console.print(" idle_pct=");
+    Console.print(stats_cpu_idle_pct);
+#endif
+    Console.print(" fifo_isr=");
+    Console.print(snapshot_fifo_isr);
+    Console.print(" fifo_isr_per_s=");
+    Console.println(snapshot_fifo_isr_per_s);
+}
@@ -0,0 +1,6 @@
+#pragma once
+
+void taskstats_begin();
+void taskstats_loop();
+void taskstats_snapshot();
+void taskstats_report();
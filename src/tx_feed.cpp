@@ -0,0 +1,195 @@
+#define RADIO_BOARD_AUTO
+
+#include <RadioLib.h>
+#include <RadioBoards.h>
+#include <fsk_codec.h>
+#include <string.h>
+
+#include "defaults.h"
+#include "stats.h"
+#include "tx_feed.h"
+
+#define TX_REG_BITRATE_MSB 0x02
+#define TX_REG_BIT_RATE_FRAC 0x5D // bits 3:0, sixteenths of the bit rate divider
+
+extern Radio radio;
+
+// Ordered list of pieces that make up the current packet. The FIFO is filled
+// straight from these, so the packet never has to exist in one buffer.
+static tx_segment tx_segments[TX_MAX_SEGMENTS];
+static int tx_segment_count = 0;
+
+// Software PN9 whitening of everything handed to the radio, for packets the
+// packet engine cannot frame (see framing_prepare)
+static bool tx_whitening = false;
+
+// Contiguous copy of the packet start for radio.startTransmit(), used only
+// when the first segment is too short to provide it directly
+static uint8_t tx_head_staging[RADIOLIB_SX127X_MAX_PACKET_LENGTH_FSK];
+
+// Air time of one byte at the bit rate of the current transmission
+static uint32_t tx_byte_us = 0;
+
+void tx_feed_single(const uint8_t *data, int length)
+{
+    tx_segments[0] = {data, length};
+    tx_segment_count = 1;
+    tx_whitening = false;
+}
+
+// Adds a piece to the end of the segment list started by tx_feed_single()
+bool tx_feed_append(const uint8_t *data, int length)
+{
+    if (tx_segment_count >= TX_MAX_SEGMENTS)
+    {
+        return false;
+    }
+
+    tx_segments[tx_segment_count++] = {data, length};
+    return true;
+}
+
+int tx_feed_total()
+{
+    int total = 0;
+
+    for (int i = 0; i < tx_segment_count; i++)
+    {
+        total += tx_segments[i].length;
+    }
+
+    return total;
+}
+
+// CRC of the packet as the SX127x packet engine would append it
+uint16_t tx_feed_crc16(bool ibm)
+{
+    uint16_t crc = codec_crc16_init(ibm);
+
+    for (int i = 0; i < tx_segment_count; i++)
+    {
+        crc = codec_crc16_update(crc, tx_segments[i].data, tx_segments[i].length, ibm);
+    }
+
+    return codec_crc16_final(crc, ibm);
+}
+
+// Whitens the current packet on its way to the FIFO. Cleared by tx_feed_single().
+void tx_feed_whiten(bool enable)
+{
+    tx_whitening = enable;
+}
+
+// Copies packet bytes [offset, offset + length) to `dest`, or writes them
+// straight into the radio FIFO when `dest` is null
+static void tx_feed_walk(int offset, int length, uint8_t *dest)
+{
+    Module *mod = radio.getMod();
+    uint8_t whitened[RADIOLIB_SX127X_FIFO_THRESH];
+    int position = offset;
+
+    for (int i = 0; i < tx_segment_count && length > 0; i++)
+    {
+        const tx_segment &segment = tx_segments[i];
+
+        if (offset >= segment.length)
+        {
+            offset -= segment.length;
+            continue;
+        }
+
+        int count = segment.length - offset;
+        if (count > length)
+        {
+            count = length;
+        }
+
+        if (dest != nullptr)
+        {
+            memcpy(dest, segment.data + offset, count);
+            if (tx_whitening)
+            {
+                codec_pn9_apply(dest, count, position);
+            }
+            dest += count;
+        }
+        else if (tx_whitening)
+        {
+            // Refills are at most FIFO_THRESH - 1 bytes, so one staging pass per segment
+            memcpy(whitened, segment.data + offset, count);
+            codec_pn9_apply(whitened, count, position);
+            mod->SPIwriteRegisterBurst(RADIOLIB_SX127X_REG_FIFO, whitened, count);
+        }
+        else
+        {
+            mod->SPIwriteRegisterBurst(RADIOLIB_SX127X_REG_FIFO, segment.data + offset, count);
+        }
+
+        position += count;
+        length -= count;
+        offset = 0;
+    }
+}
+
+// Returns the first `length` bytes of the packet as one contiguous block,
+// which is what radio.startTransmit() loads into the FIFO up front.
+const uint8_t *tx_feed_head(int length)
+{
+    if (length > RADIOLIB_SX127X_MAX_PACKET_LENGTH_FSK)
+    {
+        length = RADIOLIB_SX127X_MAX_PACKET_LENGTH_FSK;
+    }
+
+    if (tx_segment_count > 0 && tx_segments[0].length >= length && !tx_whitening)
+    {
+        return tx_segments[0].data;
+    }
+
+    tx_feed_walk(0, length, tx_head_staging);
+    return tx_head_staging;
+}
+
+// Reads the bit rate back from the chip before a transmission, so underrun
+// detection follows `r m` and `r a`. The bit rate is 32 MHz divided by
+// BitRate + BitRateFrac / 16, which makes one byte (BitRate * 16 + Frac) / 64 us.
+void tx_feed_read_bitrate()
+{
+    Module *mod = radio.getMod();
+    uint8_t divider[2];
+
+    mod->SPIreadRegisterBurst(TX_REG_BITRATE_MSB, 2, divider);
+    uint32_t frac = mod->SPIreadRegister(TX_REG_BIT_RATE_FRAC) & 0x0F;
+    tx_byte_us = (((uint32_t)divider[0] << 8 | divider[1]) * 16 + frac) / 64;
+}
+
+// Tops up the FIFO from the segment list. Follows the bookkeeping of
+// radio.fifoAdd(): the chunk written by the previous call is subtracted first,
+// and true is returned once everything has been handed to the radio.
+// latency_us is the time since the FIFO interrupt that asked for this refill.
+bool tx_feed_refill(int total_length, int *remaining_length, uint32_t latency_us)
+{
+    // The interrupt fires on FifoEmpty, when only the byte in the shift
+    // register is left. The first refill follows startTransmit(), not an
+    // interrupt, so the FIFO is still full then.
+    if (*remaining_length < total_length && latency_us > tx_byte_us)
+    {
+        stats_tx_underruns++;
+    }
+
+    *remaining_length -= RADIOLIB_SX127X_FIFO_THRESH - 1;
+
+    if (*remaining_length <= 0)
+    {
+        return true;
+    }
+
+    int length = *remaining_length;
+    if (length > RADIOLIB_SX127X_FIFO_THRESH - 1)
+    {
+        length = RADIOLIB_SX127X_FIFO_THRESH - 1;
+    }
+
+    tx_feed_walk(total_length - *remaining_length, length, nullptr);
+
+    return false;
+}
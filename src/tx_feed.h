@@ -0,0 +1,19 @@
+#pragma once
+
+#include <stdint.h>
+
+// One contiguous piece of the packet being transmitted
+struct tx_segment
+{
+    const uint8_t *data;
+    int length;
+};
+
+void tx_feed_single(const uint8_t *data, int length);
+bool tx_feed_append(const uint8_t *data, int length);
+int tx_feed_total();
+uint16_t tx_feed_crc16(bool ibm);
+void tx_feed_whiten(bool enable);
+const uint8_t *tx_feed_head(int length);
+void tx_feed_read_bitrate();
+bool tx_feed_refill(int total_length, int *remaining_length, uint32_t latency_us);
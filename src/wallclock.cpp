@@ -0,0 +1,24 @@
+#include <esp_timer.h>
+
+#include "wallclock.h"
+
+static int64_t wallclock_offset_us = 0; // Unix time minus esp_timer time, in microseconds
+static bool wallclock_valid = false;
+
+bool wallclock_synced()
+{
+    return wallclock_valid;
+}
+
+// Aligns the wall clock to the given Unix time in milliseconds. Serial latency
+// is not compensated, so the host should send the time it expects on arrival.
+void wallclock_set_ms(uint64_t epoch_ms)
+{
+    wallclock_offset_us = (int64_t)epoch_ms * 1000 - esp_timer_get_time();
+    wallclock_valid = true;
+}
+
+int64_t wallclock_now_us()
+{
+    return esp_timer_get_time() + wallclock_offset_us;
+}
@@ -0,0 +1,7 @@
+#pragma once
+
+#include <stdint.h>
+
+bool wallclock_synced();
+void wallclock_set_ms(uint64_t epoch_ms);
+int64_t wallclock_now_us();
@@ -0,0 +1,132 @@
+// Unity suite for the fsk_codec kernels, run natively (pio test -e native)
+// and on the board (pio test -e ttgo-lora32-v21). Uses the same golden
+// vectors as the host ctest and the device `b` command.
+
+#include <string.h>
+#include <unity.h>
+
+#include <fsk_codec_bulk.h>
+#include <fsk_codec_vectors.h>
+
+#ifdef ARDUINO
+#include <Arduino.h>
+#endif
+
+static uint8_t input[1024];
+
+void setUp()
+{
+    uint32_t state = 1;
+    for (size_t i = 0; i < sizeof(input); i++)
+    {
+        state = state * 1103515245 + 12345;
+        input[i] = state >> 16;
+    }
+}
+
+void tearDown()
+{
+}
+
+static void test_crc16()
+{
+    TEST_ASSERT_EQUAL_HEX16(CODEC_VECTOR_CRC_CCITT, codec_crc16(codec_vector_check, sizeof(codec_vector_check), false));
+    TEST_ASSERT_EQUAL_HEX16(CODEC_VECTOR_CRC_IBM, codec_crc16(codec_vector_check, sizeof(codec_vector_check), true));
+}
+
+static void test_pn9()
+{
+    uint8_t pn9[sizeof(codec_vector_pn9)] = {0};
+    codec_pn9_apply(pn9, sizeof(pn9), 0);
+    TEST_ASSERT_EQUAL_HEX8_ARRAY(codec_vector_pn9, pn9, sizeof(pn9));
+}
+
+static void test_bch3121()
+{
+    for (int i = 0; i < CODEC_VECTOR_BCH_COUNT; i++)
+    {
+        TEST_ASSERT_EQUAL_HEX32(codec_vector_bch_words[i], codec_bch3121_encode(codec_vector_bch_data[i]));
+        TEST_ASSERT_TRUE(codec_bch3121_valid(codec_vector_bch_words[i]));
+    }
+    TEST_ASSERT_FALSE(codec_bch3121_valid(codec_vector_bch_words[0] ^ 0x100));
+}
+
+static void test_manchester()
+{
+    uint8_t out[sizeof(codec_vector_manchester_out)];
+    codec_manchester_encode(codec_vector_manchester_in, sizeof(codec_vector_manchester_in), out);
+    TEST_ASSERT_EQUAL_HEX8_ARRAY(codec_vector_manchester_out, out, sizeof(out));
+}
+
+static void test_interleave8()
+{
+    uint8_t out[32];
+    uint32_t words[8];
+    codec_interleave8(codec_vector_interleave_in, out);
+    codec_deinterleave8(out, words);
+    TEST_ASSERT_EQUAL_HEX8_ARRAY(codec_vector_interleave_out, out, sizeof(out));
+    TEST_ASSERT_EQUAL_HEX32_ARRAY(codec_vector_interleave_in, words, 8);
+
+    codec_interleave8_bulk(codec_vector_interleave_in, 1, out);
+    TEST_ASSERT_EQUAL_HEX8_ARRAY(codec_vector_interleave_out, out, sizeof(out));
+}
+
+// Odd lengths and offsets exercise the scalar tails of the bulk loops
+static void test_bulk_matches_scalar()
+{
+    static uint8_t scalar[2 * sizeof(input)];
+    static uint8_t bulk[2 * sizeof(input)];
+    const size_t lengths[] = {0, 1, 15, 16, 17, 511, 1000};
+    const size_t offsets[] = {0, 7, 510, 1023};
+
+    for (size_t length : lengths)
+    {
+        for (size_t offset : offsets)
+        {
+            memcpy(scalar, input, length);
+            memcpy(bulk, input, length);
+            codec_pn9_apply(scalar, length, offset);
+            codec_pn9_apply_bulk(bulk, length, offset);
+            TEST_ASSERT_EQUAL_MEMORY(scalar, bulk, length);
+        }
+
+        for (int ibm = 0; ibm < 2; ibm++)
+        {
+            TEST_ASSERT_EQUAL_HEX16(codec_crc16_update(codec_crc16_init(ibm), input, length, ibm),
+                                    codec_crc16_update_bulk(codec_crc16_init(ibm), input, length, ibm));
+        }
+
+        codec_manchester_encode(input, length, scalar);
+        codec_manchester_encode_bulk(input, length, bulk);
+        TEST_ASSERT_EQUAL_MEMORY(scalar, bulk, 2 * length);
+    }
+}
+
+static int run_tests()
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_crc16);
+    RUN_TEST(test_pn9);
+    RUN_TEST(test_bch3121);
+    RUN_TEST(test_manchester);
+    RUN_TEST(test_interleave8);
+    RUN_TEST(test_bulk_matches_scalar);
+    return UNITY_END();
+}
+
+#ifdef ARDUINO
+void setup()
+{
+    delay(2000); // the test runner opens the port after the reset
+    run_tests();
+}
+
+void loop()
+{
+}
+#else
+int main()
+{
+    return run_tests();
+}
+#endif